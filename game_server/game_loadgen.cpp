@@ -0,0 +1,266 @@
+// game_loadgen.cpp - game_server の負荷試験クライアント
+// 多数の対局を同時に進め（人間側はランダムな合法手を即座に打つ）、AI の応答時間の分布と処理量を測る。
+// 1スレッドの epoll で全接続を回す。Linux 専用。
+// ビルド: clang++ -std=c++17 -O2 -pthread game_loadgen.cpp -o game_loadgen
+// 例: ./game_loadgen --port 7777 --conns 50 --games 40 --total 20000 --kind mix
+//
+// オプション:
+//   --port <n> / --unix <path>   接続先（既定 127.0.0.1:7777）
+//   --conns <n>     接続数（既定 50）
+//   --games <n>     1接続あたりの同時対局数（既定 20。同時対局数は conns*games）
+//   --total <n>     終える対局数（既定 conns*games*2）
+//   --kind reversi|ttt|mix   対局の種類（mix は交互。既定 reversi）
+//   --budget <ms>   AI の 1局ぶんの持ち時間（既定はサーバの値）
+//   --seed <n>      着手の乱数の種
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../reversi_core/game_state.hpp"
+#include "../reversi_core/search.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct ClientGame {
+    bool reversi = true;
+    char me = BLACK;
+    GameState rv;
+    char ttt[9] = {};
+    Clock::time_point sent;  // 手を送った（AI に手番が回った）時刻
+};
+
+struct Client {
+    uint32_t idx;
+    int fd;
+    std::string in, out;
+    std::deque<bool> pendingNew;   // 応答待ちの new（reversi か）。応答は送った順に来る
+    std::unordered_map<uint32_t, ClientGame> games;
+};
+
+class LoadGen {
+public:
+    int conns = 50, perConn = 20;
+    long total = 0;
+    std::string kind = "reversi", budget;
+    std::mt19937_64 rng{12345};
+
+    int run(int port, const std::string& unixPath) {
+        if (total <= 0) total = (long)conns * perConn * 2;
+        ep = epoll_create1(0);
+        for (int i = 0; i < conns; ++i) {
+            int fd = unixPath.empty() ? connectTcp(port) : connectUnix(unixPath);
+            if (fd < 0) { std::perror("connect"); return 1; }
+            clients.emplace_back(new Client{(uint32_t)i, fd, "", "", {}, {}});
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u32 = (uint32_t)i;
+            epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+        }
+        start = Clock::now();
+        for (auto& c : clients)
+            for (int g = 0; g < perConn && started < total; ++g) startGame(*c);
+        for (auto& c : clients) flush(*c);
+
+        std::vector<epoll_event> evs(1024);
+        while (finished < total) {
+            int n = epoll_wait(ep, evs.data(), (int)evs.size(), 1000);
+            if (n < 0) { if (errno == EINTR) continue; break; }
+            for (int i = 0; i < n; ++i) {
+                Client& c = *clients[evs[i].data.u32];
+                if (evs[i].events & EPOLLIN) readClient(c);
+                if (evs[i].events & EPOLLOUT) flush(c);
+                if (evs[i].events & (EPOLLHUP | EPOLLERR)) { std::fprintf(stderr, "server closed the connection\n"); return 1; }
+            }
+            if (n == 0) std::fprintf(stderr, "  %ld / %ld games, %zu moves\n", finished, total, latencies.size());
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - start).count();
+        report(secs);
+        return errors ? 1 : 0;
+    }
+
+private:
+    int ep = -1;
+    std::vector<std::unique_ptr<Client>> clients;
+    long started = 0, finished = 0, errors = 0, wins = 0, losses = 0, draws = 0;
+    std::vector<double> latencies; // ms
+    Clock::time_point start;
+    std::string serverStats;
+
+    static int connectTcp(int port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in a{};
+        a.sin_family = AF_INET;
+        a.sin_port = htons((uint16_t)port);
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || connect(fd, (sockaddr*)&a, sizeof(a)) < 0) return -1;
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        return fd;
+    }
+    static int connectUnix(const std::string& path) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un a{};
+        a.sun_family = AF_UNIX;
+        std::strncpy(a.sun_path, path.c_str(), sizeof(a.sun_path) - 1);
+        if (fd < 0 || connect(fd, (sockaddr*)&a, sizeof(a)) < 0) return -1;
+        return fd;
+    }
+
+    void send(Client& c, const std::string& line) { c.out += line; c.out += '\n'; }
+
+    // 送れるだけ送り、残りがあれば EPOLLOUT を待つ（接続はブロッキングなので MSG_DONTWAIT で送る）
+    void flush(Client& c) {
+        while (!c.out.empty()) {
+            ssize_t w = ::send(c.fd, c.out.data(), c.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (w <= 0) break;
+            c.out.erase(0, (size_t)w);
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | (c.out.empty() ? 0u : (uint32_t)EPOLLOUT);
+        ev.data.u32 = c.idx;
+        epoll_ctl(ep, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+
+    void startGame(Client& c) {
+        bool rev = kind == "reversi" || (kind == "mix" && started % 2 == 0);
+        ++started;
+        c.pendingNew.push_back(rev);
+        send(c, std::string("new ") + (rev ? "reversi" : "ttt") + (budget.empty() ? "" : " budget " + budget));
+    }
+
+    void readClient(Client& c) {
+        char buf[65536];
+        ssize_t r = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (r <= 0) return;
+        c.in.append(buf, (size_t)r);
+        size_t pos = 0, nl;
+        while ((nl = c.in.find('\n', pos)) != std::string::npos) {
+            handle(c, c.in.substr(pos, nl - pos));
+            pos = nl + 1;
+        }
+        c.in.erase(0, pos);
+        flush(c);
+    }
+
+    void handle(Client& c, const std::string& line) {
+        std::istringstream in(line);
+        std::string cmd;
+        uint32_t id = 0;
+        in >> cmd >> id;
+        if (cmd == "game") {
+            ClientGame g;
+            g.reversi = c.pendingNew.front();
+            c.pendingNew.pop_front();
+            std::string k, side;
+            in >> k >> side;
+            g.me = side.empty() ? BLACK : side[0];
+            g.sent = Clock::now();
+            ClientGame& ref = c.games.emplace(id, g).first->second;
+            if (g.me == BLACK) play(c, id, ref);
+        } else if (cmd == "ai") {
+            auto it = c.games.find(id);
+            if (it == c.games.end()) return;
+            ClientGame& g = it->second;
+            std::string mv, next;
+            in >> mv >> next;
+            latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - g.sent).count());
+            if (g.reversi) {
+                if (mv != "pass" && !g.rv.play(parseSq(mv))) { ++errors; std::fprintf(stderr, "desync: %s\n", line.c_str()); }
+            } else {
+                int cell = std::atoi(mv.c_str()) - 1;
+                if (cell >= 0 && cell < 9) g.ttt[cell] = 'O';
+            }
+            if (next == "you") play(c, id, g);
+            else if (next == "ai") g.sent = Clock::now();
+        } else if (cmd == "over") {
+            std::string result;
+            in >> result;
+            (result == "win" ? wins : result == "loss" ? losses : draws)++;
+            c.games.erase(id);
+            ++finished;
+            if (started < total) startGame(c);
+        } else if (cmd == "stats") {
+            serverStats = line;
+        } else {
+            ++errors;
+            if (errors <= 5) std::fprintf(stderr, "server: %s\n", line.c_str());
+        }
+    }
+
+    static int parseSq(const std::string& s) {
+        if (s.size() != 2) return -1;
+        int col = s[0] - 'a', row = s[1] - '1';
+        return inBounds(row, col) ? sqOf(row, col) : -1;
+    }
+
+    // ランダムな合法手を打つ
+    void play(Client& c, uint32_t id, ClientGame& g) {
+        std::string mv;
+        if (g.reversi) {
+            uint64_t m = g.rv.legal();
+            for (int k = (int)(rng() % popcount64(m)); k > 0; --k) m &= m - 1;
+            int sq = lsb64(m);
+            g.rv.play(sq);
+            mv = squareName(sq);
+        } else {
+            int empty[9], n = 0;
+            for (int i = 0; i < 9; ++i) if (!g.ttt[i]) empty[n++] = i;
+            int cell = empty[rng() % n];
+            g.ttt[cell] = 'X';
+            mv = std::to_string(cell + 1);
+        }
+        g.sent = Clock::now();
+        send(c, "play " + std::to_string(id) + " " + mv);
+    }
+
+    void report(double secs) {
+        // サーバ側の集計も 1 行もらう
+        Client& c = *clients[0];
+        send(c, "stats");
+        flush(c);
+        for (int tries = 0; tries < 100 && serverStats.empty(); ++tries) {
+            epoll_event ev;
+            if (epoll_wait(ep, &ev, 1, 50) > 0 && (ev.events & EPOLLIN)) readClient(*clients[ev.data.u32]);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto pct = [&](double p) { return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))]; };
+        std::printf("games %ld (win %ld / loss %ld / draw %ld) in %.2fs: %.1f games/s, %.1f ai moves/s\n", finished, wins, losses,
+                    draws, secs, finished / secs, latencies.size() / secs);
+        std::printf("concurrent games %d, latency ms: p50 %.2f p90 %.2f p99 %.2f max %.2f, errors %ld\n", conns * perConn,
+                    pct(0.5), pct(0.9), pct(0.99), latencies.empty() ? 0.0 : latencies.back(), errors);
+        if (!serverStats.empty()) std::printf("server: %s\n", serverStats.c_str());
+    }
+};
+
+int main(int argc, char** argv) {
+    LoadGen lg;
+    int port = 7777;
+    std::string unixPath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--port")        port = std::atoi(argv[++i]);
+        else if (a == "--unix")   unixPath = argv[++i];
+        else if (a == "--conns")  lg.conns = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--games")  lg.perConn = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--total")  lg.total = std::atol(argv[++i]);
+        else if (a == "--kind")   lg.kind = argv[++i];
+        else if (a == "--budget") lg.budget = argv[++i];
+        else if (a == "--seed")   lg.rng.seed(std::strtoull(argv[++i], nullptr, 10));
+    }
+    return lg.run(port, unixPath);
+}
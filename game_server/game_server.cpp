@@ -0,0 +1,604 @@
+// game_server.cpp - オセロと三目並べの対局サーバ（多数の対局を 1 プロセスで受け持つ）
+// クライアントの入出力は epoll のループ 1本で処理し、オセロの AI の手だけをワーカースレッドに回す
+// （三目並べは完全解析表を引くだけなのでループの中で打つ）。Linux 専用。
+// ビルド: clang++ -std=c++17 -O2 -pthread game_server.cpp -o game_server
+// 例: ./game_server --port 7777 --workers 8 --queue 256 --budget 5000
+//     ./game_loadgen --port 7777 --conns 50 --games 40 --total 20000（負荷試験は game_loadgen.cpp）
+//
+// プロトコル（1行1メッセージ。1接続で複数の対局を持てる）:
+//   → new reversi|ttt [X|O] [budget <ms>]   対局を始める（X なら先手。budget は AI の 1局ぶんの持ち時間）
+//   ← game <id> <reversi|ttt> <X|O>         （AI が先手なら続けて ai が来る）
+//   → play <id> <手>                         オセロは d3 形式、三目並べは 1-9
+//   ← ai <id> <手|pass> <you|ai|over>        AI の手と次の手番（ai はあなたがパスして AI がもう一度打つ）
+//   ← over <id> <win|loss|draw> <石数など>   （あなたから見た結果）
+//   → close <id> / stats / quit
+//   ← error [<id>] <理由>
+// オセロは打てない側のパスをサーバが自動で入れる（クライアントから pass は送らない）。
+//
+// 背圧: 未処理の AI の手が --queue 個に達したら、その間はクライアントの入力を読まない
+// （読み残しはカーネルのバッファにたまり、クライアント側の送信が詰まる）。
+// 出力を読まないクライアントも、送信待ちが OUT_LIMIT を超えたら入力を止める。
+//
+// オプション:
+//   --port <n>       127.0.0.1 の TCP で待つ（既定 7777。0 なら TCP を使わない）
+//   --unix <path>    Unix ドメインソケットでも待つ
+//   --workers <n>    AI のワーカースレッド数（既定 CPU 数）
+//   --queue <n>      未処理の AI の手の上限（既定 workers*32）
+//   --budget <ms>    1局ぶんの AI の持ち時間の既定値（既定 5000）
+//   --move-ms <ms>   1手の持ち時間の上限（既定 1000）
+//   --hash <MB>      ワーカーごとの置換表（既定 8）
+//   --weights <file> 評価の重み（既定 reversi.weights。なければ組み込みの値。reversi.probcut があれば ProbCut の予測式も読む）
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../reversi_core/game_state.hpp"
+#include "../reversi_core/search.hpp"
+#include "../reversi_core/stats.hpp"
+#include "../tic_tac_toe/solved_table.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t OUT_LIMIT = 1 << 20;   // 送信待ちがこれを超えたら入力を止める
+static const size_t LINE_LIMIT = 4096;     // 1行の長さの上限
+static const int MIN_MOVE_MS = 2;
+
+// --- AI のワーカー ---
+struct Job {
+    uint32_t game;
+    uint64_t P, O;
+    int timeMs;
+};
+struct Done {
+    uint32_t game;
+    int sq;
+    double seconds;
+};
+
+// 探索はワーカーごとの Searcher で行う（置換表は対局をまたいで使い回す。局面が同じなら値も同じ）。
+// 終わった手は done に積み、eventfd でループを起こす
+class WorkerPool {
+public:
+    WorkerPool(int n, size_t hashMb, const SearchLimits& base, int wakeFd) : efd(wakeFd) {
+        for (int i = 0; i < n; ++i) {
+            searchers.emplace_back(new Searcher);
+            searchers.back()->setHashSize(hashMb);
+            searchers.back()->limits = base;
+            searchers.back()->limits.threads = 1;
+        }
+        for (int i = 0; i < n; ++i) threads.emplace_back([this, i]() { work(*searchers[i]); });
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            quit = true;
+        }
+        cv.notify_all();
+        for (auto& s : searchers) s->stop();
+        for (std::thread& t : threads) t.join();
+    }
+
+    void submit(const Job& j) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            jobs.push_back(j);
+        }
+        cv.notify_one();
+    }
+    void drain(std::vector<Done>& out) {
+        std::lock_guard<std::mutex> lock(doneMtx);
+        out.swap(done);
+        done.clear();
+    }
+    int size() const { return (int)threads.size(); }
+
+private:
+    int efd;
+    std::vector<std::unique_ptr<Searcher>> searchers;
+    std::vector<std::thread> threads;
+    std::mutex mtx, doneMtx;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::vector<Done> done;
+    bool quit = false;
+
+    void work(Searcher& s) {
+        for (;;) {
+            Job j;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]() { return quit || !jobs.empty(); });
+                if (quit) return;
+                j = jobs.front();
+                jobs.pop_front();
+            }
+            s.limits.timeMs = j.timeMs;
+            SearchResult r = s.search(j.P, j.O);
+            bool wake;
+            {
+                std::lock_guard<std::mutex> lock(doneMtx);
+                wake = done.empty();
+                done.push_back({j.game, r.bestSq, r.seconds});
+            }
+            if (wake) { uint64_t one = 1; ssize_t w = write(efd, &one, sizeof(one)); (void)w; }
+        }
+    }
+};
+
+// --- 接続と対局 ---
+struct Conn {
+    uint64_t id;
+    int fd;
+    std::string in, out;
+    size_t outPos = 0;
+    uint32_t events = 0;
+    bool stalled = false;  // 背圧で入力を止めている
+    bool closing = false;  // quit の後、送り終えたら閉じる
+    std::vector<uint32_t> games;
+    size_t pendingOut() const { return out.size() - outPos; }
+};
+
+enum GameKind { GAME_REVERSI, GAME_TTT };
+
+struct Game {
+    uint32_t id;
+    GameKind kind;
+    uint64_t conn;
+    char human;                // 人間側の石（X が先手）
+    int64_t budgetMs;          // AI の残り持ち時間
+    bool aiPending = false;
+    Clock::time_point asked;   // AI に手番が回った時刻（応答時間の計測用）
+    GameState rv;              // オセロ
+    char ttt[9] = {};          // 三目並べ（0 / 'X' / 'O'）
+    char tttTurn = 'X';
+};
+
+// 三目並べの勝者（'X' / 'O'）。いなければ 0
+static char tttWinner(const char b[9]) {
+    for (const auto& l : ttt::LINES)
+        if (b[l[0]] && b[l[0]] == b[l[1]] && b[l[1]] == b[l[2]]) return b[l[0]];
+    return 0;
+}
+static bool tttFull(const char b[9]) {
+    for (int i = 0; i < 9; ++i) if (!b[i]) return false;
+    return true;
+}
+
+class Server {
+public:
+    int workers = (int)std::max(1u, std::thread::hardware_concurrency());
+    int queueLimit = 0;
+    int64_t defaultBudgetMs = 5000;
+    int moveCapMs = 1000;
+    size_t hashMb = 8;
+
+    bool listenTcp(int port) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in a{};
+        a.sin_family = AF_INET;
+        a.sin_port = htons((uint16_t)port);
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(fd, 4096) < 0) { close(fd); return false; }
+        listeners.push_back(fd);
+        return true;
+    }
+
+    bool listenUnix(const std::string& path) {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        sockaddr_un a{};
+        a.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(a.sun_path)) { close(fd); return false; }
+        std::strcpy(a.sun_path, path.c_str());
+        unlink(path.c_str());
+        if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(fd, 4096) < 0) { close(fd); return false; }
+        listeners.push_back(fd);
+        unixPath = path;
+        return true;
+    }
+
+    int run(const SearchLimits& base) {
+        if (queueLimit <= 0) queueLimit = workers * 32;
+        ep = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGINT);
+        sigaddset(&mask, SIGTERM);
+        sigprocmask(SIG_BLOCK, &mask, nullptr);
+        int sigFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        // id 0..: listeners、WAKE_ID は eventfd、SIG_ID は signalfd、接続は FIRST_CONN から
+        for (size_t i = 0; i < listeners.size(); ++i) addFd(listeners[i], EPOLLIN, i);
+        addFd(wakeFd, EPOLLIN, WAKE_ID);
+        addFd(sigFd, EPOLLIN, SIG_ID);
+
+        WorkerPool pool(workers, hashMb, base, wakeFd);
+        this->pool = &pool;
+        std::fprintf(stderr, "game_server: workers=%d queue=%d budget=%lldms move-cap=%dms\n", workers, queueLimit,
+                     (long long)defaultBudgetMs, moveCapMs);
+
+        std::vector<epoll_event> evs(1024);
+        std::vector<Done> done;
+        bool running = true;
+        while (running) {
+            int n = epoll_wait(ep, evs.data(), (int)evs.size(), -1);
+            if (n < 0) { if (errno == EINTR) continue; break; }
+            for (int i = 0; i < n; ++i) {
+                uint64_t id = evs[i].data.u64;
+                uint32_t e = evs[i].events;
+                if (id < listeners.size()) acceptAll(listeners[id]);
+                else if (id == WAKE_ID) {
+                    uint64_t v;
+                    ssize_t r = read(wakeFd, &v, sizeof(v));
+                    (void)r;
+                    pool.drain(done);
+                    for (const Done& d : done) finishAi(d);
+                } else if (id == SIG_ID) running = false;
+                else {
+                    auto it = conns.find(id);
+                    if (it == conns.end()) continue;
+                    Conn& c = *it->second;
+                    if (e & (EPOLLERR | EPOLLHUP)) { dropConn(id); continue; }
+                    if (e & EPOLLIN) readConn(c);
+                    if (conns.count(id) && (e & EPOLLOUT)) flushConn(c);
+                }
+            }
+            resumeStalled();
+            for (uint64_t id : dirty) {
+                auto it = conns.find(id);
+                if (it != conns.end()) flushConn(*it->second);
+            }
+            dirty.clear();
+        }
+        this->pool = nullptr;
+        std::fprintf(stderr, "game_server: %s\n", statsLine().c_str());
+        for (auto& kv : conns) close(kv.second->fd);
+        for (int fd : listeners) close(fd);
+        if (!unixPath.empty()) unlink(unixPath.c_str());
+        close(sigFd);
+        return 0;
+    }
+
+private:
+    static const uint64_t WAKE_ID = 1000, SIG_ID = 1001, FIRST_CONN = 1 << 20;
+    int ep = -1, wakeFd = -1;
+    std::vector<int> listeners;
+    std::string unixPath;
+    WorkerPool* pool = nullptr;
+    std::unordered_map<uint64_t, std::unique_ptr<Conn>> conns;
+    std::unordered_map<uint32_t, Game> games;
+    std::deque<uint64_t> stalledConns;
+    std::vector<uint64_t> dirty;
+    uint64_t nextConn = FIRST_CONN;
+    uint32_t nextGame = 1;
+    int outstanding = 0;       // キューに入れてまだ結果を処理していない AI の手
+    uint64_t gamesStarted = 0, gamesFinished = 0, aiMoves = 0;
+    LatencyHistogram latency;  // オセロの AI に手番が回ってから手を返すまで（キュー待ちを含む。三目並べは表を引くだけなので入れない）
+
+    void addFd(int fd, uint32_t events, uint64_t id) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = id;
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void acceptAll(int lfd) {
+        for (;;) {
+            int fd = accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // Unix ソケットでは失敗するが害はない
+            std::unique_ptr<Conn> c(new Conn);
+            c->id = nextConn++;
+            c->fd = fd;
+            c->events = EPOLLIN;
+            addFd(fd, c->events, c->id);
+            conns.emplace(c->id, std::move(c));
+        }
+    }
+
+    void updateEvents(Conn& c) {
+        uint32_t want = (c.stalled || c.closing ? 0u : (uint32_t)EPOLLIN) | (c.pendingOut() ? (uint32_t)EPOLLOUT : 0u);
+        if (want == c.events) return;
+        epoll_event ev{};
+        ev.events = want;
+        ev.data.u64 = c.id;
+        epoll_ctl(ep, EPOLL_CTL_MOD, c.fd, &ev);
+        c.events = want;
+    }
+
+    void dropConn(uint64_t id) {
+        auto it = conns.find(id);
+        if (it == conns.end()) return;
+        for (uint32_t g : it->second->games) games.erase(g); // 探索中の手は結果が来たときに捨てる
+        close(it->second->fd);
+        conns.erase(it);
+    }
+
+    void send(Conn& c, const std::string& line) {
+        if (!c.pendingOut()) dirty.push_back(c.id);
+        c.out += line;
+        c.out += '\n';
+    }
+    void send(const Game& g, const std::string& line) {
+        auto it = conns.find(g.conn);
+        if (it != conns.end()) send(*it->second, line);
+    }
+
+    void flushConn(Conn& c) {
+        while (c.pendingOut()) {
+            ssize_t w = ::send(c.fd, c.out.data() + c.outPos, c.pendingOut(), MSG_NOSIGNAL);
+            if (w < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                dropConn(c.id);
+                return;
+            }
+            c.outPos += (size_t)w;
+        }
+        if (!c.pendingOut()) {
+            c.out.clear();
+            c.outPos = 0;
+            if (c.closing) { dropConn(c.id); return; }
+        } else if (c.outPos > (1 << 16)) {
+            c.out.erase(0, c.outPos);
+            c.outPos = 0;
+        }
+        if (c.stalled && c.pendingOut() < OUT_LIMIT / 2 && outstanding < queueLimit) stalledConns.push_back(c.id);
+        updateEvents(c);
+    }
+
+    void readConn(Conn& c) {
+        char buf[65536];
+        for (;;) {
+            ssize_t r = read(c.fd, buf, sizeof(buf));
+            if (r > 0) { c.in.append(buf, (size_t)r); if (r < (ssize_t)sizeof(buf)) break; continue; }
+            if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) { processInput(c); dropConn(c.id); return; }
+            break;
+        }
+        processInput(c);
+    }
+
+    // 1行ずつ処理する。AI のキューが一杯か送信待ちが多すぎたら、残りは読み残して入力を止める
+    void processInput(Conn& c) {
+        size_t pos = 0;
+        while (!c.closing) {
+            if (outstanding >= queueLimit || c.pendingOut() > OUT_LIMIT) {
+                if (!c.stalled) { c.stalled = true; stalledConns.push_back(c.id); }
+                break;
+            }
+            size_t nl = c.in.find('\n', pos);
+            if (nl == std::string::npos) break;
+            std::string line = c.in.substr(pos, nl - pos);
+            pos = nl + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            handleLine(c, line);
+        }
+        c.in.erase(0, pos);
+        if (c.in.size() > LINE_LIMIT && c.in.find('\n') == std::string::npos) {
+            send(c, "error line too long");
+            c.in.clear();
+            c.closing = true;
+        }
+        updateEvents(c);
+    }
+
+    // 背圧が解けたら、止めていた接続の読み残しを処理して入力を再開する
+    void resumeStalled() {
+        while (!stalledConns.empty() && outstanding < queueLimit) {
+            uint64_t id = stalledConns.front();
+            stalledConns.pop_front();
+            auto it = conns.find(id);
+            if (it == conns.end() || !it->second->stalled) continue;
+            Conn& c = *it->second;
+            if (c.pendingOut() > OUT_LIMIT) continue; // 送り終わったら flushConn から戻ってくる
+            c.stalled = false;
+            processInput(c);
+        }
+    }
+
+    void handleLine(Conn& c, const std::string& line) {
+        std::istringstream in(line);
+        std::string cmd;
+        if (!(in >> cmd)) return;
+        if (cmd == "new") newGame(c, in);
+        else if (cmd == "play") {
+            uint32_t id = 0;
+            std::string mv;
+            in >> id >> mv;
+            auto it = games.find(id);
+            if (it == games.end() || it->second.conn != c.id) { send(c, "error " + std::to_string(id) + " no such game"); return; }
+            humanMove(it->second, mv);
+        } else if (cmd == "close") {
+            uint32_t id = 0;
+            in >> id;
+            auto it = games.find(id);
+            if (it == games.end() || it->second.conn != c.id) { send(c, "error " + std::to_string(id) + " no such game"); return; }
+            endGame(it->second);
+            send(c, "closed " + std::to_string(id));
+        } else if (cmd == "stats") send(c, "stats " + statsLine());
+        else if (cmd == "quit") {
+            c.closing = true;
+            if (!c.pendingOut()) dirty.push_back(c.id); // 送るものがなくても flushConn で閉じる
+        }
+        else send(c, "error unknown command " + cmd);
+    }
+
+    std::string statsLine() const {
+        char buf[256];
+        std::snprintf(buf, sizeof(buf), "conns %zu games %zu started %llu finished %llu queue %d ai_moves %llu "
+                      "p50_ms %.0f p90_ms %.0f p99_ms %.0f max_ms %.1f", conns.size(), games.size(),
+                      (unsigned long long)gamesStarted, (unsigned long long)gamesFinished, outstanding,
+                      (unsigned long long)aiMoves, latency.percentile(0.5), latency.percentile(0.9),
+                      latency.percentile(0.99), latency.maxMs);
+        return buf;
+    }
+
+    void newGame(Conn& c, std::istringstream& in) {
+        std::string kind, tok;
+        in >> kind;
+        if (kind != "reversi" && kind != "ttt") { send(c, "error usage: new reversi|ttt [X|O] [budget <ms>]"); return; }
+        Game g;
+        g.id = nextGame++;
+        g.kind = kind == "reversi" ? GAME_REVERSI : GAME_TTT;
+        g.conn = c.id;
+        g.human = BLACK;
+        g.budgetMs = defaultBudgetMs;
+        while (in >> tok) {
+            if (tok == "X" || tok == "O") g.human = tok[0];
+            else if (tok == "budget" && (in >> tok)) g.budgetMs = std::max(1LL, std::atoll(tok.c_str()));
+        }
+        c.games.push_back(g.id);
+        ++gamesStarted;
+        Game& ref = games.emplace(g.id, std::move(g)).first->second;
+        send(c, "game " + std::to_string(ref.id) + " " + kind + " " + ref.human);
+        if (sideToMove(ref) != ref.human) askAi(ref);
+    }
+
+    char sideToMove(const Game& g) const { return g.kind == GAME_REVERSI ? g.rv.turn() : g.tttTurn; }
+
+    void humanMove(Game& g, const std::string& mv) {
+        std::string id = std::to_string(g.id);
+        if (g.aiPending || sideToMove(g) != g.human || gameOver(g)) { send(g, "error " + id + " not your turn"); return; }
+        if (g.kind == GAME_REVERSI) {
+            int sq = -2;
+            if (mv.size() == 2) {
+                int col = std::tolower((unsigned char)mv[0]) - 'a', row = mv[1] - '1';
+                if (inBounds(row, col)) sq = sqOf(row, col);
+            }
+            if (!g.rv.play(sq)) { send(g, "error " + id + " illegal move " + mv); return; }
+            if (g.rv.over()) { finishGame(g); return; }
+            if (g.rv.turn() == g.human) { send(g, "ai " + id + " pass you"); return; } // AI が打てずにパス
+        } else {
+            int cell = std::atoi(mv.c_str()) - 1;
+            if (cell < 0 || cell >= 9 || g.ttt[cell]) { send(g, "error " + id + " illegal move " + mv); return; }
+            g.ttt[cell] = g.tttTurn;
+            g.tttTurn = g.tttTurn == 'X' ? 'O' : 'X';
+            if (gameOver(g)) { finishGame(g); return; }
+        }
+        askAi(g);
+    }
+
+    bool gameOver(const Game& g) const {
+        return g.kind == GAME_REVERSI ? g.rv.over() : tttWinner(g.ttt) || tttFull(g.ttt);
+    }
+
+    // AI に手番を渡す。三目並べはその場で、オセロはワーカーに回す
+    void askAi(Game& g) {
+        g.asked = Clock::now();
+        if (g.kind == GAME_TTT) {
+            int cell = ttt::BEST[ttt::encode(g.ttt)];
+            g.ttt[cell] = g.tttTurn;
+            g.tttTurn = g.tttTurn == 'X' ? 'O' : 'X';
+            aiPlayed(g, std::to_string(cell + 1));
+            return;
+        }
+        // 1手の持ち時間 = 残りの持ち時間を AI の残り手数で割ったもの。混んでいるときはワーカー数との比で縮め、
+        // キュー待ちと合わせた応答時間が伸びすぎないようにする
+        int64_t movesLeft = std::max(1, (g.rv.empties() + 1) / 2);
+        int64_t t = std::min<int64_t>(moveCapMs, g.budgetMs / movesLeft);
+        if (outstanding >= pool->size()) t = t * pool->size() / (outstanding + 1);
+        g.aiPending = true;
+        ++outstanding;
+        pool->submit({g.id, g.rv.own(), g.rv.opp(), (int)std::max<int64_t>(MIN_MOVE_MS, t)});
+    }
+
+    void finishAi(const Done& d) {
+        --outstanding;
+        auto it = games.find(d.game);
+        if (it == games.end()) return; // 探索中に閉じられた対局
+        Game& g = it->second;
+        g.aiPending = false;
+        g.budgetMs = std::max<int64_t>(0, g.budgetMs - (int64_t)(d.seconds * 1000));
+        g.rv.play(d.sq);
+        aiPlayed(g, squareName(d.sq));
+    }
+
+    void aiPlayed(Game& g, const std::string& mv) {
+        ++aiMoves;
+        if (g.kind == GAME_REVERSI) latency.add(std::chrono::duration<double, std::milli>(Clock::now() - g.asked).count());
+        std::string id = std::to_string(g.id);
+        if (gameOver(g)) {
+            send(g, "ai " + id + " " + mv + " over");
+            finishGame(g);
+        } else if (sideToMove(g) == g.human) {
+            send(g, "ai " + id + " " + mv + " you");
+        } else {
+            send(g, "ai " + id + " " + mv + " ai"); // 人間が打てずにパス
+            askAi(g);
+        }
+    }
+
+    void finishGame(Game& g) {
+        std::string result, detail;
+        if (g.kind == GAME_REVERSI) {
+            int me = g.rv.discs(g.human), other = g.rv.discs(opponent(g.human));
+            result = me > other ? "win" : me < other ? "loss" : "draw";
+            detail = "X:" + std::to_string(g.rv.discs(BLACK)) + " O:" + std::to_string(g.rv.discs(WHITE));
+        } else {
+            char w = tttWinner(g.ttt);
+            result = !w ? "draw" : w == g.human ? "win" : "loss";
+            detail = w ? std::string(1, w) : "-";
+        }
+        send(g, "over " + std::to_string(g.id) + " " + result + " " + detail);
+        ++gamesFinished;
+        endGame(g);
+    }
+
+    void endGame(Game& g) {
+        auto it = conns.find(g.conn);
+        if (it != conns.end()) {
+            std::vector<uint32_t>& v = it->second->games;
+            v.erase(std::remove(v.begin(), v.end(), g.id), v.end());
+        }
+        games.erase(g.id);
+    }
+};
+
+int main(int argc, char** argv) {
+    Server server;
+    int port = 7777;
+    std::string unixPath, weightsFile = "reversi.weights";
+    SearchLimits base;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--port")         port = std::atoi(argv[++i]);
+        else if (a == "--unix")    unixPath = argv[++i];
+        else if (a == "--workers") server.workers = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--queue")   server.queueLimit = std::atoi(argv[++i]);
+        else if (a == "--budget")  server.defaultBudgetMs = std::atoll(argv[++i]);
+        else if (a == "--move-ms") server.moveCapMs = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--hash")    server.hashMb = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--weights") weightsFile = argv[++i];
+    }
+    patternWeights().load(weightsFile);
+    probcutParams().load("reversi.probcut");
+    if (port > 0 && !server.listenTcp(port)) { std::perror("tcp listen"); return 1; }
+    if (!unixPath.empty() && !server.listenUnix(unixPath)) { std::perror("unix listen"); return 1; }
+    if (port <= 0 && unixPath.empty()) { std::fprintf(stderr, "--port か --unix が必要です\n"); return 1; }
+    return server.run(base);
+}
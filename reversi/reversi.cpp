@@ -1,27 +1,26 @@
-// reversi.cpp - コンソール版オセロ（合法手・反転・簡易AI付き）
+// reversi.cpp - コンソール版オセロ（合法手・反転・αβ探索AI付き）
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cctype>
 #include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/book.hpp"
+#include "../reversi_core/engine_protocol.hpp"
+#include "../reversi_core/game_state.hpp"
+#include "../reversi_core/mcts.hpp"
+#include "../reversi_core/search.hpp"
+#include "../reversi_core/variant.hpp"
 using namespace std;
 
-static const int N = 8;
-static const char EMPTY = '.';
-static const char BLACK = 'X'; // 先手
-static const char WHITE = 'O'; // 後手
-
-struct Move { int r, c; }; // r: 0-7 (行:1-8), c: 0-7 (列:a-h)
-
-bool inBounds(int r, int c) { return r >= 0 && r < N && c >= 0 && c < N; }
-char opponent(char p) { return p == BLACK ? WHITE : BLACK; }
-
-void printBoard(const vector<vector<char>>& b) {
+void printBoard(const Board& b) {
     cout << "\n   a b c d e f g h\n";
     for (int r = 0; r < N; ++r) {
         cout << (r+1) << "  ";
         for (int c = 0; c < N; ++c) {
-            cout << b[r][c];
+            cout << b.at(r,c);
             if (c < N-1) cout << ' ';
         }
         cout << "\n";
@@ -29,103 +28,29 @@ void printBoard(const vector<vector<char>>& b) {
     cout << "\n(X=黒, O=白)\n";
 }
 
-// 置いたときに反転される座標の一覧を返す（反転可能なら1つ以上返る）
-vector<Move> findFlips(const vector<vector<char>>& b, char p, int r, int c) {
-    vector<Move> flips;
-    if (!inBounds(r,c) || b[r][c] != EMPTY) return flips;
-
-    static const int dr[8] = {-1,-1,-1, 0, 0, 1, 1, 1};
-    static const int dc[8] = {-1, 0, 1,-1, 1,-1, 0, 1};
-    char opp = opponent(p);
-
-    for (int d = 0; d < 8; ++d) {
-        int nr = r + dr[d], nc = c + dc[d];
-        vector<Move> line;
-        // まず隣が相手である必要
-        if (!inBounds(nr,nc) || b[nr][nc] != opp) continue;
-        // 相手石が連続する限り進み、最後が自分の石で止まればその間が反転対象
-        while (inBounds(nr,nc) && b[nr][nc] == opp) {
-            line.push_back({nr,nc});
-            nr += dr[d]; nc += dc[d];
-        }
-        if (inBounds(nr,nc) && b[nr][nc] == p && !line.empty()) {
-            // 反転確定
-            flips.insert(flips.end(), line.begin(), line.end());
-        }
-    }
-    return flips; // 空なら反転なし＝非合法
-}
-
-bool isLegal(const vector<vector<char>>& b, char p, int r, int c) {
-    return !findFlips(b, p, r, c).empty();
-}
-
-vector<Move> legalMoves(const vector<vector<char>>& b, char p) {
-    vector<Move> moves;
-    for (int r = 0; r < N; ++r)
-        for (int c = 0; c < N; ++c)
-            if (isLegal(b, p, r, c)) moves.push_back({r,c});
-    return moves;
-}
-
-void applyMove(vector<vector<char>>& b, char p, int r, int c) {
-    auto flips = findFlips(b, p, r, c);
-    b[r][c] = p;
-    for (auto &m : flips) b[m.r][m.c] = p;
-}
-
-pair<int,int> countDiscs(const vector<vector<char>>& b) {
-    int x=0, o=0;
-    for (int r = 0; r < N; ++r)
-        for (int c = 0; c < N; ++c)
-            if (b[r][c] == BLACK) ++x;
-            else if (b[r][c] == WHITE) ++o;
-    return {x,o};
-}
+// AI：反復深化 αβ 探索（持ち時間は --time / --nodes / --depth、置換表は --hash、スレッド数は --threads で変更可）
+Searcher searcher;
+OpeningBook book; // 定石（--book、既定 reversi.book。なければ使わない）
+// --ai mcts のときは αβ の代わりにモンテカルロ木探索で打つ（持ち時間とスレッド数は --time / --threads を使う）
+bool useMcts = false;
+MctsSearcher<ReversiMctsGame> mcts;
 
-// 盤面の評価用重み（シンプル版：角に高評価, 隅や危険マスは低評価）
-static const int W[N][N] = {
-    { 120,-20, 20,  5,  5, 20,-20,120},
-    { -20,-40, -5, -5, -5, -5,-40,-20},
-    {  20,  -5, 15,  3,  3, 15,  -5, 20},
-    {   5,  -5,  3,  3,  3,  3,  -5,  5},
-    {   5,  -5,  3,  3,  3,  3,  -5,  5},
-    {  20,  -5, 15,  3,  3, 15,  -5, 20},
-    { -20,-40, -5, -5, -5, -5,-40,-20},
-    { 120,-20, 20,  5,  5, 20,-20,120}
-};
-
-// 簡易AI：角を最優先 → 反転枚数の多い手 → 位置重みの高い手
-Move chooseMoveAI(const vector<vector<char>>& b, char ai) {
-    auto moves = legalMoves(b, ai);
-    if (moves.empty()) return {-1,-1};
-    char opp = opponent(ai);
-
-    // 角があれば即選択
-    for (auto m : moves) {
-        if ((m.r == 0 && m.c == 0) || (m.r == 0 && m.c == 7) ||
-            (m.r == 7 && m.c == 0) || (m.r == 7 && m.c == 7)) {
-            return m;
-        }
+Move chooseMoveAI(const Board& b, char ai) {
+    int bookSq, bookScore;
+    if (book.pick(b.own(ai), b.opp(ai), bookSq, bookScore)) {
+        cout << "定石: " << squareName(bookSq) << " (" << scoreText(bookScore) << ")\n";
+        return moveOf(bookSq);
     }
-
-    // 反転枚数 + 位置評価でスコア化
-    int bestScore = -1e9;
-    Move best = moves.front();
-    for (auto m : moves) {
-        auto flips = findFlips(b, ai, m.r, m.c);
-        int flipCount = (int)flips.size();
-        int posScore  = W[m.r][m.c];
-
-        // 1手先の相手合法手の数（与える手数を少なく）も少し考慮
-        vector<vector<char>> tmp = b;
-        applyMove(tmp, ai, m.r, m.c);
-        int oppMobility = (int)legalMoves(tmp, opp).size();
-
-        int score = flipCount * 10 + posScore - oppMobility * 2;
-        if (score > bestScore) { bestScore = score; best = m; }
+    if (useMcts) {
+        mcts.limits.timeMs = searcher.limits.timeMs;
+        mcts.limits.threads = searcher.limits.threads;
+        MctsResult res = mcts.search(ReversiMctsGame(b.own(ai), b.opp(ai), ai == BLACK ? 0 : 1));
+        cout << "探索: " << res.summary() << "\n";
+        return moveOf(res.move);
     }
-    return best;
+    SearchResult res = searcher.search(b.own(ai), b.opp(ai));
+    if (res.bestSq >= 0) cout << "探索: " << res.summary() << "\n      " << searcher.tt.stats().summary() << "\n";
+    return moveOf(res.bestSq);
 }
 
 // 入力 "d3" / "D3" / "3d" を受け付ける（列[a-h], 行[1-8]）。"pass" / "q"もOK。
@@ -147,42 +72,213 @@ bool parseMove(const string& s, Move& out) {
     return false;
 }
 
-int main() {
-    // 初期配置
-    vector<vector<char>> b(N, vector<char>(N, EMPTY));
-    b[3][3] = WHITE; b[4][4] = WHITE;
-    b[3][4] = BLACK; b[4][3] = BLACK;
-    char turn = BLACK; // 先手は黒
+// 並列探索の速度向上の計測：固定局面を固定深さまで 1 スレッドと N スレッドで読み、所要時間を比べる
+void smpBenchmark(int depth) {
+    static const char* POSITIONS[] = {
+        "f5d6c3d3c4f4f6f3e6e7",
+        "f5f6e6f4e3c5c4d3c3d6",
+        "c4c3d3c5b4d2e2b3c6d6e6",
+        "f5d6c5f4e3f6d3e6g5g4f3c4",
+        "e6f4c3c4d3d6e3c2b3d2c5f5",
+    };
+    SearchLimits saved = searcher.limits;
+    int nThreads = saved.threads > 1 ? saved.threads : (int)std::max(2u, thread::hardware_concurrency());
+    searcher.limits.timeMs = 0;
+    searcher.limits.maxNodes = 0;
+    searcher.limits.maxDepth = depth;
+    searcher.limits.exactEmpties = searcher.limits.wldEmpties = 0;
 
-    cout << "Othello / Reversi (Console)\n";
-    cout << "入力例: d3（列a-h, 行1-8）。パス: pass, 終了: q\n";
-    cout << "あなた=黒(X), AI=白(O)\n";
+    cout << "SMP ベンチ: depth=" << depth << " threads=1 vs " << nThreads << "\n";
+    double total[2] = {0, 0};
+    for (const char* pos : POSITIONS) {
+        Board b; char turn;
+        if (!playTranscript(pos, b, turn)) continue;
+        double t[2];
+        for (int k = 0; k < 2; ++k) {
+            searcher.setThreads(k == 0 ? 1 : nThreads);
+            searcher.newGame();
+            SearchResult res = searcher.search(b.own(turn), b.opp(turn));
+            t[k] = res.seconds;
+            total[k] += res.seconds;
+            cout << "  " << pos << (k == 0 ? "  1T: " : "  NT: ") << squareName(res.bestSq) << " " << res.summary() << "\n";
+        }
+        cout << "  speedup x" << (t[1] > 0 ? t[0] / t[1] : 0) << "\n";
+    }
+    cout << "合計: 1T " << total[0] << "s / " << nThreads << "T " << total[1] << "s  speedup x"
+         << (total[1] > 0 ? total[0] / total[1] : 0) << "\n";
+    searcher.limits = saved;
+}
 
-    bool lastPass = false; // 直前にパスしたか
-    while (true) {
-        printBoard(b);
-        auto [bx, bo] = countDiscs(b);
-        cout << "石数: 黒(X)=" << bx << " 白(O)=" << bo << "\n";
-
-        auto moves = legalMoves(b, turn);
-        if (moves.empty()) {
-            cout << (turn==BLACK ? "黒" : "白") << " に合法手がありません → パス\n";
-            if (lastPass) {
-                cout << "両者とも打てないため、ゲーム終了。\n";
-                break;
-            }
-            lastPass = true;
+// 6×6 / 10×10 の対局（variant.hpp。定石・パターン評価は 8×8 専用なので、位置の重みと着手可能数で読む）
+template <int S>
+void playVariant() {
+    typedef BitsOf<S> Bits;
+    VariantSearcher<S> ai;
+    ai.limits.timeMs = searcher.limits.timeMs;
+    ai.limits.maxDepth = searcher.limits.maxDepth;
+    if (searcher.limits.exactEmpties < ai.limits.exactEmpties) ai.limits.exactEmpties = searcher.limits.exactEmpties;
+
+    VariantBoard<S> b = initialBoardOf<S>();
+    char turn = BLACK;
+    vector<VariantBoard<S>> history; // 黒が打つ前の盤（待った用。黒の手番でしか戻らない）
+    auto print = [&]() {
+        cout << "\n   ";
+        for (int c = 0; c < S; ++c) cout << ' ' << char('a' + c);
+        cout << "\n";
+        for (int r = 0; r < S; ++r) {
+            cout << (r + 1 < 10 ? " " : "") << (r + 1) << "  ";
+            for (int c = 0; c < S; ++c) cout << b.at(r, c) << (c < S - 1 ? " " : "");
+            cout << "\n";
+        }
+        cout << "\n石数: 黒(X)=" << popcountBits(b.black) << " 白(O)=" << popcountBits(b.white) << "\n";
+    };
+    string last = string(1, char('a' + S - 1)) + to_string(S);
+
+    cout << "Othello / Reversi " << S << "x" << S << " (Console)\n";
+    cout << "入力例: d3（列a-" << char('a' + S - 1) << ", 行1-" << S << "）。待った: u, 終了: q\n";
+    cout << "あなた=黒(X), AI=白(O)\n";
+    for (;;) {
+        Bits own = b.own(turn), opp = b.opp(turn);
+        if (!movesOf<S>(own, opp)) {
+            if (!movesOf<S>(opp, own)) break;
+            cout << (turn == BLACK ? "黒" : "白") << " に合法手がありません → パス\n";
             turn = opponent(turn);
             continue;
         }
-        lastPass = false;
-
         if (turn == BLACK) {
+            print();
+            cout << "あなた(黒)の手番です。入力してください (例: d3 / " << last << " / u / q): ";
+            string s;
+            if (!getline(cin, s)) { cout << "入力を終了します。\n"; return; }
+            if (s.empty()) continue;
+            if (s == "q" || s == "Q") { cout << "終了します。\n"; return; }
+            if (s == "u" || s == "U") {
+                if (history.empty()) { cout << "戻せる手がありません。\n"; continue; }
+                b = history.back();
+                history.pop_back();
+                continue;
+            }
+            int sq = parseVariantSquare(S, s);
+            if (sq < 0 || !(movesOf<S>(own, opp) & Geometry<S>::bit(sq))) { cout << "その手は合法ではありません。\n"; continue; }
+            history.push_back(b);
+            b.play(BLACK, sq);
+        } else {
+            VariantResult res = ai.search(own, opp);
+            cout << "探索: " << res.summary() << "\n";
+            cout << "AI(白)の手: " << variantSquareName(S, res.bestSq) << "\n";
+            b.play(WHITE, res.bestSq);
+        }
+        turn = opponent(turn);
+    }
+    print();
+    int x = popcountBits(b.black), o = popcountBits(b.white);
+    cout << "ゲーム終了。最終結果: 黒(X)=" << x << " 白(O)=" << o << "\n";
+    if (x > o) cout << "あなた(黒)の勝ち！\n";
+    else if (o > x) cout << "AI(白)の勝ち！\n";
+    else cout << "引き分け！\n";
+}
+
+// コマンドライン: --time <ms> / --nodes <n> / --depth <d> / --hash <MB> / --threads <n>
+//                 --exact <空き数> / --wld <空き数>（終盤読み切りを始める空きマス数）
+//                 --book <file>（定石ファイル。既定 reversi.book）/ --weights <file>（評価の重み。既定 reversi.weights）
+//                 --sel <0〜5>（ProbCut の選択度。0 で全幅。既定 3）/ --probcut <file>（ProbCut の予測式。既定 reversi.probcut）
+//                 --ai mcts（αβ の代わりにモンテカルロ木探索で打つ。mcts.hpp）
+//                 --smp-bench <depth>（並列探索の速度向上を計測して終了）
+//                 --size <6|8|10>（盤の一辺。既定 8。6 と 10 は variant.hpp の探索で対局する。--engine・--ai mcts・--smp-bench は 8 のみ）
+//                 --engine（盤を表示せず、標準入出力のテキストプロトコルで動く。コマンドは engine_protocol.hpp）
+//                 --stats（終局時に探索の計測を表示）/ --stats-json <file>（計測を JSON で書き出す）
+//                 計測は -DREVERSI_STATS でビルドしたときだけ数える:
+//                   clang++ -std=c++17 -O2 -pthread -DREVERSI_STATS reversi.cpp -o reversi
+int smpBenchDepth = 0, boardSize = N;
+string bookFile = "reversi.book", weightsFile = "reversi.weights", probcutFile = "reversi.probcut";
+bool showStats = false, engineMode = false;
+string statsJsonFile;
+
+void parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--stats") { showStats = true; continue; }
+        if (a == "--engine") { engineMode = true; continue; }
+        if (i + 1 >= argc) break;
+        if (a == "--time")       searcher.limits.timeMs = atoi(argv[++i]);
+        else if (a == "--nodes") searcher.limits.maxNodes = strtoull(argv[++i], nullptr, 10);
+        else if (a == "--depth") searcher.limits.maxDepth = atoi(argv[++i]);
+        else if (a == "--hash")  searcher.setHashSize(strtoull(argv[++i], nullptr, 10));
+        else if (a == "--exact") searcher.limits.exactEmpties = atoi(argv[++i]);
+        else if (a == "--wld")   searcher.limits.wldEmpties = atoi(argv[++i]);
+        else if (a == "--sel")   searcher.limits.selectivity = atoi(argv[++i]);
+        else if (a == "--threads")   searcher.setThreads(atoi(argv[++i]));
+        else if (a == "--smp-bench") smpBenchDepth = atoi(argv[++i]);
+        else if (a == "--ai")        useMcts = string(argv[++i]) == "mcts";
+        else if (a == "--size")      boardSize = atoi(argv[++i]);
+        else if (a == "--book")      bookFile = argv[++i];
+        else if (a == "--weights")   weightsFile = argv[++i];
+        else if (a == "--probcut")   probcutFile = argv[++i];
+        else if (a == "--stats-json") statsJsonFile = argv[++i];
+    }
+}
+
+// プロトコルモード：標準入力から 1行ずつコマンドを読み、応答を 1行ずつ返す（入力が尽きたら探索の終わりを待って終了）
+int runEngine() {
+    EngineProtocol engine(searcher, [](const string& line) {
+        fwrite(line.data(), 1, line.size(), stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+    }, book.loaded() ? &book : nullptr);
+    string line;
+    while (getline(cin, line))
+        if (!engine.handle(line)) return 0;
+    engine.wait();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+    if (boardSize != N && (engineMode || useMcts || smpBenchDepth > 0)) { // 6×6・10×10 は variant.hpp の αβ だけ
+        cerr << "--size " << boardSize << " では " << (engineMode ? "--engine" : useMcts ? "--ai mcts" : "--smp-bench")
+             << " は使えません（8×8 のみ）\n";
+        return 1;
+    }
+    if (engineMode) { // 標準出力にはプロトコルの応答しか出さない
+        patternWeights().load(weightsFile);
+        probcutParams().load(probcutFile);
+        book.open(bookFile);
+        return runEngine();
+    }
+    if (boardSize != N) {
+        if (!runWithBoardSize(boardSize, [](auto s) { playVariant<decltype(s)::value>(); })) {
+            cerr << "対応していない盤の大きさです: " << boardSize << "（6, 8, 10）\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (patternWeights().load(weightsFile)) cout << "評価の重み: " << weightsFile << "\n";
+    if (probcutParams().load(probcutFile)) cout << "ProbCut: " << probcutFile << "\n";
+    if (smpBenchDepth > 0) { smpBenchmark(smpBenchDepth); return 0; }
+    if (book.open(bookFile)) cout << "定石: " << bookFile << " (" << book.size() << " 局面)\n";
+
+    // 対局の状態（石数・合法手・パスと終局は GameState が着手ごとに更新する）
+    GameState g;
+
+    cout << "Othello / Reversi (Console)\n";
+    cout << "入力例: d3（列a-h, 行1-8）。パス: pass, 待った: u, 終了: q\n";
+    cout << "あなた=黒(X), AI=白(O)\n";
+
+    while (!g.over()) {
+        printBoard(g.board());
+        cout << "石数: 黒(X)=" << g.discs(BLACK) << " 白(O)=" << g.discs(WHITE) << "\n";
+
+        if (g.turn() == BLACK) {
             // 人間の手番
-            cout << "あなた(黒)の手番です。入力してください (例: d3 / pass / q): ";
+            cout << "あなた(黒)の手番です。入力してください (例: d3 / pass / u / q): ";
             string s;
             if (!getline(cin, s)) { cout << "入力を終了します。\n"; break; }
             if (s.empty()) continue;
+            if (s == "u" || s == "U") { // 待った：自分の直前の手まで戻す
+                if (!g.canUndo()) { cout << "戻せる手がありません。\n"; continue; }
+                do g.undo(); while (g.canUndo() && g.turn() != BLACK);
+                continue;
+            }
 
             Move m;
             if (!parseMove(s, m)) {
@@ -193,45 +289,34 @@ int main() {
                 cout << "終了します。\n"; break;
             }
             if (m.r == -1 && m.c == -1) { // pass
-                // 合法手があるのにパスは不可（オセロのルール）
+                // 打てないときは自動でパスになるので、手番が来たときは必ず合法手がある
                 cout << "合法手があります。パスはできません。\n";
                 continue;
             }
-            if (!isLegal(b, turn, m.r, m.c)) {
+            if (!g.play(m.r, m.c)) {
                 cout << "その手は合法ではありません。\n";
                 continue;
             }
-            applyMove(b, turn, m.r, m.c);
-            turn = opponent(turn);
         } else {
             // AIの手番（白）
-            Move aiMove = chooseMoveAI(b, WHITE);
-            if (aiMove.r == -1 && aiMove.c == -1) {
-                cout << "AI(白)はパスします。\n";
-                lastPass = (turn == WHITE && moves.empty());
-                turn = opponent(turn);
-            } else {
-                cout << "AI(白)の手: " << char('a' + aiMove.c) << (aiMove.r + 1) << "\n";
-                applyMove(b, WHITE, aiMove.r, aiMove.c);
-                turn = opponent(turn);
-            }
-        }
-
-        // 全面が埋まったら終了
-        auto [x,o] = countDiscs(b);
-        if (x + o == N*N) {
-            cout << "盤が埋まりました。ゲーム終了。\n";
-            break;
+            Move aiMove = chooseMoveAI(g.board(), WHITE);
+            cout << "AI(白)の手: " << char('a' + aiMove.c) << (aiMove.r + 1) << "\n";
+            g.play(aiMove.r, aiMove.c);
         }
+        if (g.passed()) cout << (g.turn()==BLACK ? "白" : "黒") << " に合法手がありません → パス\n";
     }
+    if (g.over()) cout << (g.empties() ? "両者とも打てないため、ゲーム終了。\n" : "盤が埋まりました。ゲーム終了。\n");
 
-    printBoard(b);
-    auto [x,o] = countDiscs(b);
+    printBoard(g.board());
+    int x = g.discs(BLACK), o = g.discs(WHITE);
     cout << "最終結果: 黒(X)=" << x << " 白(O)=" << o << "\n";
     if (x > o) cout << "あなた(黒)の勝ち！\n";
     else if (o > x) cout << "AI(白)の勝ち！\n";
     else cout << "引き分け！\n";
 
+    if (showStats) cout << searcher.stats().summary();
+    if (!statsJsonFile.empty() && !writeStatsJson(statsJsonFile, searcher.stats()))
+        cerr << "書き出せません: " << statsJsonFile << "\n";
     return 0;
     }
 
@@ -0,0 +1,352 @@
+// reversi_analyze.cpp - 棋譜データベースの一括解析（悪手の検出）
+// WTHOR 形式（.wtb）または 1行1局の棋譜ファイルを mmap で読み、各局を再生して
+// 全局面を固定深さで探索し、実際に打たれた手が最善手よりどれだけ損をしたかを調べる。
+// 結果は CSV（悪手1つにつき1行）か JSON（1局につき1行の JSON Lines）で書き出す。
+//
+// ファイルは全体を読み込まず、ワーカーが小さな範囲（棋譜ファイルは 16KB、WTHOR は 64 局）を順に取って処理する。
+// 出力は範囲の順に書くので、スレッド数によらず入力と同じ順番になる。
+// 損失は石差で表す（評価値は PATTERN_DISC_SCALE で割る。学習済みの重み --weights を使うこと）。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_analyze.cpp -o reversi_analyze
+// 例:     ./reversi_analyze --depth 8 --threads 8 --format csv --out mistakes.csv WTH_2001.wtb WTH_2002.wtb
+//         ./reversi_analyze --format json games.txt > analysis.jsonl
+//
+// オプション:
+//   --depth <d>        各局面の探索の深さ（既定 6）
+//   --exact <空き>     空きがこれ以下なら読み切る（既定 14）
+//   --threshold <石>   この石数以上損をした手を悪手とする（既定 4）
+//   --skip-plies <n>   序盤の n 手は調べない（既定 0）
+//   --max-games <n>    ファイルごとに先頭の n 局だけ調べる
+//   --threads <n>      スレッド数（既定はコア数）
+//   --format csv|json  出力形式（既定 csv）
+//   --out <file>       出力先（既定は標準出力）
+//   --weights <file>   評価の重み（既定 reversi.weights）
+// 残りの引数が入力ファイル。拡張子 .wtb なら WTHOR、それ以外は 1行1局の "棋譜 [黒石差]"。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/pattern.hpp"
+#include "../reversi_core/search.hpp"
+using namespace std;
+
+struct Options {
+    int depth = 6, exact = 14;
+    double threshold = 4;
+    int skipPlies = 0;
+    long maxGames = 0;
+    int threads = (int)max(1u, thread::hardware_concurrency());
+    bool json = false;
+    string out, weightsFile = "reversi.weights";
+    vector<string> inputs;
+};
+
+// 読み取り専用の mmap
+class MappedFile {
+public:
+    ~MappedFile() { if (base) munmap(base, len); }
+    bool open(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        len = ok ? (size_t)st.st_size : 0;
+        if (ok && len > 0) {
+            void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok) { base = p; madvise(p, len, MADV_SEQUENTIAL); }
+        }
+        ::close(fd);
+        return ok;
+    }
+    const char* data() const { return (const char*)base; }
+    size_t size() const { return len; }
+private:
+    void* base = nullptr;
+    size_t len = 0;
+};
+
+// --- WTHOR ---
+// ヘッダ 16 バイト（4 バイト目から局数）、1局 68 バイト（大会・黒・白の番号、黒の石数、理論値、60 手）。
+// 手は 10 * 行 + 列（1〜8）、0 は終わり。パスは書かれていない
+static const size_t WTHOR_HEADER = 16, WTHOR_RECORD = 68;
+
+// --- 1局ぶんの解析結果 ---
+struct Mistake {
+    int ply;            // 0 始まりの手数（パスは数えない）
+    bool black;
+    int move, best;
+    double playedScore, bestScore; // 手番側から見た石差
+};
+
+struct GameResult {
+    bool ok = false;
+    int blackPlayer = -1, whitePlayer = -1, recordedBlack = -1; // WTHOR のときだけ
+    string moves;
+    int blackDiff = 0;
+    int positions = 0;
+    double loss[2] = {0, 0}; // 黒・白の損失の合計
+    int count[2] = {0, 0};   // 黒・白が調べられた手数
+    vector<Mistake> mistakes;
+};
+
+inline double scoreToDiscs(int s) {
+    if (isMateScore(s)) return s > 0 ? s - SCORE_WIN : s + SCORE_WIN;
+    return (double)s / PATTERN_DISC_SCALE;
+}
+
+// 1局を再生しながら解析する。moves は sq の列
+void analyzeGame(const vector<int>& moves, Searcher& s, const Options& opt, GameResult& g) {
+    uint64_t P = initialBoard().black, O = initialBoard().white;
+    bool black = true;
+    s.newGame();
+    for (size_t ply = 0; ply < moves.size(); ++ply) {
+        uint64_t legal = movesBits(P, O);
+        if (!legal) {
+            if (!movesBits(O, P)) return; // 終局の後に手が続いている
+            swap(P, O);
+            black = !black;
+            legal = movesBits(P, O);
+        }
+        int sq = moves[ply];
+        if (sq < 0 || !(legal & bitOf(sq))) return;
+        g.moves += squareName(sq);
+        uint64_t f = flipsBits(P, O, sq);
+        uint64_t cP = O ^ f, cO = P | f | bitOf(sq);
+
+        if ((int)ply >= opt.skipPlies && popcount64(legal) > 1) {
+            // 最善の値は深さ d、打った手の値はその子を深さ d-1 で読んだもの（同じ深さで比べる）
+            s.limits.maxDepth = opt.depth;
+            SearchResult best = s.search(P, O);
+            int played = sq == best.bestSq ? best.score : s.searchMove(P, O, sq).score;
+            double lossDiscs = max(0.0, scoreToDiscs(best.score) - scoreToDiscs(played));
+            g.loss[!black] += lossDiscs;
+            g.count[!black]++;
+            g.positions++;
+            if (lossDiscs >= opt.threshold)
+                g.mistakes.push_back({(int)ply, black, sq, best.bestSq, scoreToDiscs(played), scoreToDiscs(best.score)});
+        }
+        P = cP; O = cO;
+        black = !black;
+    }
+    if (movesBits(P, O) || movesBits(O, P)) {
+        g.blackDiff = g.recordedBlack >= 0 ? 2 * g.recordedBlack - N*N : 0; // 途中で終わった棋譜は記録の石数から
+    } else {
+        int d = finalDiff(P, O);
+        g.blackDiff = black ? d : -d;
+    }
+    g.ok = true;
+}
+
+bool parseTranscript(const char* p, const char* end, vector<int>& moves) {
+    moves.clear();
+    for (; p + 1 < end && !isspace((unsigned char)*p); p += 2) {
+        int c = tolower((unsigned char)p[0]) - 'a', r = p[1] - '1';
+        if (!inBounds(r, c)) return false;
+        moves.push_back(sqOf(r, c));
+    }
+    return !moves.empty();
+}
+
+// --- 出力 ---
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c >= 0x20) out += c;
+    }
+    return out;
+}
+
+void writeResult(FILE* out, const Options& opt, const string& file, long gameNo, const GameResult& g) {
+    if (!opt.json) {
+        for (const Mistake& m : g.mistakes)
+            fprintf(out, "%s,%ld,%d,%d,%s,%d,%s,%s,%.2f,%.2f,%.2f\n", file.c_str(), gameNo, g.blackPlayer, g.whitePlayer,
+                    m.black ? "black" : "white", m.ply + 1, squareName(m.move).c_str(), squareName(m.best).c_str(),
+                    m.bestScore - m.playedScore, m.playedScore, m.bestScore);
+        return;
+    }
+    fprintf(out, "{\"file\":\"%s\",\"game\":%ld,\"ok\":%s", jsonEscape(file).c_str(), gameNo, g.ok ? "true" : "false");
+    if (g.blackPlayer >= 0) fprintf(out, ",\"black_player\":%d,\"white_player\":%d", g.blackPlayer, g.whitePlayer);
+    if (g.ok) {
+        fprintf(out, ",\"moves\":\"%s\",\"black_diff\":%d,\"positions\":%d", g.moves.c_str(), g.blackDiff, g.positions);
+        for (int side = 0; side < 2; ++side)
+            fprintf(out, ",\"%s\":{\"loss\":%.2f,\"avg_loss\":%.3f,\"mistakes\":%d}", side ? "white" : "black", g.loss[side],
+                    g.count[side] ? g.loss[side] / g.count[side] : 0.0,
+                    (int)count_if(g.mistakes.begin(), g.mistakes.end(), [&](const Mistake& m) { return m.black == !side; }));
+        fprintf(out, ",\"mistakes\":[");
+        for (size_t i = 0; i < g.mistakes.size(); ++i) {
+            const Mistake& m = g.mistakes[i];
+            fprintf(out, "%s{\"ply\":%d,\"player\":\"%s\",\"move\":\"%s\",\"best\":\"%s\",\"loss\":%.2f,\"played\":%.2f,\"best_score\":%.2f}",
+                    i ? "," : "", m.ply + 1, m.black ? "black" : "white", squareName(m.move).c_str(),
+                    squareName(m.best).c_str(), m.bestScore - m.playedScore, m.playedScore, m.bestScore);
+        }
+        fprintf(out, "]");
+    }
+    fprintf(out, "}\n");
+}
+
+// 範囲ごとの結果を、範囲の順番どおりに書き出す（先に終わった範囲は順番が来るまで預かる）。
+// 棋譜ファイルの範囲は「範囲内で始まる行」を受け持つ
+class OrderedWriter {
+public:
+    OrderedWriter(FILE* f, const Options& o) : out(f), opt(o) {}
+    void begin(const string& name) { file = name; next = 0; gameNo = 0; }
+    void submit(size_t chunk, vector<GameResult>&& results) {
+        lock_guard<mutex> lock(mtx);
+        pending[chunk] = move(results);
+        for (auto it = pending.find(next); it != pending.end(); it = pending.find(++next)) {
+            for (const GameResult& g : it->second) {
+                ++gameNo;
+                if (g.ok) { ++games; positions += g.positions; mistakes += g.mistakes.size(); } else ++bad;
+                writeResult(out, opt, file, gameNo, g);
+            }
+            pending.erase(it);
+        }
+    }
+    long games = 0, bad = 0, positions = 0, mistakes = 0;
+private:
+    FILE* out;
+    const Options& opt;
+    mutex mtx;
+    map<size_t, vector<GameResult>> pending;
+    string file;
+    size_t next = 0;
+    long gameNo = 0;
+};
+
+void analyzeFile(const string& path, const MappedFile& mf, const Options& opt, OrderedWriter& writer) {
+    const char* data = mf.data();
+    size_t size = mf.size();
+    bool wthor = path.size() >= 4 && path.compare(path.size() - 4, 4, ".wtb") == 0;
+    size_t nGames = 0;
+    if (wthor) {
+        uint32_t declared;
+        memcpy(&declared, data + 4, 4);
+        nGames = min<size_t>(declared, (size - WTHOR_HEADER) / WTHOR_RECORD);
+        if (opt.maxGames > 0) nGames = min<size_t>(nGames, opt.maxGames);
+    }
+    const size_t TEXT_CHUNK = 16 * 1024, WTHOR_CHUNK = 64;
+    size_t nChunks = wthor ? (nGames + WTHOR_CHUNK - 1) / WTHOR_CHUNK : (size + TEXT_CHUNK - 1) / TEXT_CHUNK;
+    // 棋譜ファイルで --max-games を指定したときは、先頭から数えて打ち切る位置を先に決める
+    size_t textEnd = size;
+    if (!wthor && opt.maxGames > 0) {
+        long n = 0;
+        for (const char* p = data; p < data + size;) {
+            const char* nl = (const char*)memchr(p, '\n', data + size - p);
+            const char* lineEnd = nl ? nl : data + size;
+            if (p < lineEnd && *p != '#' && *p != '\r' && ++n > opt.maxGames) { textEnd = p - data; break; }
+            p = lineEnd + 1;
+        }
+        nChunks = (textEnd + TEXT_CHUNK - 1) / TEXT_CHUNK;
+    }
+
+    writer.begin(path);
+    atomic<size_t> nextChunk{0};
+    vector<thread> pool;
+    for (int t = 0; t < opt.threads; ++t) {
+        pool.emplace_back([&]() {
+            Searcher s;
+            s.limits.timeMs = 0;
+            s.limits.exactEmpties = s.limits.wldEmpties = opt.exact;
+            s.setHashSize(16);
+            vector<int> moves;
+            for (size_t c; (c = nextChunk.fetch_add(1)) < nChunks;) {
+                vector<GameResult> results;
+                if (wthor) {
+                    for (size_t i = c * WTHOR_CHUNK; i < min(nGames, (c + 1) * WTHOR_CHUNK); ++i) {
+                        const unsigned char* rec = (const unsigned char*)data + WTHOR_HEADER + i * WTHOR_RECORD;
+                        GameResult g;
+                        int16_t bp, wp;
+                        memcpy(&bp, rec + 2, 2);
+                        memcpy(&wp, rec + 4, 2);
+                        g.blackPlayer = bp; g.whitePlayer = wp;
+                        g.recordedBlack = rec[6];
+                        moves.clear();
+                        for (int k = 0; k < 60 && rec[8 + k]; ++k) {
+                            int m = rec[8 + k], r = m / 10 - 1, col = m % 10 - 1;
+                            moves.push_back(inBounds(r, col) ? sqOf(r, col) : -1);
+                        }
+                        analyzeGame(moves, s, opt, g);
+                        results.push_back(move(g));
+                    }
+                } else {
+                    size_t begin = c * TEXT_CHUNK, end = min(textEnd, begin + TEXT_CHUNK);
+                    const char* p = data + begin;
+                    if (begin > 0 && data[begin - 1] != '\n') { // 前の範囲から続く行は前の範囲の担当
+                        const char* nl = (const char*)memchr(p, '\n', data + size - p);
+                        p = nl ? nl + 1 : data + size;
+                    }
+                    while (p < data + end) {
+                        const char* nl = (const char*)memchr(p, '\n', data + size - p);
+                        const char* lineEnd = nl ? nl : data + size;
+                        if (p < lineEnd && *p != '#' && *p != '\r') {
+                            GameResult g;
+                            if (parseTranscript(p, lineEnd, moves)) analyzeGame(moves, s, opt, g);
+                            results.push_back(move(g));
+                        }
+                        p = lineEnd + 1;
+                    }
+                }
+                writer.submit(c, move(results));
+            }
+        });
+    }
+    for (thread& t : pool) t.join();
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--depth" && hasValue)            opt.depth = max(1, atoi(argv[++i]));
+        else if (a == "--exact" && hasValue)       opt.exact = atoi(argv[++i]);
+        else if (a == "--threshold" && hasValue)   opt.threshold = atof(argv[++i]);
+        else if (a == "--skip-plies" && hasValue)  opt.skipPlies = atoi(argv[++i]);
+        else if (a == "--max-games" && hasValue)   opt.maxGames = atol(argv[++i]);
+        else if (a == "--threads" && hasValue)     opt.threads = max(1, atoi(argv[++i]));
+        else if (a == "--format" && hasValue)      opt.json = string(argv[++i]) == "json";
+        else if (a == "--out" && hasValue)         opt.out = argv[++i];
+        else if (a == "--weights" && hasValue)     opt.weightsFile = argv[++i];
+        else opt.inputs.push_back(a);
+    }
+    if (opt.inputs.empty()) { cerr << "入力ファイル（.wtb または 1行1局の棋譜）を指定してください\n"; return 1; }
+    if (!patternWeights().load(opt.weightsFile))
+        cerr << "注意: " << opt.weightsFile << " がないので組み込みの重みを使います（損失の石数は目安）\n";
+    probcutParams().load("reversi.probcut");
+
+    FILE* out = opt.out.empty() ? stdout : fopen(opt.out.c_str(), "w");
+    if (!out) { cerr << opt.out << " に書き込めません\n"; return 1; }
+    if (!opt.json) fprintf(out, "file,game,black_player,white_player,player,ply,move,best,loss,played_score,best_score\n");
+
+    auto t0 = chrono::steady_clock::now();
+    OrderedWriter writer(out, opt);
+    for (const string& path : opt.inputs) {
+        MappedFile mf;
+        if (!mf.open(path)) { cerr << path << " を開けません\n"; continue; }
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".wtb") == 0 && mf.size() < WTHOR_HEADER) {
+            cerr << path << ": WTHOR のヘッダがありません\n";
+            continue;
+        }
+        analyzeFile(path, mf, opt, writer);
+    }
+    if (out != stdout) fclose(out);
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    fprintf(stderr, "games=%ld bad=%ld positions=%ld mistakes=%ld  %.1fs (%.1f games/s, threads=%d)\n", writer.games,
+            writer.bad, writer.positions, writer.mistakes, sec, sec > 0 ? writer.games / sec : 0.0, opt.threads);
+    return 0;
+}
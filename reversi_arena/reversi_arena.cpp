@@ -0,0 +1,281 @@
+// reversi_arena.cpp - AI 同士の自己対局アリーナ（ヘッドレス・並列）
+// 2つのエンジン設定 A/B を、開始局面のリストから先後を入れ替えて多数対局させ、
+// A から見た勝/分/敗・Elo 差（95% 区間）・nps・1手あたりの思考時間の分位点を出す。
+// 探索や評価を変えたとき、本当に強く（速く）なったかを確かめるのに使う。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_arena.cpp -o reversi_arena
+// 例:     ./reversi_arena --games 1000 --workers 8 --a "time=50" --b "nodes=20000,depth=12"
+//
+// オプション:
+//   --games <n>         対局数（先後を入れ替えるので偶数推奨）
+//   --workers <n>       並列に進める対局数（既定はコア数）
+//   --a <spec> / --b <spec>
+//                       エンジン設定。カンマ区切りの key=value
+//                       time=<ms> nodes=<n> depth=<d> exact=<空き> wld=<空き> hash=<MB> threads=<n>
+//                       sel=<0〜5>（ProbCut の選択度。0 で全幅）probcut=<file>（ProbCut の予測式）
+//                       weights=<file>（評価の重み。省略時は --weights の重み）
+//                       time も nodes もなければ depth は既定 8、exact/wld は指定がなければ depth+6 に絞る
+//   --openings <file>   開始局面（1行1棋譜 "f5d6c3..."）。省略時は f5 から 4手の全変化
+//   --opening-plies <n> 省略時に作る開始局面の手数
+//   --out <file>        全対局の棋譜と結果を書き出す（"棋譜 黒石差" の1行1局）
+//   --weights <file>    両エンジン共通の評価の重み（既定 reversi.weights。なければ組み込みの重み）
+//   --probcut <file>    両エンジン共通の ProbCut の予測式（既定 reversi.probcut。なければ組み込みの値）
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/search.hpp"
+using namespace std;
+
+// エンジン設定 "time=50,depth=12" を SearchLimits に読み込む
+struct EngineSpec {
+    string text;
+    SearchLimits limits;
+    size_t hashMb = 4;
+    shared_ptr<PatternWeights> weights; // weights= を指定したときだけ
+    shared_ptr<ProbCutParams> probcut;  // probcut= を指定したときだけ
+};
+
+bool parseSpec(const string& text, EngineSpec& spec) {
+    spec = EngineSpec(); // 既定の設定に足すのではなく置き換える
+    spec.text = text;
+    spec.limits.timeMs = 0; // 指定がなければ時間無制限（depth や nodes と組み合わせる）
+    stringstream ss(text);
+    string item;
+    bool exactSet = false, wldSet = false;
+    while (getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string k = item.substr(0, eq);
+        if (k == "weights") {
+            spec.weights = make_shared<PatternWeights>();
+            if (!spec.weights->load(item.substr(eq + 1))) return false;
+            continue;
+        }
+        if (k == "probcut") {
+            spec.probcut = make_shared<ProbCutParams>();
+            if (!spec.probcut->load(item.substr(eq + 1))) return false;
+            continue;
+        }
+        long long v = atoll(item.c_str() + eq + 1);
+        if (k == "time")         spec.limits.timeMs = (int)v;
+        else if (k == "nodes")   spec.limits.maxNodes = (uint64_t)v;
+        else if (k == "depth")   spec.limits.maxDepth = (int)v;
+        else if (k == "exact")   { spec.limits.exactEmpties = (int)v; exactSet = true; }
+        else if (k == "wld")     { spec.limits.wldEmpties = (int)v; wldSet = true; }
+        else if (k == "hash")    spec.hashMb = (size_t)v;
+        else if (k == "threads") spec.limits.threads = (int)v;
+        else if (k == "sel")     spec.limits.selectivity = (int)v;
+        else return false;
+    }
+    // 時間もノード数も決めないと探索も終盤読み切りも無制限になるので、深さと読み切りの空きマス数を絞る
+    if (spec.limits.timeMs == 0 && spec.limits.maxNodes == 0) {
+        if (spec.limits.maxDepth >= 60) spec.limits.maxDepth = 8;
+        int cap = spec.limits.maxDepth + 6;
+        if (!exactSet) spec.limits.exactEmpties = min(spec.limits.exactEmpties, cap);
+        if (!wldSet) spec.limits.wldEmpties = min(spec.limits.wldEmpties, cap);
+    }
+    return true;
+}
+
+// f5 から始まる plies 手の全変化（同じ局面は1つにまとめる）
+void enumerateOpenings(Board b, char turn, const string& moves, int plies, set<pair<uint64_t,uint64_t>>& seen,
+                       vector<string>& out) {
+    if (plies == 0) {
+        if (seen.insert({b.black, b.white}).second) out.push_back(moves);
+        return;
+    }
+    for (uint64_t m = legalBits(b, turn); m; m &= m - 1) {
+        int sq = lsb64(m);
+        Board nb = b;
+        applyMove(nb, turn, sq / N, sq % N);
+        enumerateOpenings(nb, opponent(turn), moves + squareName(sq), plies - 1, seen, out);
+    }
+}
+
+struct EngineStats {
+    uint64_t nodes = 0;
+    double seconds = 0;
+    vector<double> latencyMs;
+    uint64_t depthSum = 0, searched = 0; // 読み切らなかった手の反復の深さ（同じ時間でどこまで読めたか）
+};
+
+struct GameRecord {
+    string moves;
+    int blackDiff = 0; // 黒から見た最終石差
+};
+
+// 1局を最後まで打つ。engines[0] が黒番、engines[1] が白番
+GameRecord playGame(const string& opening, Searcher* engines[2], EngineStats* stats[2]) {
+    GameRecord g;
+    Board b; char turn;
+    playTranscript(opening, b, turn);
+    g.moves = opening;
+    engines[0]->newGame();
+    engines[1]->newGame();
+    while (true) {
+        uint64_t P = b.own(turn), O = b.opp(turn);
+        if (!movesBits(P, O)) {
+            if (!movesBits(O, P)) break;
+            turn = opponent(turn);
+            continue;
+        }
+        int side = turn == BLACK ? 0 : 1;
+        SearchResult res = engines[side]->search(P, O);
+        EngineStats& st = *stats[side];
+        st.nodes += res.nodes;
+        st.seconds += res.seconds;
+        st.latencyMs.push_back(res.seconds * 1000);
+        if (res.solved == SOLVE_NONE) { st.depthSum += res.depth; ++st.searched; }
+        applyMove(b, turn, res.bestSq / N, res.bestSq % N);
+        g.moves += squareName(res.bestSq);
+        turn = opponent(turn);
+    }
+    g.blackDiff = finalDiff(b.black, b.white);
+    return g;
+}
+
+// 勝率 → Elo 差
+double eloFromScore(double s) {
+    s = min(max(s, 1e-4), 1 - 1e-4);
+    return -400 * log10(1 / s - 1);
+}
+
+double percentile(vector<double>& v, double p) {
+    if (v.empty()) return 0;
+    size_t k = min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+void printEngine(const char* name, const EngineSpec& spec, EngineStats& st) {
+    double nps = st.seconds > 0 ? st.nodes / st.seconds : 0;
+    printf("%s [%s]: nps=%.0f moves=%zu depth=%.2f latency p50=%.1fms p90=%.1fms p99=%.1fms max=%.1fms\n", name,
+           spec.text.c_str(), nps, st.latencyMs.size(), st.searched ? (double)st.depthSum / st.searched : 0.0,
+           percentile(st.latencyMs, 0.5),
+           percentile(st.latencyMs, 0.9), percentile(st.latencyMs, 0.99), percentile(st.latencyMs, 1.0));
+}
+
+int main(int argc, char** argv) {
+    int games = 100, workers = (int)max(1u, thread::hardware_concurrency()), openingPlies = 4;
+    string openingsFile, outFile, weightsFile = "reversi.weights", probcutFile = "reversi.probcut";
+    EngineSpec spec[2];
+    parseSpec("depth=6", spec[0]);
+    parseSpec("depth=6", spec[1]);
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--games")              games = atoi(argv[++i]);
+        else if (a == "--workers")       workers = max(1, atoi(argv[++i]));
+        else if (a == "--openings")      openingsFile = argv[++i];
+        else if (a == "--opening-plies") openingPlies = atoi(argv[++i]);
+        else if (a == "--out")           outFile = argv[++i];
+        else if (a == "--weights")       weightsFile = argv[++i];
+        else if (a == "--probcut")       probcutFile = argv[++i];
+        else if (a == "--a" || a == "--b") {
+            if (!parseSpec(argv[++i], spec[a == "--a" ? 0 : 1])) { cerr << "不正なエンジン設定: " << argv[i] << "\n"; return 1; }
+        }
+    }
+
+    if (patternWeights().load(weightsFile)) printf("weights: %s\n", weightsFile.c_str());
+    if (probcutParams().load(probcutFile)) printf("probcut: %s\n", probcutFile.c_str());
+
+    vector<string> openings;
+    if (!openingsFile.empty()) {
+        ifstream in(openingsFile);
+        string line;
+        while (getline(in, line)) {
+            Board b; char turn;
+            if (line.empty() || line[0] == '#') continue;
+            if (!playTranscript(line, b, turn)) { cerr << "不正な開始局面: " << line << "\n"; return 1; }
+            openings.push_back(line);
+        }
+    } else {
+        Board b = initialBoard();
+        applyMove(b, BLACK, 4, 5); // f5（初手は対称なので1つに固定）
+        set<pair<uint64_t,uint64_t>> seen;
+        enumerateOpenings(b, WHITE, "f5", max(0, openingPlies - 1), seen, openings);
+    }
+    if (openings.empty()) { cerr << "開始局面がありません\n"; return 1; }
+
+    printf("arena: %d games, %d workers, %zu openings\n", games, workers, openings.size());
+    printf("A: %s\nB: %s\n", spec[0].text.c_str(), spec[1].text.c_str());
+
+    // 対局 i は開始局面 i/2 を使い、A は i が偶数なら黒番
+    atomic<int> next{0};
+    mutex mtx;
+    int win = 0, draw = 0, loss = 0, done = 0;
+    EngineStats total[2];
+    vector<GameRecord> records(games);
+    auto start = chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        Searcher engine[2];
+        for (int k = 0; k < 2; ++k) {
+            engine[k].limits = spec[k].limits;
+            engine[k].setHashSize(spec[k].hashMb);
+            engine[k].weights = spec[k].weights.get();
+            engine[k].probcut = spec[k].probcut.get();
+        }
+        EngineStats local[2];
+        for (int i; (i = next.fetch_add(1)) < games;) {
+            bool aBlack = i % 2 == 0;
+            Searcher* engines[2] = {&engine[aBlack ? 0 : 1], &engine[aBlack ? 1 : 0]};
+            EngineStats* stats[2] = {&local[aBlack ? 0 : 1], &local[aBlack ? 1 : 0]};
+            GameRecord g = playGame(openings[(i / 2) % openings.size()], engines, stats);
+            int aDiff = aBlack ? g.blackDiff : -g.blackDiff;
+
+            lock_guard<mutex> lock(mtx);
+            records[i] = g;
+            if (aDiff > 0) ++win; else if (aDiff < 0) ++loss; else ++draw;
+            if (++done % 100 == 0 || done == games) {
+                double s = (win + draw * 0.5) / done;
+                fprintf(stderr, "  %d/%d  +%d =%d -%d  score=%.3f\n", done, games, win, draw, loss, s);
+            }
+        }
+        lock_guard<mutex> lock(mtx);
+        for (int k = 0; k < 2; ++k) {
+            total[k].nodes += local[k].nodes;
+            total[k].seconds += local[k].seconds;
+            total[k].latencyMs.insert(total[k].latencyMs.end(), local[k].latencyMs.begin(), local[k].latencyMs.end());
+            total[k].depthSum += local[k].depthSum;
+            total[k].searched += local[k].searched;
+        }
+    };
+    vector<thread> pool;
+    for (int w = 0; w < workers; ++w) pool.emplace_back(worker);
+    for (thread& t : pool) t.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // A から見た成績。誤差は1局ごとの得点の標準偏差から求めた 95% 区間
+    int n = win + draw + loss;
+    double s = n ? (win + draw * 0.5) / n : 0.5;
+    double var = n ? (win * pow(1 - s, 2) + draw * pow(0.5 - s, 2) + loss * pow(s, 2)) / n : 0;
+    double margin = n ? 1.96 * sqrt(var / n) : 0;
+    double elo = eloFromScore(s);
+    double eloErr = (eloFromScore(s + margin) - eloFromScore(s - margin)) / 2;
+
+    printf("\nA vs B: +%d =%d -%d  (score %.1f%%)\n", win, draw, loss, s * 100);
+    printf("Elo(A-B): %+.1f +/- %.1f (95%%)\n", elo, eloErr);
+    printEngine("A", spec[0], total[0]);
+    printEngine("B", spec[1], total[1]);
+    printf("elapsed %.1fs (%.2f games/s)\n", elapsed, n / elapsed);
+
+    if (!outFile.empty()) {
+        ofstream out(outFile);
+        for (const GameRecord& g : records) out << g.moves << " " << g.blackDiff << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,309 @@
+// reversi_bench.cpp - 探索の再現性と速さの回帰ベンチマーク
+// 序盤・中盤・終盤の決まった局面を、1スレッド・決まった深さ（終盤は読み切り）で探索し、
+// 最善手・評価値・ノード数・時間を記録する。AI 同士の決まった手数の対局も1局通して再生する。
+// 保存した基準ファイル（baseline）と比べ、最善手・評価値・ノード数が1つでも違うか、
+// 合計時間が閾値より遅くなったら FAILED で終わる（終了コード 1）。
+// 探索を速くする変更が、結果を変えずに本当に速くなったかを確かめるのに使う。
+//
+// 1スレッドの探索は時間にも乱数にもよらないので、同じ設定なら何度回してもノード数まで一致する
+// （計測の回ごとに置換表を空にする。回によって違えば NONDETERMINISTIC として失敗）。
+// 評価の重みと ProbCut の予測式は、カレントディレクトリのファイルに左右されないよう既定では組み込みの値を使う。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_bench.cpp -o reversi_bench
+// 例:     ./reversi_bench --save reversi_bench.baseline      （変更前に基準を作る）
+//         ./reversi_bench                                    （変更後に基準と比べる）
+//
+// オプション:
+//   --baseline <file>   比べる基準（既定 reversi_bench.baseline。なければ比べずに結果だけ出す）
+//   --save <file>       今回の結果を基準として書き出す（--baseline と同じファイルなら比べてから上書き）
+//   --threshold <%>     合計時間がこれより遅くなったら失敗（既定 10）
+//   --reps <n>          局面ごとの計測の回数（一番速い回の時間を使う。既定 3）
+//   --hash <MB>         置換表の大きさ（既定 16。ノード数が変わるので基準と揃える）
+//   --sel <0〜5>        ProbCut の選択度（既定 3）
+//   --weights <file>    評価の重み（既定は組み込みの重み）
+//   --probcut <file>    ProbCut の予測式（既定は組み込みの値）
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../reversi_core/search.hpp"
+using namespace std;
+
+// 局面は初期局面からの棋譜で表す。depth は探索の深さ（0 なら読み切り）
+struct BenchPosition {
+    const char* name;
+    const char* moves;
+    int depth;
+};
+static const BenchPosition CORPUS[] = {
+    {"open1", "e6f4f3f2c3c4e3f6g5b2g6e2", 11},
+    {"open2", "e6f4e3f2g4g5g3e7f7g7f3d6", 11},
+    {"open3", "c4c5f6d3b5f5c3c6e2a5e3f1", 11},
+    {"mid1", "c4e3f4c5d2b4e6f3c3e1b2d3c6g5e2f5c1d6a4a5g2a3d1f2g4e7c2a1h5c7", 10},
+    {"mid2", "f5f6d3c5b6e3g7g5f2e2h4f7d2h7e7d7d8a7f3h5c7b7e6d1e8g1a5g4c2b3", 10},
+    {"mid3", "c4c3c2e3d3b3f4b1f5c5a2a4b5e6f7g4h3a3e2b6c1f2c6b4g2g6g5g8a6b7", 10},
+    {"end20a", "e6d6c5b4c3d3c7d2c6e7c4f6e3e2d7b5g6b8e1f7g7h8c2f8g8c1e8d1b1d8a6a5a4f5b3h6g5g4f4g3", 0},
+    {"end20b", "f5f6e6f4g5h6d3c3g6g7b3e7h8c4h4g8e3f2d8e2b4b2f1a3g2e1d1g4c5e8f8h2h3h5g1a4c2d6d7d2", 0},
+    {"end18", "c4c5e6e3c3c2b3a4e2f6a2f2g2e1d2a3c6c7d3g1b7a1c8f1b4b5b2h2b6a7d6d8e8d1a5f4f3a8b1a6g5f5", 0},
+    {"end16", "d3c3f5f4f3e3c2d6b2c5d7b3a3g5h6h5e6f7b6h7g4g3h4d2f6g2e2d1g8g6h3h2f2c7c6c4b4e7g1a5g7c1b5a4", 0},
+};
+
+// AI 同士の対局の再生：開始局面から両者とも深さ depth で終局まで打つ（置換表は対局の中で使い回す）
+static const BenchPosition REPLAY[] = {
+    {"game1", "f5d6c3d3c4", 6},
+    {"game2", "f5f6e6f4e3", 6},
+};
+static const int REPLAY_EXACT = 14; // 対局の再生で読み切りを始める空きマス数
+
+struct BenchResult {
+    string name;
+    int depth = 0;      // 完了した深さ（読み切りなら空きマス数。対局の再生なら指定の深さ）
+    string move;        // 最善手（対局の再生なら打った手の棋譜）
+    int score = 0;      // 評価値（対局の再生なら黒から見た最終石差）
+    uint64_t nodes = 0;
+    double seconds = 0;
+
+    bool sameResult(const BenchResult& o) const {
+        return depth == o.depth && move == o.move && score == o.score && nodes == o.nodes;
+    }
+};
+
+double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+// 1局面を reps 回探索して一番速い回の時間を取る。回によって結果が違えば false
+bool benchPosition(Searcher& s, const BenchPosition& bp, int reps, BenchResult& out) {
+    Board b; char turn;
+    playTranscript(bp.moves, b, turn);
+    bool same = true;
+    for (int rep = 0; rep < reps; ++rep) {
+        s.newGame();
+        s.limits.maxDepth = bp.depth > 0 ? bp.depth : 60;
+        s.limits.exactEmpties = bp.depth > 0 ? 0 : N*N;
+        s.limits.wldEmpties = bp.depth > 0 ? 0 : N*N;
+        auto t0 = chrono::steady_clock::now();
+        SearchResult r = s.search(b.own(turn), b.opp(turn));
+        double sec = secondsSince(t0);
+        BenchResult cur;
+        cur.name = bp.name;
+        cur.depth = r.depth;
+        cur.move = squareName(r.bestSq);
+        cur.score = r.score;
+        cur.nodes = r.nodes;
+        cur.seconds = sec;
+        if (rep == 0) out = cur;
+        else {
+            same = same && cur.sameResult(out);
+            out.seconds = min(out.seconds, sec);
+        }
+    }
+    return same;
+}
+
+BenchResult playOnce(Searcher& s, const BenchPosition& bp) {
+    Board b; char turn;
+    playTranscript(bp.moves, b, turn);
+    uint64_t P = b.own(turn), O = b.opp(turn);
+    bool blackToMove = turn == BLACK;
+    s.newGame();
+    s.limits.maxDepth = bp.depth;
+    s.limits.exactEmpties = REPLAY_EXACT;
+    s.limits.wldEmpties = REPLAY_EXACT;
+    BenchResult out;
+    out.name = bp.name;
+    out.depth = bp.depth;
+    auto t0 = chrono::steady_clock::now();
+    for (;;) {
+        uint64_t m = movesBits(P, O);
+        if (!m) {
+            if (!movesBits(O, P)) break;
+            swap(P, O);
+            blackToMove = !blackToMove;
+            continue;
+        }
+        SearchResult r = s.search(P, O);
+        out.nodes += r.nodes;
+        out.move += squareName(r.bestSq);
+        uint64_t f = flipsBits(P, O, r.bestSq);
+        uint64_t np = O ^ f, no = P | f | bitOf(r.bestSq);
+        P = np; O = no;
+        blackToMove = !blackToMove;
+    }
+    out.seconds = secondsSince(t0);
+    int diff = popcount64(P) - popcount64(O);
+    out.score = blackToMove ? diff : -diff;
+    return out;
+}
+
+bool benchReplay(Searcher& s, const BenchPosition& bp, int reps, BenchResult& out) {
+    bool same = true;
+    for (int rep = 0; rep < reps; ++rep) {
+        BenchResult cur = playOnce(s, bp);
+        if (rep == 0) out = cur;
+        else {
+            same = same && cur.sameResult(out);
+            out.seconds = min(out.seconds, cur.seconds);
+        }
+    }
+    return same;
+}
+
+// 基準ファイル：'#' で始まる行は注釈。"config ..." の行に設定、残りは1行1局面
+//   <name> <depth> <move> <score> <nodes> <seconds>
+bool loadBaseline(const string& path, string& config, map<string, BenchResult>& out) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (line.compare(0, 7, "config ") == 0) { config = line.substr(7); continue; }
+        istringstream ss(line);
+        BenchResult r;
+        if (ss >> r.name >> r.depth >> r.move >> r.score >> r.nodes >> r.seconds) out[r.name] = r;
+    }
+    return true;
+}
+
+bool saveBaseline(const string& path, const string& config, const vector<BenchResult>& results) {
+    ofstream out(path);
+    if (!out) return false;
+    out << "# reversi_bench baseline: name depth move score nodes seconds\n";
+    out << "config " << config << "\n";
+    char buf[64];
+    for (const BenchResult& r : results) {
+        snprintf(buf, sizeof(buf), "%.6f", r.seconds);
+        out << r.name << " " << r.depth << " " << r.move << " " << r.score << " " << r.nodes << " " << buf << "\n";
+    }
+    return (bool)out;
+}
+
+int main(int argc, char** argv) {
+    string baselineFile = "reversi_bench.baseline", saveFile, weightsFile, probcutFile;
+    double threshold = 10;
+    int reps = 3, hashMb = 16, sel = 3;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--baseline")       baselineFile = argv[++i];
+        else if (a == "--save")      saveFile = argv[++i];
+        else if (a == "--threshold") threshold = atof(argv[++i]);
+        else if (a == "--reps")      reps = max(1, atoi(argv[++i]));
+        else if (a == "--hash")      hashMb = max(1, atoi(argv[++i]));
+        else if (a == "--sel")       sel = max(0, min(SELECTIVITY_LEVELS - 1, atoi(argv[++i])));
+        else if (a == "--weights")   weightsFile = argv[++i];
+        else if (a == "--probcut")   probcutFile = argv[++i];
+    }
+    if (!weightsFile.empty() && !patternWeights().load(weightsFile)) {
+        fprintf(stderr, "cannot load weights: %s\n", weightsFile.c_str());
+        return 2;
+    }
+    if (!probcutFile.empty() && !probcutParams().load(probcutFile)) {
+        fprintf(stderr, "cannot load probcut: %s\n", probcutFile.c_str());
+        return 2;
+    }
+    // ノード数を左右する設定。基準と違えば比べられない
+    string config = "hash=" + to_string(hashMb) + " sel=" + to_string(sel) +
+                    " weights=" + (weightsFile.empty() ? "builtin" : weightsFile) +
+                    " probcut=" + (probcutFile.empty() ? "builtin" : probcutFile);
+
+    string baseConfig;
+    map<string, BenchResult> base;
+    bool haveBase = loadBaseline(baselineFile, baseConfig, base);
+    if (haveBase && baseConfig != config) {
+        fprintf(stderr, "baseline %s was made with different settings:\n  baseline: %s\n  now:      %s\n",
+                baselineFile.c_str(), baseConfig.c_str(), config.c_str());
+        return 2;
+    }
+    printf("config %s reps=%d\n", config.c_str(), reps);
+    if (haveBase) printf("baseline %s (threshold %.1f%%)\n", baselineFile.c_str(), threshold);
+    else printf("no baseline (%s); results only\n", baselineFile.c_str());
+
+    Searcher s;
+    s.setHashSize(hashMb);
+    s.recordLatency = false;
+    s.limits.timeMs = 0;
+    s.limits.maxNodes = 0;
+    s.limits.threads = 1;
+    s.limits.selectivity = sel;
+
+    printf("\n%-8s %5s %6s %10s %12s %9s %9s %7s\n", "name", "depth", "move", "score", "nodes", "sec",
+           "base sec", "ratio");
+    vector<BenchResult> results;
+    int failures = 0;
+    double total = 0, matched = 0, baseTotal = 0; // matched は基準にもある局面だけの合計
+    uint64_t totalNodes = 0;
+    auto report = [&](const BenchResult& r, bool deterministic, bool replay) {
+        results.push_back(r);
+        total += r.seconds;
+        totalNodes += r.nodes;
+        string status;
+        if (!deterministic) { status = "NONDETERMINISTIC"; ++failures; }
+        auto it = base.find(r.name);
+        char baseSec[16] = "-", ratio[16] = "-";
+        if (haveBase && it == base.end()) status += status.empty() ? "(new)" : " (new)";
+        if (it != base.end()) {
+            const BenchResult& b = it->second;
+            matched += r.seconds;
+            baseTotal += b.seconds;
+            snprintf(baseSec, sizeof(baseSec), "%.3f", b.seconds);
+            if (b.seconds > 0) snprintf(ratio, sizeof(ratio), "%.2f", r.seconds / b.seconds);
+            if (!r.sameResult(b)) {
+                ++failures;
+                status += status.empty() ? "DIFFERS" : " DIFFERS";
+                char buf[160];
+                snprintf(buf, sizeof(buf), " (baseline depth=%d score=%d nodes=%llu%s%s)", b.depth, b.score,
+                         (unsigned long long)b.nodes, replay ? "" : " move=", replay ? "" : b.move.c_str());
+                status += buf;
+            }
+        }
+        string shown = replay ? to_string(r.move.size() / 2) + "mv" : r.move;
+        string sc = replay ? (r.score > 0 ? "+" : "") + to_string(r.score) : scoreText(r.score);
+        printf("%-8s %5d %6s %10s %12llu %9.3f %9s %7s %s\n", r.name.c_str(), r.depth, shown.c_str(), sc.c_str(),
+               (unsigned long long)r.nodes, r.seconds, baseSec, ratio, status.c_str());
+        if (replay && it != base.end() && r.move != it->second.move)
+            printf("         moves    %s\n         baseline %s\n", r.move.c_str(), it->second.move.c_str());
+        fflush(stdout);
+    };
+    for (const BenchPosition& bp : CORPUS) {
+        BenchResult r;
+        bool ok = benchPosition(s, bp, reps, r);
+        report(r, ok, false);
+    }
+    for (const BenchPosition& bp : REPLAY) {
+        BenchResult r;
+        bool ok = benchReplay(s, bp, reps, r);
+        report(r, ok, true);
+    }
+    for (const auto& kv : base) {
+        bool found = false;
+        for (const BenchResult& r : results) found = found || r.name == kv.first;
+        if (!found) printf("%-8s missing (in baseline only)\n", kv.first.c_str());
+    }
+
+    printf("\ntotal %llu nodes %.3f sec (%.0f nps)", (unsigned long long)totalNodes, total,
+           total > 0 ? totalNodes / total : 0);
+    if (haveBase && baseTotal > 0) {
+        double change = (matched / baseTotal - 1) * 100;
+        printf(", baseline %.3f sec (%+.1f%%)", baseTotal, change);
+        if (change > threshold) {
+            ++failures;
+            printf(" SLOWER (threshold %.1f%%)", threshold);
+        }
+    }
+    printf("\n");
+
+    if (!saveFile.empty()) {
+        if (!saveBaseline(saveFile, config, results)) {
+            fprintf(stderr, "cannot write %s\n", saveFile.c_str());
+            return 2;
+        }
+        printf("saved %s\n", saveFile.c_str());
+    }
+    printf("\n%s\n", failures ? "FAILED" : "all ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+// reversi_book.cpp - 定石ファイル（reversi.book）を作る・広げるツール
+// 初期局面から全変化を数手ぶん展開した局面と、棋譜（自己対局の記録など）の序盤に出てきた局面を集め、
+// 末端の局面を探索で評価して、そこから上の局面へ negamax で評価値を戻して書き出す。
+// 子局面を集めた局面では、集めていない手（定石の外へ出る手）も探索し、一番よいものを末端として加える。
+// こうすると1局の棋譜にしか出てこない悪い手も、定石の外のよりよい手と比べて戻される（pick もその手を選べる）。
+// 既存の定石を --in で渡すと、今回作らなかった局面はそのまま引き継ぐ。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_book.cpp -o reversi_book
+// 例:     ./reversi_book --expand-plies 6 --games games.txt --game-plies 16 --depth 10 --out reversi.book
+//         （games.txt は reversi_arena --out の出力。1行1局で "棋譜 [石差]"）
+//
+// オプション:
+//   --out <file>          書き出す定石ファイル（既定 reversi.book）
+//   --in <file>           引き継ぐ既存の定石ファイル
+//   --expand-plies <n>    初期局面から全変化を展開する手数（既定 4）
+//   --games <file>        棋譜ファイル
+//   --game-plies <n>      棋譜から取り込む手数（既定 20）
+//   --depth <d> / --time <ms>   末端局面の評価に使う探索（既定 depth 10）
+//   --workers <n>         末端局面を並列に評価するスレッド数（既定はコア数）
+//   --weights <file>      探索に使う評価の重み（既定 reversi.weights。なければ組み込みの重み）
+//   --probe <棋譜>        できた定石で、その局面の定石手を表示する（確認用）
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/book.hpp"
+#include "../reversi_core/search.hpp"
+using namespace std;
+
+struct Node {
+    uint64_t P = 0, O = 0;   // 手番側・相手側（正規化済み）
+    int score = 0;           // 探索スコア（手番側から見る）
+    int depth = 0;
+    uint32_t games = 0;
+    bool evaluated = false;
+};
+
+unordered_map<uint64_t, Node> nodes;
+
+Node& addPosition(uint64_t P, uint64_t O) {
+    canonicalize(P, O);
+    Node& n = nodes[hashOf(P, O).h];
+    n.P = P; n.O = O;
+    return n;
+}
+
+// 手番側が打てなければパスした局面を返す（終局なら false）
+bool normalizeTurn(uint64_t& P, uint64_t& O) {
+    if (movesBits(P, O)) return true;
+    if (!movesBits(O, P)) return false;
+    swap(P, O);
+    return true;
+}
+
+void expand(uint64_t P, uint64_t O, int plies) {
+    if (!normalizeTurn(P, O)) return;
+    addPosition(P, O);
+    if (plies == 0) return;
+    for (uint64_t m = movesBits(P, O); m; m &= m - 1) {
+        int sq = lsb64(m);
+        uint64_t f = flipsBits(P, O, sq);
+        expand(O ^ f, P | f | bitOf(sq), plies - 1);
+    }
+}
+
+bool addGame(const string& moves, int plies) {
+    uint64_t P = initialBoard().black, O = initialBoard().white;
+    for (size_t i = 0; i + 1 < moves.size() && (int)(i / 2) <= plies; i += 2) {
+        addPosition(P, O).games++;
+        int c = tolower((unsigned char)moves[i]) - 'a', r = moves[i+1] - '1';
+        if (!inBounds(r, c)) return false;
+        int sq = sqOf(r, c);
+        if (!(movesBits(P, O) & bitOf(sq))) return false;
+        uint64_t f = flipsBits(P, O, sq);
+        uint64_t nP = O ^ f, nO = P | f | bitOf(sq);
+        P = nP; O = nO;
+        if (!normalizeTurn(P, O)) break;
+    }
+    return true;
+}
+
+// 子局面（着手後、打てなければパス後）のうち集めたものの key と、子の値を手番側に戻すときの符号
+// （相手がパスして手番が戻ってくる子局面は符号をそのままにする）
+vector<pair<uint64_t, int>> children(uint64_t P, uint64_t O) {
+    vector<pair<uint64_t, int>> out;
+    for (uint64_t m = movesBits(P, O); m; m &= m - 1) {
+        int sq = lsb64(m);
+        uint64_t f = flipsBits(P, O, sq);
+        uint64_t cP = O ^ f, cO = P | f | bitOf(sq);
+        int sign = movesBits(cP, cO) ? -1 : 1;
+        if (!normalizeTurn(cP, cO)) continue;
+        uint64_t k = bookKey(cP, cO);
+        if (nodes.count(k)) out.push_back({k, sign});
+    }
+    return out;
+}
+
+// 集めていない子局面（定石の外へ出る手。終局になる手は除く）と、子の値を手番側に戻すときの符号
+struct Exit { uint64_t P, O; int sign; };
+vector<Exit> exits(uint64_t P, uint64_t O) {
+    vector<Exit> out;
+    for (uint64_t m = movesBits(P, O); m; m &= m - 1) {
+        int sq = lsb64(m);
+        uint64_t f = flipsBits(P, O, sq);
+        uint64_t cP = O ^ f, cO = P | f | bitOf(sq);
+        int sign = movesBits(cP, cO) ? -1 : 1;
+        if (!normalizeTurn(cP, cO)) continue;
+        if (!nodes.count(bookKey(cP, cO))) out.push_back({cP, cO, sign});
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    string outFile = "reversi.book", inFile, gamesFile, probe, weightsFile = "reversi.weights";
+    int expandPlies = 4, gamePlies = 20, workers = (int)max(1u, thread::hardware_concurrency());
+    SearchLimits limits;
+    limits.timeMs = 0;
+    limits.maxDepth = 10;
+    limits.exactEmpties = limits.wldEmpties = 0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--out")                outFile = argv[++i];
+        else if (a == "--in")            inFile = argv[++i];
+        else if (a == "--expand-plies")  expandPlies = atoi(argv[++i]);
+        else if (a == "--games")         gamesFile = argv[++i];
+        else if (a == "--game-plies")    gamePlies = atoi(argv[++i]);
+        else if (a == "--depth")         limits.maxDepth = atoi(argv[++i]);
+        else if (a == "--time")          { limits.timeMs = atoi(argv[++i]); limits.maxDepth = 60; }
+        else if (a == "--workers")       workers = max(1, atoi(argv[++i]));
+        else if (a == "--probe")         probe = argv[++i];
+        else if (a == "--weights")       weightsFile = argv[++i];
+    }
+
+    if (!probe.empty()) {
+        OpeningBook book;
+        if (!book.open(outFile)) { cerr << outFile << " を開けません\n"; return 1; }
+        Board b; char turn;
+        if (!playTranscript(probe, b, turn)) { cerr << "不正な棋譜: " << probe << "\n"; return 1; }
+        int sq, score;
+        auto t0 = chrono::steady_clock::now();
+        bool hit = book.pick(b.own(turn), b.opp(turn), sq, score);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+        if (hit) printf("%s: %s score=%d (%.1fus, %zu entries)\n", probe.c_str(), squareName(sq).c_str(), score, us, book.size());
+        else printf("%s: 定石なし (%.1fus)\n", probe.c_str(), us);
+        return 0;
+    }
+
+    if (patternWeights().load(weightsFile)) printf("weights: %s\n", weightsFile.c_str());
+    if (probcutParams().load("reversi.probcut")) printf("probcut: reversi.probcut\n");
+
+    // 1) 局面を集める
+    Board start = initialBoard();
+    expand(start.black, start.white, expandPlies);
+    size_t fromExpand = nodes.size();
+    if (!gamesFile.empty()) {
+        ifstream in(gamesFile);
+        string line;
+        int games = 0, bad = 0;
+        while (getline(in, line)) {
+            string moves = line.substr(0, line.find(' '));
+            if (moves.empty() || moves[0] == '#') continue;
+            if (addGame(moves, gamePlies)) ++games; else ++bad;
+        }
+        printf("games: %d (bad %d)\n", games, bad);
+    }
+    printf("positions: %zu (expand %zu, games %zu)\n", nodes.size(), fromExpand, nodes.size() - fromExpand);
+
+    // 2) 末端（子局面を1つも集めていない局面）と、子局面を集めた局面から定石の外へ出る手を探索で評価する
+    struct Job {
+        uint64_t P, O;
+        bool leaf;         // 末端なら true、定石の外へ出る手なら false
+        uint64_t parent;   // 定石の外へ出る手の親の key
+        int sign;          // 子の値を親の手番側に戻すときの符号
+        int score = 0, depth = 0;
+    };
+    vector<Job> jobs;
+    size_t leafCount = 0;
+    for (auto& kv : nodes) {
+        const Node& n = kv.second;
+        if (children(n.P, n.O).empty()) {
+            jobs.push_back({n.P, n.O, true, 0, 1});
+            ++leafCount;
+        } else {
+            for (const Exit& e : exits(n.P, n.O)) jobs.push_back({e.P, e.O, false, kv.first, e.sign});
+        }
+    }
+    printf("positions to search: %zu (leaves %zu, moves leaving the book %zu, workers=%d)\n", jobs.size(),
+           leafCount, jobs.size() - leafCount, workers);
+
+    atomic<size_t> next{0};
+    mutex mtx;
+    auto t0 = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (int w = 0; w < workers; ++w) {
+        pool.emplace_back([&]() {
+            Searcher s;
+            s.limits = limits;
+            s.setHashSize(8);
+            for (size_t i; (i = next.fetch_add(1)) < jobs.size();) {
+                Job& j = jobs[i];
+                SearchResult r = s.search(j.P, j.O);
+                j.score = r.score;
+                j.depth = r.depth;
+                if ((i + 1) % 1000 == 0) {
+                    lock_guard<mutex> lock(mtx);
+                    fprintf(stderr, "  %zu/%zu\n", i + 1, jobs.size());
+                }
+            }
+        });
+    }
+    for (thread& t : pool) t.join();
+    printf("search: %.1fs\n", chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+
+    // 末端には値を入れ、定石の外へ出る手は親ごとに一番よいものだけを末端として加える
+    unordered_map<uint64_t, const Job*> bestExit;
+    for (const Job& j : jobs) {
+        if (j.leaf) {
+            Node& n = nodes.at(bookKey(j.P, j.O));
+            n.score = j.score;
+            n.depth = j.depth;
+            n.evaluated = true;
+            continue;
+        }
+        const Job*& b = bestExit[j.parent];
+        if (!b || j.sign * j.score > b->sign * b->score) b = &j;
+    }
+    for (auto& kv : bestExit) {
+        const Job& j = *kv.second;
+        Node& n = addPosition(j.P, j.O);
+        if (n.evaluated) continue; // 別の親からも同じ局面に出る
+        n.score = j.score;
+        n.depth = j.depth;
+        n.evaluated = true;
+    }
+    printf("moves leaving the book added: %zu\n", bestExit.size());
+
+    // 3) 石の多い（深い）局面から順に、子局面の値を negamax で戻す
+    vector<uint64_t> order;
+    for (auto& kv : nodes) if (!kv.second.evaluated) order.push_back(kv.first);
+    sort(order.begin(), order.end(), [](uint64_t a, uint64_t b) {
+        const Node& x = nodes[a]; const Node& y = nodes[b];
+        return popcount64(x.P | x.O) > popcount64(y.P | y.O);
+    });
+    for (uint64_t k : order) {
+        Node& n = nodes[k];
+        int best = -SCORE_INF;
+        for (auto& c : children(n.P, n.O)) best = max(best, c.second * nodes[c.first].score);
+        n.score = best;
+        n.depth = 0;
+        n.evaluated = true;
+    }
+
+    // 4) 書き出す（既存の定石は今回の局面で上書き）
+    vector<BookEntry> entries;
+    OpeningBook old;
+    if (!inFile.empty() && old.open(inFile)) {
+        entries.assign(old.begin(), old.end());
+        printf("merged: %zu entries from %s\n", old.size(), inFile.c_str());
+    }
+    for (auto& kv : nodes) {
+        BookEntry e{};
+        e.key = kv.first;
+        e.score = toBookScore(kv.second.score);
+        e.depth = (uint8_t)kv.second.depth;
+        e.games = kv.second.games;
+        entries.push_back(e);
+    }
+    if (!writeBook(outFile, entries)) { cerr << outFile << " に書き込めません\n"; return 1; }
+    OpeningBook check;
+    check.open(outFile);
+    printf("wrote %s: %zu entries (%zu bytes)\n", outFile.c_str(), check.size(), sizeof(BookHeader) + check.size() * sizeof(BookEntry));
+    return 0;
+}
@@ -0,0 +1,137 @@
+// analysis.hpp - 検討モード：全ての合法手を裏で読み続け、手ごとの評価値と深さを出す（multi-PV）
+// 局面を start() すると、作業スレッドが「深さ d の手 i」の仕事を d の浅い順に取り合って、
+// それぞれの手を打った後の局面を深さ d-1 で読む（反復深化。各スレッドの Searcher の置換表が前の深さを覚えている）。
+// 結果は手ごとに深い方だけを残し、更新のたびに version() を増やす。表示側は version() が変わったときだけ
+// snapshot() で写しを取ればよく、描画スレッドで探索することはない。全部の手を読み切ったら止まる。
+// 読み切りは深さ d-1 が打った後の空きマス数に届いてから始める（それまでは浅い中盤探索の値を先に出す）。
+// 置換表は作業スレッドごとに持つので、メモリは threads × (hashMb + 終盤用の 8MB) ほど使う。
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bitboard.hpp"
+#include "search.hpp"
+
+struct MoveAnalysis {
+    int sq = -1;
+    int score = 0;   // 手番側から見た評価値（search.hpp と同じ単位）
+    int depth = 0;   // 読んだ深さ（この手を含む。読み切ったら空きマス数）
+    int solved = SOLVE_NONE;
+};
+
+class MultiPvAnalysis {
+public:
+    SearchLimits limits;   // 選択度・読み切りを始める空きマス数（持ち時間と深さは使わない）
+    int threads = std::max(1, (int)std::thread::hardware_concurrency() - 1); // 描画スレッドのぶんを残す
+    size_t hashMb = 16;    // 作業スレッド 1 本あたりの置換表（ほかに終盤読み切り用の 8MB）
+
+    ~MultiPvAnalysis() { stop(); }
+
+    // 手番側 P・相手側 O の局面を読み始める（前の局面の検討は止める）
+    void start(uint64_t P, uint64_t O) {
+        stop();
+        rootP = P; rootO = O;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            moves.clear();
+            for (uint64_t m = movesBits(P, O); m; m &= m - 1) {
+                MoveAnalysis a;
+                a.sq = lsb64(m);
+                moves.push_back(a);
+            }
+        }
+        ++ver;
+        if (moves.empty()) return;
+        quit = false;
+        nextJob = 0;
+        while ((int)searchers.size() < threads) {
+            searchers.emplace_back(new Searcher);
+            searchers.back()->setHashSize(hashMb);
+        }
+        running = threads;
+        for (int i = 0; i < threads; ++i) {
+            searchers[i]->newGame();
+            searchers[i]->clearStop();
+            workers.emplace_back([this, i]() { work(*searchers[i]); });
+        }
+    }
+
+    // 検討を止める。戻ったときには作業スレッドは止まっている（結果は残る）
+    void stop() {
+        quit = true;
+        for (auto& s : searchers) s->stop(); // この後に始まる探索もすぐに戻る
+        for (std::thread& t : workers) t.join();
+        workers.clear();
+    }
+
+    bool active() const { return running.load() > 0; }
+    uint64_t version() const { return ver.load(std::memory_order_acquire); }
+
+    // 手ごとの結果の写し（評価値の高い順。まだ読んでいない手は後ろ）
+    std::vector<MoveAnalysis> snapshot() const {
+        std::vector<MoveAnalysis> out;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            out = moves;
+        }
+        std::stable_sort(out.begin(), out.end(), [](const MoveAnalysis& a, const MoveAnalysis& b) {
+            if ((a.depth > 0) != (b.depth > 0)) return a.depth > 0;
+            return a.score > b.score;
+        });
+        return out;
+    }
+
+private:
+    uint64_t rootP = 0, rootO = 0;
+    mutable std::mutex mtx;
+    std::vector<MoveAnalysis> moves;
+    std::atomic<uint64_t> ver{0};
+    std::atomic<bool> quit{true};
+    std::atomic<int> running{0};
+    std::atomic<int> nextJob{0};
+    std::vector<std::unique_ptr<Searcher>> searchers;
+    std::vector<std::thread> workers;
+
+    void work(Searcher& s) {
+        const int n = (int)moves.size();
+        for (int job; !quit.load() && (job = nextJob.fetch_add(1)) < n * N*N;) {
+            int depth = 1 + job / n, i = job % n, sq;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (moves[i].solved != SOLVE_NONE || moves[i].depth >= depth) continue; // 読み切った手・深く読んだ手は飛ばす
+                sq = moves[i].sq;
+            }
+            MoveAnalysis a;
+            if (!analyzeMove(s, sq, depth, a) || quit.load()) continue;
+            std::lock_guard<std::mutex> lock(mtx);
+            MoveAnalysis& cur = moves[i];
+            if (a.depth > cur.depth || a.solved > cur.solved) {
+                cur = a;
+                ver.fetch_add(1, std::memory_order_release);
+            }
+        }
+        running.fetch_sub(1);
+    }
+
+    // sq を打った後の局面を深さ depth-1 で読む（パス・1手しかない局面・終局は searchMove が扱い、深さにも数える）
+    bool analyzeMove(Searcher& s, int sq, int depth, MoveAnalysis& out) {
+        s.limits = limits;
+        s.limits.timeMs = 0;
+        s.limits.maxNodes = 0;
+        s.limits.maxDepth = depth;
+        s.limits.threads = 1;
+        if (depth - 1 < N*N - popcount64(rootP | rootO) - 1) s.limits.exactEmpties = s.limits.wldEmpties = 0; // まだ浅いので読み切らない
+        s.recordLatency = false;
+        SearchResult r = s.searchMove(rootP, rootO, sq);
+        if (r.depth == 0) return false; // 打ち切られた
+        out.sq = sq;
+        out.score = r.score;
+        out.depth = r.depth;
+        out.solved = r.solved;
+        return true;
+    }
+};
@@ -0,0 +1,130 @@
+// async_ai.hpp - 探索を別スレッドで動かす AI（GUI から使う）
+// 描画ループを止めないよう探索はバックグラウンドで走らせ、結果は future で受け取る。
+// 途中経過（深さ・評価値）は progress() でいつでも読める。
+// 人間の手番中は、人間の予想手を打った後の局面を先読み（ponder）して置換表を温めておく。
+// book を設定しておくと、定石にある局面では探索せずに定石手を返す。
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include "bitboard.hpp"
+#include "book.hpp"
+#include "search.hpp"
+
+class AsyncSearch {
+public:
+    Searcher searcher;
+    SearchLimits limits;        // 通常の探索に使う持ち時間など（searcher.limits は探索ごとに上書きする）
+    bool ponderEnabled = true;
+    const OpeningBook* book = nullptr;
+
+    AsyncSearch() {
+        searcher.onIteration = [this](const SearchResult& r) {
+            std::lock_guard<std::mutex> lock(mtx);
+            live = r;
+        };
+    }
+    ~AsyncSearch() { cancel(); }
+    AsyncSearch(const AsyncSearch&) = delete;
+    AsyncSearch& operator=(const AsyncSearch&) = delete;
+
+    // 手番側 P・相手側 O の局面の探索を始める（先読み中なら打ち切ってから）
+    void start(uint64_t P, uint64_t O) {
+        bool hit = isPondering && P == ponderP && O == ponderO;
+        cancel();
+        ponderHit = hit;
+        int sq, score;
+        bookHit = book && book->pick(P, O, sq, score);
+        if (bookHit) {
+            // 定石手はすぐ ready() になる future で返す
+            SearchResult r;
+            r.bestSq = sq;
+            r.score = score;
+            std::promise<SearchResult> done;
+            done.set_value(r);
+            isPondering = false;
+            job = done.get_future();
+            return;
+        }
+        launch(P, O, limits, false);
+    }
+
+    // 人間（手番側 P）が考えている間に、予想手を打った後の局面を時間無制限で読んでおく
+    void ponder(uint64_t P, uint64_t O) {
+        cancel();
+        if (!ponderEnabled) return;
+        int sq = predictReply(P, O);
+        if (sq < 0) return;
+        uint64_t f = flipsBits(P, O, sq);
+        SearchLimits l = limits;
+        l.timeMs = 0;
+        l.maxNodes = 0;
+        ponderP = O ^ f;
+        ponderO = P | f | bitOf(sq);
+        ponderSq = sq;
+        launch(ponderP, ponderO, l, true);
+    }
+
+    // 探索（先読みも含む）を打ち切って結果を捨てる。戻ったときには探索スレッドは止まっている
+    void cancel() {
+        if (!job.valid()) return;
+        searcher.stop();
+        job.get();
+        isPondering = false;
+    }
+
+    void newGame() { cancel(); searcher.newGame(); }
+
+    bool busy() const { return job.valid(); }
+    bool pondering() const { return job.valid() && isPondering; }
+    int ponderMove() const { return ponderSq; }
+
+    // 通常の探索が終わっていれば true（先読み中は false）
+    bool ready() const {
+        return job.valid() && !isPondering && job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    // ready() のときに結果を受け取る。lastPonderHit() は直前の探索が先読みの当たりから始まったか
+    SearchResult get() { return job.get(); }
+    bool lastPonderHit() const { return ponderHit; }
+    bool lastBookHit() const { return bookHit; }
+
+    // 最後に完了した反復の結果（探索中の表示用）
+    SearchResult progress() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return live;
+    }
+
+private:
+    std::future<SearchResult> job;
+    mutable std::mutex mtx;
+    SearchResult live;
+    bool isPondering = false, ponderHit = false, bookHit = false;
+    uint64_t ponderP = 0, ponderO = 0;
+    int ponderSq = -1;
+
+    void launch(uint64_t P, uint64_t O, const SearchLimits& l, bool isPonder) {
+        searcher.limits = l;
+        live = SearchResult();
+        isPondering = isPonder;
+        searcher.recordLatency = !isPonder;
+        searcher.clearStop();
+        job = std::async(std::launch::async, [this, P, O]() { return searcher.search(P, O); });
+    }
+
+    // 人間の予想手：直前の探索が置換表に残した最善手。なければ相手の着手可能数が最少の手
+    int predictReply(uint64_t P, uint64_t O) {
+        uint64_t moves = movesBits(P, O);
+        if (!moves) return -1;
+        TTEntry e;
+        if (searcher.tt.probe(hashOf(P, O).h, e) && e.bestSq >= 0 && (moves & bitOf(e.bestSq))) return e.bestSq;
+        int best = -1, bestMob = MAX_MOVES + 1;
+        for (; moves; moves &= moves - 1) {
+            int sq = lsb64(moves);
+            uint64_t f = flipsBits(P, O, sq);
+            int mob = popcount64(movesBits(O ^ f, P | f | bitOf(sq)));
+            if (mob < bestMob) { bestMob = mob; best = sq; }
+        }
+        return best;
+    }
+};
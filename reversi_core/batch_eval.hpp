@@ -0,0 +1,294 @@
+// batch_eval.hpp - 多数の局面をまとめて評価する（学習・解析用）
+// 局面を P[i], O[i] の配列で受け取り、AVX2（4 局面）・SSE4.1（2 局面）のレーンに並べて、合法手生成・
+// popcount・パターン index の計算を複数の盤で同時に行う。結果は 1 局面ずつの関数と必ず一致する:
+//   mobilityBatch         = popcount64(movesBits(P, O))
+//   evaluateBatch         = evaluate(P, O)          （eval.hpp）
+//   evaluatePatternsBatch = evaluatePatterns(P, O)  （pattern.hpp）
+//
+// 命令セットは実行時に CPU を調べて選ぶ（-mavx2 を付けずにビルドしても AVX2 の版が入る）。
+// ISA_SCALAR は 1 局面ずつの関数をそのまま呼ぶもので、x86 以外ではこれだけになる。
+// パターンの重み表（int16）を引くところは gather にしても速くならないので、どの版も 1 つずつ引く。
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "bitboard.hpp"
+#include "eval.hpp"
+#include "pattern.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_EVAL_X86 1
+#include <immintrin.h>
+// 関数ごとに命令セットを指定する。カーネル本体は flatten でラッパに全部展開し、ラッパの命令セットで生成させる
+#define BATCH_TARGET_AVX2  __attribute__((target("avx2")))
+#define BATCH_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define BATCH_FLATTEN      __attribute__((flatten))
+#endif
+
+enum EvalIsa { ISA_SCALAR, ISA_SSE41, ISA_AVX2, ISA_COUNT };
+static const char* const ISA_NAMES[ISA_COUNT] = {"scalar", "sse4.1", "avx2"};
+
+inline bool isaSupported(EvalIsa isa) {
+    if (isa == ISA_SCALAR) return true;
+#ifdef BATCH_EVAL_X86
+    __builtin_cpu_init();
+    if (isa == ISA_SSE41) return __builtin_cpu_supports("sse4.1");
+    if (isa == ISA_AVX2) return __builtin_cpu_supports("avx2");
+#endif
+    return false;
+}
+
+inline EvalIsa bestEvalIsa() {
+    static const EvalIsa best = isaSupported(ISA_AVX2) ? ISA_AVX2 : isaSupported(ISA_SSE41) ? ISA_SSE41 : ISA_SCALAR;
+    return best;
+}
+
+// パターン評価の入力（evaluatePatterns が盤面から求めるもの）。表を引く前の形なので学習にもそのまま使える
+struct PatternFeatures {
+    uint16_t idx[PATTERN_FEATURES]; // 手番側から見た index（PatternState::idx[0] と同じ）
+    int8_t mob;                     // 着手可能数の差（手番側 - 相手）
+    int8_t empties;                 // 空きマス数
+
+    int phase() const {
+        int ph = (N*N - empties - 4) / 5;
+        return ph < PATTERN_PHASES - 1 ? ph : PATTERN_PHASES - 1;
+    }
+};
+
+inline void patternFeatures(uint64_t P, uint64_t O, PatternFeatures& out) {
+    PatternState st;
+    st.init(P, O);
+    std::memcpy(out.idx, st.idx[0], sizeof(out.idx));
+    out.mob = (int8_t)(popcount64(movesBits(P, O)) - popcount64(movesBits(O, P)));
+    out.empties = (int8_t)popcount64(~(P | O));
+}
+
+// evaluatePatterns(st, P, O, w) と同じ式
+inline int evaluateFeatures(const PatternFeatures& x, const PatternWeights& w) {
+    const PatternLayout& L = patternLayout();
+    int phase = x.phase();
+    const int16_t* table = w.phaseTable(phase);
+    int s = 0;
+    for (int f = 0; f < PATTERN_FEATURES; ++f) s += table[L.featureOffset[f] + x.idx[f]];
+    s += x.mob * w.mobility[phase];
+    if (x.empties & 1) s += w.parity[phase];
+    return s > PATTERN_EVAL_MAX ? PATTERN_EVAL_MAX : s < -PATTERN_EVAL_MAX ? -PATTERN_EVAL_MAX : s;
+}
+
+#ifdef BATCH_EVAL_X86
+namespace batch_detail {
+
+// 64bit のレーンごとの演算。カーネルは Ops を差し替えて AVX2 と SSE4.1 で共有する。
+// カーネルは命令セットを指定しない関数なので、V は __m256i / __m128i ではなくレーンの配列にして
+// ベクトル型を値で受け渡さない（受け渡すと ABI が変わる -Wpsabi の警告になる）。ラッパに展開されると
+// 配列の読み書きは消えてレジスタのままになる
+struct Avx2Ops {
+    struct alignas(32) V { uint64_t lane[4]; };
+    static const int LANES = 4;
+#define BATCH_GET(v)    _mm256_load_si256((const __m256i*)(v).lane)
+#define BATCH_PUT(r, x) _mm256_store_si256((__m256i*)(r).lane, (x))
+    BATCH_TARGET_AVX2 static V load(const uint64_t* p) { V r; BATCH_PUT(r, _mm256_loadu_si256((const __m256i*)p)); return r; }
+    BATCH_TARGET_AVX2 static V set1(uint64_t x) { V r; BATCH_PUT(r, _mm256_set1_epi64x((long long)x)); return r; }
+    BATCH_TARGET_AVX2 static V andV(const V& a, const V& b) { V r; BATCH_PUT(r, _mm256_and_si256(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_AVX2 static V orV(const V& a, const V& b) { V r; BATCH_PUT(r, _mm256_or_si256(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_AVX2 static V andNot(const V& a, const V& b) { V r; BATCH_PUT(r, _mm256_andnot_si256(BATCH_GET(a), BATCH_GET(b))); return r; } // ~a & b
+    BATCH_TARGET_AVX2 static V add(const V& a, const V& b) { V r; BATCH_PUT(r, _mm256_add_epi64(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_AVX2 static V sub(const V& a, const V& b) { V r; BATCH_PUT(r, _mm256_sub_epi64(BATCH_GET(a), BATCH_GET(b))); return r; }
+    template <int S> BATCH_TARGET_AVX2 static V shift(const V& v) {
+        V r;
+        if constexpr (S > 0) BATCH_PUT(r, _mm256_slli_epi64(BATCH_GET(v), S)); else BATCH_PUT(r, _mm256_srli_epi64(BATCH_GET(v), -S));
+        return r;
+    }
+    // 下位 32bit を符号付きとして掛ける（石数の差 × 重み）
+    BATCH_TARGET_AVX2 static V mulSmall(const V& a, int w) { V r; BATCH_PUT(r, _mm256_mul_epi32(BATCH_GET(a), _mm256_set1_epi64x(w))); return r; }
+    // 4bit ずつ表を引いてバイトごとの popcount を作り、sad で 64bit ごとに足す
+    BATCH_TARGET_AVX2 static V popcount(const V& a) {
+        const __m256i lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+        const __m256i v = BATCH_GET(a);
+        __m256i c = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+                                    _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        V r;
+        BATCH_PUT(r, _mm256_sad_epu8(c, _mm256_setzero_si256()));
+        return r;
+    }
+#undef BATCH_GET
+#undef BATCH_PUT
+};
+
+struct Sse41Ops {
+    struct alignas(16) V { uint64_t lane[2]; };
+    static const int LANES = 2;
+#define BATCH_GET(v)    _mm_load_si128((const __m128i*)(v).lane)
+#define BATCH_PUT(r, x) _mm_store_si128((__m128i*)(r).lane, (x))
+    BATCH_TARGET_SSE41 static V load(const uint64_t* p) { V r; BATCH_PUT(r, _mm_loadu_si128((const __m128i*)p)); return r; }
+    BATCH_TARGET_SSE41 static V set1(uint64_t x) { V r; BATCH_PUT(r, _mm_set1_epi64x((long long)x)); return r; }
+    BATCH_TARGET_SSE41 static V andV(const V& a, const V& b) { V r; BATCH_PUT(r, _mm_and_si128(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_SSE41 static V orV(const V& a, const V& b) { V r; BATCH_PUT(r, _mm_or_si128(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_SSE41 static V andNot(const V& a, const V& b) { V r; BATCH_PUT(r, _mm_andnot_si128(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_SSE41 static V add(const V& a, const V& b) { V r; BATCH_PUT(r, _mm_add_epi64(BATCH_GET(a), BATCH_GET(b))); return r; }
+    BATCH_TARGET_SSE41 static V sub(const V& a, const V& b) { V r; BATCH_PUT(r, _mm_sub_epi64(BATCH_GET(a), BATCH_GET(b))); return r; }
+    template <int S> BATCH_TARGET_SSE41 static V shift(const V& v) {
+        V r;
+        if constexpr (S > 0) BATCH_PUT(r, _mm_slli_epi64(BATCH_GET(v), S)); else BATCH_PUT(r, _mm_srli_epi64(BATCH_GET(v), -S));
+        return r;
+    }
+    BATCH_TARGET_SSE41 static V mulSmall(const V& a, int w) { V r; BATCH_PUT(r, _mm_mul_epi32(BATCH_GET(a), _mm_set1_epi64x(w))); return r; }
+    BATCH_TARGET_SSE41 static V popcount(const V& a) {
+        const __m128i lut = _mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m128i low = _mm_set1_epi8(0x0f);
+        const __m128i v = BATCH_GET(a);
+        __m128i c = _mm_add_epi8(_mm_shuffle_epi8(lut, _mm_and_si128(v, low)),
+                                 _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), low)));
+        V r;
+        BATCH_PUT(r, _mm_sad_epu8(c, _mm_setzero_si128()));
+        return r;
+    }
+#undef BATCH_GET
+#undef BATCH_PUT
+};
+
+// movesDir / movesBits（bitboard.hpp）をレーンごとに行う
+template <class Ops, int S>
+inline typename Ops::V movesDirV(const typename Ops::V& P, const typename Ops::V& mO) {
+    typename Ops::V gen = P, pro = mO;
+    gen = Ops::orV(gen, Ops::andV(pro, Ops::template shift<S>(gen)));     pro = Ops::andV(pro, Ops::template shift<S>(pro));
+    gen = Ops::orV(gen, Ops::andV(pro, Ops::template shift<2*S>(gen)));   pro = Ops::andV(pro, Ops::template shift<2*S>(pro));
+    gen = Ops::orV(gen, Ops::andV(pro, Ops::template shift<4*S>(gen)));
+    return Ops::template shift<S>(Ops::andNot(P, gen));
+}
+
+template <class Ops>
+inline typename Ops::V movesV(const typename Ops::V& P, const typename Ops::V& O) {
+    typedef typename Ops::V V;
+    const V h = Ops::andV(O, Ops::set1(MASK_H)), v = Ops::andV(O, Ops::set1(MASK_V)), d = Ops::andV(O, Ops::set1(MASK_D));
+    V m = Ops::orV(Ops::orV(movesDirV<Ops, 1>(P, h), movesDirV<Ops, -1>(P, h)),
+                   Ops::orV(movesDirV<Ops, 8>(P, v), movesDirV<Ops, -8>(P, v)));
+    m = Ops::orV(m, Ops::orV(Ops::orV(movesDirV<Ops, 9>(P, d), movesDirV<Ops, -9>(P, d)),
+                             Ops::orV(movesDirV<Ops, 7>(P, d), movesDirV<Ops, -7>(P, d))));
+    return Ops::andNot(Ops::orV(P, O), m);
+}
+
+template <class Ops>
+inline typename Ops::V mobilityDiffV(const typename Ops::V& P, const typename Ops::V& O) {
+    return Ops::sub(Ops::popcount(movesV<Ops>(P, O)), Ops::popcount(movesV<Ops>(O, P)));
+}
+
+// 以下のカーネルは n が LANES の倍数であることが前提（端数は呼び出し側が 1 局面ずつ処理する）
+template <class Ops>
+inline void mobilityKernel(const uint64_t* P, const uint64_t* O, size_t n, int* out) {
+    for (size_t i = 0; i < n; i += Ops::LANES) {
+        const typename Ops::V c = Ops::popcount(movesV<Ops>(Ops::load(P + i), Ops::load(O + i)));
+        for (int k = 0; k < Ops::LANES; ++k) out[i + k] = (int)c.lane[k];
+    }
+}
+
+template <class Ops>
+inline void evaluateKernel(const uint64_t* P, const uint64_t* O, size_t n, int* out) {
+    typedef typename Ops::V V;
+    const WeightMasks& wm = weightMasks();
+    for (size_t i = 0; i < n; i += Ops::LANES) {
+        V p = Ops::load(P + i), o = Ops::load(O + i);
+        V s = Ops::mulSmall(mobilityDiffV<Ops>(p, o), MOBILITY_WEIGHT);
+        for (int k = 0; k < wm.count; ++k) {
+            V m = Ops::set1(wm.mask[k]);
+            s = Ops::add(s, Ops::mulSmall(Ops::sub(Ops::popcount(Ops::andV(p, m)), Ops::popcount(Ops::andV(o, m))), wm.weight[k]));
+        }
+        for (int k = 0; k < Ops::LANES; ++k) out[i + k] = (int)(int64_t)s.lane[k];
+    }
+}
+
+// マスごとの 3進の桁（空き 0・手番側 1・相手 2）を先に 64 マスぶん作り、各パターンの index は
+// 最後のマスから idx = idx*3 + 桁 で畳み込む（3^0 の桁が先頭のマス）
+template <class Ops>
+inline void featuresKernel(const uint64_t* P, const uint64_t* O, size_t n, PatternFeatures* out) {
+    typedef typename Ops::V V;
+    const PatternLayout& L = patternLayout();
+    const V one = Ops::set1(1);
+    V digit[N*N];
+    for (size_t i = 0; i < n; i += Ops::LANES) {
+        V p = Ops::load(P + i), o = Ops::load(O + i);
+        V pp = p, oo = o;
+        for (int sq = 0; sq < N*N; ++sq) {
+            digit[sq] = Ops::add(Ops::andV(pp, one), Ops::template shift<1>(Ops::andV(oo, one)));
+            pp = Ops::template shift<-1>(pp);
+            oo = Ops::template shift<-1>(oo);
+        }
+        for (int f = 0; f < PATTERN_FEATURES; ++f) {
+            const int* sqs = L.featureSquares[f];
+            V idx = Ops::set1(0); // V を代入で写すと 16 バイトずつの転送になるので 0 から畳み込む
+            for (int k = L.featureLen[f] - 1; k >= 0; --k)
+                idx = Ops::add(Ops::add(Ops::template shift<1>(idx), idx), digit[sqs[k]]);
+            for (int k = 0; k < Ops::LANES; ++k) out[i + k].idx[f] = (uint16_t)idx.lane[k];
+        }
+        const V mob = mobilityDiffV<Ops>(p, o);
+        const V empties = Ops::popcount(Ops::andNot(Ops::orV(p, o), Ops::set1(~0ULL)));
+        for (int k = 0; k < Ops::LANES; ++k) out[i + k].mob = (int8_t)(int64_t)mob.lane[k];
+        for (int k = 0; k < Ops::LANES; ++k) out[i + k].empties = (int8_t)empties.lane[k];
+    }
+}
+
+BATCH_TARGET_AVX2 BATCH_FLATTEN inline void mobilityAvx2(const uint64_t* P, const uint64_t* O, size_t n, int* out) { mobilityKernel<Avx2Ops>(P, O, n, out); }
+BATCH_TARGET_AVX2 BATCH_FLATTEN inline void evaluateAvx2(const uint64_t* P, const uint64_t* O, size_t n, int* out) { evaluateKernel<Avx2Ops>(P, O, n, out); }
+BATCH_TARGET_AVX2 BATCH_FLATTEN inline void featuresAvx2(const uint64_t* P, const uint64_t* O, size_t n, PatternFeatures* out) { featuresKernel<Avx2Ops>(P, O, n, out); }
+BATCH_TARGET_SSE41 BATCH_FLATTEN inline void mobilitySse41(const uint64_t* P, const uint64_t* O, size_t n, int* out) { mobilityKernel<Sse41Ops>(P, O, n, out); }
+BATCH_TARGET_SSE41 BATCH_FLATTEN inline void evaluateSse41(const uint64_t* P, const uint64_t* O, size_t n, int* out) { evaluateKernel<Sse41Ops>(P, O, n, out); }
+BATCH_TARGET_SSE41 BATCH_FLATTEN inline void featuresSse41(const uint64_t* P, const uint64_t* O, size_t n, PatternFeatures* out) { featuresKernel<Sse41Ops>(P, O, n, out); }
+
+} // namespace batch_detail
+#endif
+
+// 対応していない命令セットを指定したときは ISA_SCALAR で計算する
+inline EvalIsa usableIsa(EvalIsa isa) { return isa == ISA_SCALAR || isaSupported(isa) ? isa : ISA_SCALAR; }
+
+// 手番側の合法手の数
+inline void mobilityBatch(const uint64_t* P, const uint64_t* O, size_t n, int* out, EvalIsa isa = bestEvalIsa()) {
+    size_t done = 0;
+#ifdef BATCH_EVAL_X86
+    isa = usableIsa(isa);
+    if (isa == ISA_AVX2)  batch_detail::mobilityAvx2(P, O, done = n & ~(size_t)3, out);
+    if (isa == ISA_SSE41) batch_detail::mobilitySse41(P, O, done = n & ~(size_t)1, out);
+#endif
+    for (size_t i = done; i < n; ++i) out[i] = popcount64(movesBits(P[i], O[i]));
+}
+
+// evaluate(P, O)
+inline void evaluateBatch(const uint64_t* P, const uint64_t* O, size_t n, int* out, EvalIsa isa = bestEvalIsa()) {
+    size_t done = 0;
+#ifdef BATCH_EVAL_X86
+    isa = usableIsa(isa);
+    if (isa == ISA_AVX2)  batch_detail::evaluateAvx2(P, O, done = n & ~(size_t)3, out);
+    if (isa == ISA_SSE41) batch_detail::evaluateSse41(P, O, done = n & ~(size_t)1, out);
+#endif
+    for (size_t i = done; i < n; ++i) out[i] = evaluate(P[i], O[i]);
+}
+
+inline void patternFeaturesBatch(const uint64_t* P, const uint64_t* O, size_t n, PatternFeatures* out,
+                                 EvalIsa isa = bestEvalIsa()) {
+    size_t done = 0;
+#ifdef BATCH_EVAL_X86
+    isa = usableIsa(isa);
+    if (isa == ISA_AVX2)  batch_detail::featuresAvx2(P, O, done = n & ~(size_t)3, out);
+    if (isa == ISA_SSE41) batch_detail::featuresSse41(P, O, done = n & ~(size_t)1, out);
+#endif
+    for (size_t i = done; i < n; ++i) patternFeatures(P[i], O[i], out[i]);
+}
+
+// evaluatePatterns(P, O)。特徴は BATCH_BLOCK 局面ずつ作って、すぐに表を引く
+static const size_t BATCH_BLOCK = 256;
+
+inline void evaluatePatternsBatch(const uint64_t* P, const uint64_t* O, size_t n, int* out,
+                                  const PatternWeights& w = patternWeights(), EvalIsa isa = bestEvalIsa()) {
+    if (usableIsa(isa) == ISA_SCALAR) {
+        PatternState st;
+        for (size_t i = 0; i < n; ++i) { st.init(P[i], O[i]); out[i] = evaluatePatterns(st, P[i], O[i], w); }
+        return;
+    }
+    PatternFeatures feat[BATCH_BLOCK];
+    for (size_t begin = 0; begin < n; begin += BATCH_BLOCK) {
+        size_t len = n - begin < BATCH_BLOCK ? n - begin : BATCH_BLOCK;
+        patternFeaturesBatch(P + begin, O + begin, len, feat, isa);
+        for (size_t i = 0; i < len; ++i) out[begin + i] = evaluateFeatures(feat[i], w);
+    }
+}
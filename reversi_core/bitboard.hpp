@@ -0,0 +1,186 @@
+// bitboard.hpp - オセロの盤面を 64bit ビットボード2枚で表す共通エンジン（ヘッダオンリー）
+// reversi/reversi.cpp と reversi_sfml/reversi_sfml_v3.cpp の両方から使う。
+//
+// マス番号: sq = r*8 + c（a1 = bit0, h8 = bit63）
+// 合法手生成は 8方向の Kogge-Stone 型シフト＆マスクで全合法手を一度に求める。
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+static const int N = 8;
+static const char EMPTY = '.';
+static const char BLACK = 'X'; // 先手
+static const char WHITE = 'O'; // 後手
+
+struct Move { int r, c; }; // r: 0-7 (行:1-8), c: 0-7 (列:a-h)。パスは {-1,-1}
+
+inline bool inBounds(int r, int c) { return r >= 0 && r < N && c >= 0 && c < N; }
+inline char opponent(char p) { return p == BLACK ? WHITE : BLACK; }
+
+inline int sqOf(int r, int c) { return r * N + c; }
+inline uint64_t bitOf(int sq) { return 1ULL << sq; }
+inline Move moveOf(int sq) { return sq < 0 ? Move{-1,-1} : Move{sq / N, sq % N}; }
+
+inline int popcount64(uint64_t x) { return __builtin_popcountll(x); }
+inline int lsb64(uint64_t x) { return __builtin_ctzll(x); } // x != 0 が前提
+
+// 端列をまたいで回り込まないよう、左右成分を含む方向では相手石を内側に限定する
+static const uint64_t MASK_H = 0x7e7e7e7e7e7e7e7eULL; // 横: a,h 列を除く
+static const uint64_t MASK_V = 0x00ffffffffffff00ULL; // 縦: 1,8 行を除く
+static const uint64_t MASK_D = 0x007e7e7e7e7e7e00ULL; // 斜め: 外周を除く
+
+template <int S>
+inline uint64_t shiftBits(uint64_t b) { return S > 0 ? (b << S) : (b >> -S); }
+
+// 1方向ぶんの合法手（Kogge-Stone の occluded fill）
+template <int S>
+inline uint64_t movesDir(uint64_t P, uint64_t mO) {
+    uint64_t gen = P, pro = mO;
+    gen |= pro & shiftBits<S>(gen);     pro &= shiftBits<S>(pro);
+    gen |= pro & shiftBits<2*S>(gen);   pro &= shiftBits<2*S>(pro);
+    gen |= pro & shiftBits<4*S>(gen);
+    return shiftBits<S>(gen & ~P);      // 連続した相手石の先のマス
+}
+
+// 手番側 P・相手側 O のときの全合法手（ビット集合）
+inline uint64_t movesBits(uint64_t P, uint64_t O) {
+    const uint64_t h = O & MASK_H, v = O & MASK_V, d = O & MASK_D;
+    uint64_t m = movesDir<1>(P, h) | movesDir<-1>(P, h)
+               | movesDir<8>(P, v) | movesDir<-8>(P, v)
+               | movesDir<9>(P, d) | movesDir<-9>(P, d)
+               | movesDir<7>(P, d) | movesDir<-7>(P, d);
+    return m & ~(P | O);
+}
+
+// 1方向ぶんの反転石（置いた石から相手石をたどり、自石で閉じていれば採用）
+template <int S>
+inline uint64_t flipsDir(uint64_t P, uint64_t mO, uint64_t m) {
+    uint64_t f = mO & shiftBits<S>(m);
+    f |= mO & shiftBits<S>(f);
+    f |= mO & shiftBits<S>(f);
+    f |= mO & shiftBits<S>(f);
+    f |= mO & shiftBits<S>(f);
+    f |= mO & shiftBits<S>(f);
+    return (shiftBits<S>(f) & P) ? f : 0;
+}
+
+// sq に置いたときに反転する石（ビット集合）。0 なら非合法
+inline uint64_t flipsBits(uint64_t P, uint64_t O, int sq) {
+    const uint64_t m = bitOf(sq);
+    const uint64_t h = O & MASK_H, v = O & MASK_V, d = O & MASK_D;
+    return flipsDir<1>(P, h, m) | flipsDir<-1>(P, h, m)
+         | flipsDir<8>(P, v, m) | flipsDir<-8>(P, v, m)
+         | flipsDir<9>(P, d, m) | flipsDir<-9>(P, d, m)
+         | flipsDir<7>(P, d, m) | flipsDir<-7>(P, d, m);
+}
+
+// b の石に8方向で隣接するマス
+inline uint64_t neighbours(uint64_t b) {
+    const uint64_t notA = 0xfefefefefefefefeULL, notH = 0x7f7f7f7f7f7f7f7fULL;
+    return ((b << 1) & notA) | ((b >> 1) & notH) | (b << 8) | (b >> 8)
+         | ((b << 9) & notA) | ((b >> 9) & notH) | ((b << 7) & notH) | ((b >> 7) & notA);
+}
+
+// --- 盤の対称変換（a1 = bit0, sq = r*8 + c）---
+inline uint64_t flipVertical(uint64_t x) { return __builtin_bswap64(x); } // 1 行目 ↔ 8 行目
+
+inline uint64_t mirrorHorizontal(uint64_t x) {                              // a 列 ↔ h 列
+    const uint64_t k1 = 0x5555555555555555ULL, k2 = 0x3333333333333333ULL, k4 = 0x0f0f0f0f0f0f0f0fULL;
+    x = ((x >> 1) & k1) | ((x & k1) << 1);
+    x = ((x >> 2) & k2) | ((x & k2) << 2);
+    x = ((x >> 4) & k4) | ((x & k4) << 4);
+    return x;
+}
+
+inline uint64_t flipDiagonal(uint64_t x) {                                  // a1-h8 の対角線で転置
+    const uint64_t k1 = 0x5500550055005500ULL, k2 = 0x3333000033330000ULL, k4 = 0x0f0f0f0f00000000ULL;
+    uint64_t t;
+    t = k4 & (x ^ (x << 28)); x ^= t ^ (t >> 28);
+    t = k2 & (x ^ (x << 14)); x ^= t ^ (t >> 14);
+    t = k1 & (x ^ (x << 7));  x ^= t ^ (t >> 7);
+    return x;
+}
+
+// s = 0..7（bit2: 転置, bit0: 上下反転, bit1: 左右反転 の組み合わせ）
+inline uint64_t transformBits(uint64_t x, int s) {
+    if (s & 4) x = flipDiagonal(x);
+    if (s & 1) x = flipVertical(x);
+    if (s & 2) x = mirrorHorizontal(x);
+    return x;
+}
+
+// 盤面：黒石と白石のビットボード
+struct Board {
+    uint64_t black = 0, white = 0;
+
+    char at(int r, int c) const {
+        uint64_t m = bitOf(sqOf(r,c));
+        return (black & m) ? BLACK : (white & m) ? WHITE : EMPTY;
+    }
+    uint64_t own(char p) const { return p == BLACK ? black : white; }
+    uint64_t opp(char p) const { return p == BLACK ? white : black; }
+    uint64_t empties() const { return ~(black | white); }
+    bool operator==(const Board& o) const { return black == o.black && white == o.white; }
+    bool operator!=(const Board& o) const { return !(*this == o); }
+};
+
+// 初期配置（d4,e5=白 / e4,d5=黒）
+inline Board initialBoard() {
+    Board b;
+    b.white = bitOf(sqOf(3,3)) | bitOf(sqOf(4,4));
+    b.black = bitOf(sqOf(3,4)) | bitOf(sqOf(4,3));
+    return b;
+}
+
+inline uint64_t legalBits(const Board& b, char p) { return movesBits(b.own(p), b.opp(p)); }
+
+inline bool isLegal(const Board& b, char p, int r, int c) {
+    return inBounds(r,c) && (legalBits(b, p) & bitOf(sqOf(r,c)));
+}
+
+// 表示・入力用。探索内部では legalBits を使う
+inline std::vector<Move> legalMoves(const Board& b, char p) {
+    std::vector<Move> moves;
+    for (uint64_t m = legalBits(b, p); m; m &= m - 1) moves.push_back(moveOf(lsb64(m)));
+    return moves;
+}
+
+// 合法手であることが前提
+inline void applyMove(Board& b, char p, int r, int c) {
+    int sq = sqOf(r,c);
+    uint64_t f = flipsBits(b.own(p), b.opp(p), sq);
+    if (p == BLACK) { b.black |= f | bitOf(sq); b.white &= ~f; }
+    else            { b.white |= f | bitOf(sq); b.black &= ~f; }
+}
+
+// 終局時の石差（手番側 P から見る。空きマスは勝った側に加える）
+inline int finalDiff(uint64_t P, uint64_t O) {
+    int p = popcount64(P), o = popcount64(O), e = N*N - p - o;
+    int diff = p - o;
+    return diff > 0 ? diff + e : diff < 0 ? diff - e : 0;
+}
+
+inline std::pair<int,int> countDiscs(const Board& b) {
+    return {popcount64(b.black), popcount64(b.white)};
+}
+
+// 棋譜 "f5d6c3..." を初期局面から再生する（打てない側のパスは自動で挟む）。
+// 不正な手があれば false を返す（b, turn はそこまで進んだ状態）
+inline bool playTranscript(const std::string& moves, Board& b, char& turn) {
+    b = initialBoard();
+    turn = BLACK;
+    for (size_t i = 0; i + 1 < moves.size(); i += 2) {
+        int c = std::tolower((unsigned char)moves[i]) - 'a', r = moves[i+1] - '1';
+        if (!inBounds(r, c)) return false;
+        if (!legalBits(b, turn)) turn = opponent(turn);
+        if (!isLegal(b, turn, r, c)) return false;
+        applyMove(b, turn, r, c);
+        turn = opponent(turn);
+    }
+    if (!legalBits(b, turn) && legalBits(b, opponent(turn))) turn = opponent(turn);
+    return true;
+}
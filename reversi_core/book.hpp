@@ -0,0 +1,162 @@
+// book.hpp - 定石（オープニングブック）
+// 局面を 8 通りの対称変換のうち最小のものに正規化し、そのハッシュでソートした固定長エントリの配列として持つ。
+// ファイルは mmap で読むので起動時の読み込みはなく、検索は二分探索（数マイクロ秒）。
+//
+// ファイル形式（リトルエンディアン）:
+//   BookHeader（magic "RVBOOK1", エントリ数）
+//   BookEntry × count（key の昇順）
+// エントリは局面の評価値（手番側から見た探索スコア）だけを持ち、手は持たない。
+// 着手は「合法手で進めた先の局面」を引いて、相手から見た評価値が最小の手を選ぶ
+// （こうすると対称形・手順前後の合流も自然に扱える）。
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bitboard.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+// 8 通りのうち (P, O) が辞書順で最小になる形
+inline void canonicalize(uint64_t& P, uint64_t& O) {
+    uint64_t bp = P, bo = O;
+    for (int s = 1; s < 8; ++s) {
+        uint64_t tp = transformBits(P, s), to = transformBits(O, s);
+        if (tp < bp || (tp == bp && to < bo)) { bp = tp; bo = to; }
+    }
+    P = bp; O = bo;
+}
+
+inline uint64_t bookKey(uint64_t P, uint64_t O) {
+    canonicalize(P, O);
+    return hashOf(P, O).h;
+}
+
+// --- ファイル形式 ---
+struct BookHeader {
+    char magic[8];      // "RVBOOK1"
+    uint64_t count;
+};
+
+struct BookEntry {
+    uint64_t key;       // bookKey（正規化した局面のハッシュ）
+    int16_t score;      // 手番側から見た評価値（探索スコアを ±BOOK_SCORE_MAX に収めたもの）
+    uint8_t depth;      // 評価に使った探索の深さ（下の局面から逆算した値なら 0）
+    uint8_t flags;
+    uint32_t games;     // 棋譜に出てきた回数
+};
+static_assert(sizeof(BookHeader) == 16 && sizeof(BookEntry) == 16, "book layout");
+
+static const char BOOK_MAGIC[8] = {'R','V','B','O','O','K','1','\0'};
+static const int BOOK_SCORE_MAX = 32000;
+
+// 探索スコア → 定石の評価値（勝敗が確定した値は ±30000 + 石差）
+inline int16_t toBookScore(int s) {
+    if (s >= SCORE_WIN - N*N) return (int16_t)std::min(BOOK_SCORE_MAX, 30000 + (s - SCORE_WIN));
+    if (s <= -SCORE_WIN + N*N) return (int16_t)std::max(-BOOK_SCORE_MAX, -30000 + (s + SCORE_WIN));
+    return (int16_t)std::max(-29999, std::min(29999, s));
+}
+
+// 定石の評価値 → 探索スコア（toBookScore の逆）
+inline int fromBookScore(int v) {
+    if (v >= 30000 - N*N) return SCORE_WIN + (v - 30000);
+    if (v <= -30000 + N*N) return -SCORE_WIN + (v + 30000);
+    return v;
+}
+
+// エントリを key 順に並べて書き出す（同じ key は後のものを残す）
+inline bool writeBook(const std::string& path, std::vector<BookEntry> entries) {
+    std::stable_sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+    std::vector<BookEntry> out;
+    for (const BookEntry& e : entries) {
+        if (!out.empty() && out.back().key == e.key) out.back() = e;
+        else out.push_back(e);
+    }
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    BookHeader h;
+    std::memcpy(h.magic, BOOK_MAGIC, sizeof(h.magic));
+    h.count = out.size();
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1
+           && std::fwrite(out.data(), sizeof(BookEntry), out.size(), f) == out.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+class OpeningBook {
+public:
+    OpeningBook() = default;
+    ~OpeningBook() { close(); }
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // ファイルがない・壊れているときは false（定石なしで動く）
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BookHeader)) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        const BookHeader* h = (const BookHeader*)p;
+        if (std::memcmp(h->magic, BOOK_MAGIC, sizeof(h->magic)) != 0
+            || h->count > ((size_t)st.st_size - sizeof(BookHeader)) / sizeof(BookEntry)) { // 掛け算は桁あふれしうる
+            munmap(p, (size_t)st.st_size);
+            return false;
+        }
+        base = p;
+        mapped = (size_t)st.st_size;
+        entries = (const BookEntry*)((const char*)p + sizeof(BookHeader));
+        count = h->count;
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(base, mapped);
+        base = nullptr; entries = nullptr; count = 0; mapped = 0;
+    }
+
+    bool loaded() const { return count > 0; }
+    size_t size() const { return count; }
+    const BookEntry* begin() const { return entries; }
+    const BookEntry* end() const { return entries + count; }
+
+    const BookEntry* find(uint64_t key) const {
+        const BookEntry* e = std::lower_bound(begin(), end(), key, [](const BookEntry& a, uint64_t k) { return a.key < k; });
+        return e != end() && e->key == key ? e : nullptr;
+    }
+    const BookEntry* find(uint64_t P, uint64_t O) const { return find(bookKey(P, O)); }
+
+    // 手番側 P の定石手。進めた先の局面が定石にある手のうち、相手から見た評価値が最小のもの（score は探索スコアで返す）
+    // （相手がパスになる局面は、パスした後の＝自分の手番の局面として登録してある）
+    bool pick(uint64_t P, uint64_t O, int& bestSq, int& score) const {
+        if (!loaded()) return false;
+        bestSq = -1;
+        for (uint64_t m = movesBits(P, O); m; m &= m - 1) {
+            int sq = lsb64(m);
+            uint64_t f = flipsBits(P, O, sq);
+            uint64_t cP = O ^ f, cO = P | f | bitOf(sq);
+            const BookEntry* e = nullptr;
+            int s = 0;
+            if (movesBits(cP, cO)) { if ((e = find(cP, cO))) s = -e->score; }
+            else if (movesBits(cO, cP)) { if ((e = find(cO, cP))) s = e->score; }
+            if (e && (bestSq < 0 || s > score)) { bestSq = sq; score = s; }
+        }
+        if (bestSq >= 0) score = fromBookScore(score);
+        return bestSq >= 0;
+    }
+
+private:
+    void* base = nullptr;
+    size_t mapped = 0;
+    const BookEntry* entries = nullptr;
+    size_t count = 0;
+};
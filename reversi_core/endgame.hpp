@@ -0,0 +1,389 @@
+// endgame.hpp - 終盤完全読み（最終石差の厳密解 / 勝敗のみの WLD 読み）
+//
+// 空きマス数に応じて4段階に切り替える:
+//   深い部分   : 置換表（ETC つき）+ 確定石による打ち切り + 速さ優先（相手の着手可能数が少ない順）
+//   中間       : 速さ優先のみ（置換表なし）
+//   浅い部分   : 偶数理論（空きが奇数個の象限を先に打つ）の並べ替えのみ
+//   確定石による打ち切りは残り5マスまで使う
+//   残り1〜4マス: 空きマスを直接受け取る専用ルーチン
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include "bitboard.hpp"
+#include "tt.hpp"
+
+static const int ENDGAME_TT_EMPTIES = 8;  // これより多い空きで置換表と速さ優先を使う
+static const int ENDGAME_ETC_EMPTIES = 12; // これより多い空きで子局面の置換表を先に引く
+static const int ENDGAME_SORT_EMPTIES = 7; // これ以上の空きで速さ優先の並べ替えを使う
+static const int ENDGAME_STABILITY_EMPTIES = 5; // これ以上の空きで確定石による打ち切りを試す
+static const int ENDGAME_MAX_MOVES = N*N;
+
+// 4象限（4x4）のマスク
+static const uint64_t QUADRANT_MASK[4] = {
+    0x000000000f0f0f0fULL, 0x00000000f0f0f0f0ULL,
+    0x0f0f0f0f00000000ULL, 0xf0f0f0f000000000ULL
+};
+
+// 空きマスが奇数個の象限に属するマス集合
+inline uint64_t oddParityMask(uint64_t empties) {
+    uint64_t m = 0;
+    for (uint64_t q : QUADRANT_MASK) if (popcount64(empties & q) & 1) m |= q;
+    return m;
+}
+
+// 確定石（これ以上返されない石）の保守的な推定。
+// 4方向それぞれで「列が埋まっている」か「隣が盤外か同色の確定石」なら安全とみなし、
+// 変化がなくなるまで広げる
+struct LineMasks {
+    uint64_t diag7[N*N], diag9[N*N]; // 各マスを通る斜めの列
+    LineMasks() {
+        for (int sq = 0; sq < N*N; ++sq) {
+            int r = sq / N, c = sq % N;
+            diag7[sq] = diag9[sq] = 0;
+            for (int rr = 0; rr < N; ++rr) {
+                int c7 = r + c - rr, c9 = c - r + rr;
+                if (c7 >= 0 && c7 < N) diag7[sq] |= bitOf(sqOf(rr, c7));
+                if (c9 >= 0 && c9 < N) diag9[sq] |= bitOf(sqOf(rr, c9));
+            }
+        }
+    }
+};
+
+inline const LineMasks& lineMasks() {
+    static const LineMasks lm;
+    return lm;
+}
+
+inline uint64_t stableDiscs(uint64_t P, uint64_t O) {
+    static const uint64_t COL_A = 0x0101010101010101ULL, COL_H = 0x8080808080808080ULL;
+    static const uint64_t ROW_1 = 0x00000000000000ffULL, ROW_8 = 0xff00000000000000ULL;
+    static const uint64_t EDGE = COL_A | COL_H | ROW_1 | ROW_8;
+    const uint64_t occ = P | O;
+    if (!(P & EDGE)) return 0; // 確定石は必ず外周から広がる
+
+    // 埋まっている列
+    uint64_t fullH = 0, fullV, full7 = 0, full9 = 0;
+    for (int r = 0; r < N; ++r)
+        if (((occ >> (r * N)) & 0xff) == 0xff) fullH |= 0xffULL << (r * N);
+    uint64_t v = occ;
+    v &= v >> 32; v &= v >> 16; v &= v >> 8;
+    fullV = (v & 0xff) * COL_A;
+    const LineMasks& lm = lineMasks();
+    for (int i = 0; i < N; ++i) { // 斜めは 1行目と 8行目・a列・h列のマスから辿れば全部を網羅できる
+        const int sqs[4] = {i, sqOf(N-1, i), sqOf(i, 0), sqOf(i, N-1)};
+        for (int sq : sqs) {
+            if ((occ & lm.diag7[sq]) == lm.diag7[sq]) full7 |= lm.diag7[sq];
+            if ((occ & lm.diag9[sq]) == lm.diag9[sq]) full9 |= lm.diag9[sq];
+        }
+    }
+
+    uint64_t stable = 0;
+    for (;;) {
+        uint64_t h = fullH | COL_A | COL_H | ((stable << 1) & ~COL_A) | ((stable >> 1) & ~COL_H);
+        uint64_t vv = fullV | ROW_1 | ROW_8 | (stable << 8) | (stable >> 8);
+        uint64_t d9 = full9 | EDGE | ((stable << 9) & ~COL_A) | ((stable >> 9) & ~COL_H);
+        uint64_t d7 = full7 | EDGE | ((stable << 7) & ~COL_H) | ((stable >> 7) & ~COL_A);
+        uint64_t next = P & h & vv & d9 & d7;
+        if (next == stable) return stable;
+        stable = next;
+    }
+}
+
+class EndgameSolver {
+public:
+    // 置換表は持ち主が用意する（並列探索では全スレッドで共有する）
+    explicit EndgameSolver(TranspositionTable& table, int threadId = 0) : tt(table), tid(threadId) {}
+
+    TranspositionTable& tt;
+    int tid;
+    uint64_t nodes = 0;
+
+    // 打ち切り条件（Searcher から設定する）
+    const std::atomic<bool>* stopFlag = nullptr;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    uint64_t maxNodes = 0;
+    bool aborted = false;
+
+    // (alpha,beta) の窓で最終石差を求める。WLD なら窓 (-1,1) で呼ぶ
+    int solve(uint64_t P, uint64_t O, int alpha, int beta) {
+        aborted = false;
+        return search(P, O, hashOf(P, O), alpha, beta, false);
+    }
+
+    // ルートの各手を読み切り、最善手と石差を返す（firstSq を先に読む）
+    int solveRoot(uint64_t P, uint64_t O, bool wld, int firstSq, int& bestSq) {
+        aborted = false;
+        if (wld) return rootWindow(P, O, -1, 1, firstSq, bestSq);
+        return rootWindow(P, O, -N*N - 1, N*N + 1, firstSq, bestSq);
+    }
+
+private:
+    int rootWindow(uint64_t P, uint64_t O, int alpha, int beta, int firstSq, int& bestSq) {
+        int order[ENDGAME_MAX_MOVES];
+        int n = orderFastestFirst(P, O, movesBits(P, O), firstSq, order);
+        HashPair key = hashOf(P, O);
+        int best = -N*N - 1;
+        for (int i = 0; i < n && alpha < beta; ++i) {
+            int sq = order[i];
+            uint64_t f = flipsBits(P, O, sq);
+            uint64_t nP = O ^ f, nO = P | f | bitOf(sq);
+            HashPair nk = hashAfterMove(key, sq, f);
+            int s;
+            if (i == 0) {
+                s = -search(nP, nO, nk, -beta, -alpha, false);
+            } else { // 2手目以降はヌルウィンドウで確認し、上回ったときだけ読み直す
+                s = -search(nP, nO, nk, -alpha - 1, -alpha, false);
+                if (!aborted && s > alpha && s < beta) s = -search(nP, nO, nk, -beta, -s, false);
+            }
+            if (aborted) break;
+            if (s > best) { best = s; bestSq = sq; }
+            if (s > alpha) alpha = s;
+        }
+        return best;
+    }
+
+    bool checkAbort() {
+        if (aborted) return true;
+        if ((nodes & 4095) == 0) {
+            if (stopFlag && stopFlag->load(std::memory_order_relaxed)) aborted = true;
+            else if (maxNodes && nodes >= maxNodes) aborted = true;
+            else if (std::chrono::steady_clock::now() >= deadline) aborted = true;
+        }
+        return aborted;
+    }
+
+    bool stabilityCutoff(uint64_t P, uint64_t O, int alpha) const {
+        if (alpha < 0) return false; // 上限が alpha を下回るのは相手の確定石が多いときだけ
+        if (N*N - 2 * popcount64(O) > alpha) return false; // 相手の石が全部確定石でも足りない
+        return N*N - 2 * popcount64(stableDiscs(O, P)) <= alpha;
+    }
+
+    // 速さ優先：相手の着手可能数（隅は2倍に数える）が少ない順、
+    // 同数なら相手の潜在的な着手可能数（こちらの石に接する空きマス）が少ない順。firstSq は先頭
+    int orderFastestFirst(uint64_t P, uint64_t O, uint64_t moves, int firstSq, int* out) const {
+        static const uint64_t CORNERS = 0x8100000000000081ULL;
+        uint64_t odd = oddParityMask(~(P | O));
+        int n = 0, key[ENDGAME_MAX_MOVES];
+        for (; moves; moves &= moves - 1) {
+            int sq = lsb64(moves);
+            uint64_t f = flipsBits(P, O, sq);
+            uint64_t om = movesBits(O ^ f, P | f | bitOf(sq));
+            uint64_t nP = P | f | bitOf(sq);
+            int k = (popcount64(om) + popcount64(om & CORNERS)) * 16
+                  + popcount64(neighbours(nP) & ~(nP | O)) - ((odd >> sq) & 1);
+            if (sq == firstSq) k = -1000;
+            int i = n++;
+            while (i > 0 && key[i-1] > k) { key[i] = key[i-1]; out[i] = out[i-1]; --i; }
+            key[i] = k; out[i] = sq;
+        }
+        return n;
+    }
+
+    int search(uint64_t P, uint64_t O, const HashPair& key, int alpha, int beta, bool passed) {
+        const uint64_t E = ~(P | O);
+        const int empties = popcount64(E);
+        if (empties <= ENDGAME_TT_EMPTIES) return searchShallow(P, O, alpha, beta, false);
+
+        ++nodes;
+        if (checkAbort()) return 0;
+
+        uint64_t moves = movesBits(P, O);
+        if (!moves) {
+            if (passed) return finalDiff(P, O);
+            return -search(O, P, hashAfterPass(key), -beta, -alpha, true);
+        }
+
+        // 相手の確定石から求めた上限で足りなければ打ち切る
+        if (stabilityCutoff(P, O, alpha)) return alpha;
+
+        int ttSq = -1;
+        TTEntry e;
+        if (tt.probe(key.h, e, tid)) {
+            if (e.bound == BOUND_EXACT) return e.score;
+            if (e.bound == BOUND_LOWER && e.score >= beta) return e.score;
+            if (e.bound == BOUND_UPPER && e.score <= alpha) return e.score;
+            if (e.bestSq >= 0 && (moves & bitOf(e.bestSq))) ttSq = e.bestSq;
+        }
+
+        // 子局面の置換表だけで beta を超えることが分かれば展開しない（ETC）
+        if (empties > ENDGAME_ETC_EMPTIES) {
+            for (uint64_t m = moves; m; m &= m - 1) {
+                int sq = lsb64(m);
+                TTEntry c;
+                if (tt.probe(hashAfterMove(key, sq, flipsBits(P, O, sq)).h, c, tid)
+                    && (c.bound == BOUND_UPPER || c.bound == BOUND_EXACT) && -c.score >= beta) return -c.score;
+            }
+        }
+
+        int order[ENDGAME_MAX_MOVES];
+        int n = orderFastestFirst(P, O, moves, ttSq, order);
+        const int alpha0 = alpha;
+        int best = -N*N - 1, bestSq = -1;
+        for (int i = 0; i < n; ++i) {
+            int sq = order[i];
+            uint64_t f = flipsBits(P, O, sq);
+            uint64_t nP = O ^ f, nO = P | f | bitOf(sq);
+            HashPair nk = hashAfterMove(key, sq, f);
+            int s;
+            if (i == 0 || beta - alpha == 1) {
+                s = -search(nP, nO, nk, -beta, -alpha, false);
+            } else {
+                s = -search(nP, nO, nk, -alpha - 1, -alpha, false);
+                if (!aborted && s > alpha && s < beta) s = -search(nP, nO, nk, -beta, -s, false);
+            }
+            if (aborted) return 0;
+            if (s > best) {
+                best = s; bestSq = sq;
+                if (s > alpha) { alpha = s; if (alpha >= beta) break; }
+            }
+        }
+        Bound bound = best >= beta ? BOUND_LOWER : best > alpha0 ? BOUND_EXACT : BOUND_UPPER;
+        tt.store(key.h, best, empties, bound, bestSq, tid);
+        return best;
+    }
+
+    // 置換表を使わない読み（空きが少なければ偶数理論の並べ替えだけにする）
+    int searchShallow(uint64_t P, uint64_t O, int alpha, int beta, bool passed) {
+        const uint64_t E = ~(P | O);
+        if (popcount64(E) <= 4) {
+            int sq[4], n = 0;
+            for (uint64_t m = E; m; m &= m - 1) sq[n++] = lsb64(m);
+            switch (n) {
+            case 4: return solve4(P, O, alpha, beta, sq, oddParityMask(E));
+            case 3: return solve3(P, O, alpha, beta, sq[0], sq[1], sq[2]);
+            case 2: return solve2(P, O, alpha, beta, sq[0], sq[1]);
+            case 1: return solve1(P, O, sq[0]);
+            default: return finalDiff(P, O);
+            }
+        }
+
+        ++nodes;
+        if (checkAbort()) return 0;
+
+        uint64_t moves = movesBits(P, O);
+        if (!moves) {
+            if (passed) return finalDiff(P, O);
+            return -searchShallow(O, P, -beta, -alpha, true);
+        }
+        if (popcount64(E) >= ENDGAME_STABILITY_EMPTIES && stabilityCutoff(P, O, alpha)) return alpha;
+
+        int best = -N*N - 1;
+        if (popcount64(E) >= ENDGAME_SORT_EMPTIES) {
+            int order[ENDGAME_MAX_MOVES];
+            int n = orderFastestFirst(P, O, moves, -1, order);
+            for (int i = 0; i < n; ++i) {
+                int sq = order[i];
+                uint64_t f = flipsBits(P, O, sq);
+                uint64_t nP = O ^ f, nO = P | f | bitOf(sq);
+                int s;
+                if (i == 0 || beta - alpha == 1) {
+                    s = -searchShallow(nP, nO, -beta, -alpha, false);
+                } else {
+                    s = -searchShallow(nP, nO, -alpha - 1, -alpha, false);
+                    if (!aborted && s > alpha && s < beta) s = -searchShallow(nP, nO, -beta, -s, false);
+                }
+                if (aborted) return 0;
+                if (s > best) {
+                    best = s;
+                    if (s > alpha) { alpha = s; if (alpha >= beta) return best; }
+                }
+            }
+            return best;
+        }
+
+        uint64_t odd = oddParityMask(E);
+        uint64_t groups[2] = {moves & odd, moves & ~odd};
+        for (uint64_t g : groups) {
+            for (; g; g &= g - 1) {
+                int sq = lsb64(g);
+                uint64_t f = flipsBits(P, O, sq);
+                int s = -searchShallow(O ^ f, P | f | bitOf(sq), -beta, -alpha, false);
+                if (aborted) return 0;
+                if (s > best) {
+                    best = s;
+                    if (s > alpha) { alpha = s; if (alpha >= beta) return best; }
+                }
+            }
+        }
+        return best;
+    }
+
+    // --- 残り1〜4マスの専用ルーチン ---
+
+    // 残り1マス：打てる側が打って終局
+    int solve1(uint64_t P, uint64_t O, int x) {
+        ++nodes;
+        int diff = 2 * popcount64(P) - (N*N - 1);
+        uint64_t f = flipsBits(P, O, x);
+        if (f) return diff + 1 + 2 * popcount64(f);
+        f = flipsBits(O, P, x);
+        if (f) return diff - 1 - 2 * popcount64(f);
+        return diff > 0 ? diff + 1 : diff - 1; // 63個なので引き分けはない
+    }
+
+    int solve2(uint64_t P, uint64_t O, int alpha, int beta, int x1, int x2, bool passed = false) {
+        ++nodes;
+        int best = -N*N - 1;
+        uint64_t f;
+        if ((f = flipsBits(P, O, x1))) {
+            best = -solve1(O ^ f, P | f | bitOf(x1), x2);
+            if (best >= beta) return best;
+        }
+        if ((f = flipsBits(P, O, x2))) {
+            int s = -solve1(O ^ f, P | f | bitOf(x2), x1);
+            if (s > best) best = s;
+        }
+        if (best > -N*N - 1) return best;
+        if (passed) return finalDiff(P, O);
+        return -solve2(O, P, -beta, -alpha, x1, x2, true);
+    }
+
+    int solve3(uint64_t P, uint64_t O, int alpha, int beta, int x1, int x2, int x3, bool passed = false) {
+        ++nodes;
+        int best = -N*N - 1;
+        uint64_t f;
+        if ((f = flipsBits(P, O, x1))) {
+            best = -solve2(O ^ f, P | f | bitOf(x1), -beta, -alpha, x2, x3);
+            if (best >= beta) return best;
+            if (best > alpha) alpha = best;
+        }
+        if ((f = flipsBits(P, O, x2))) {
+            int s = -solve2(O ^ f, P | f | bitOf(x2), -beta, -alpha, x1, x3);
+            if (s >= beta) return s;
+            if (s > best) { best = s; if (s > alpha) alpha = s; }
+        }
+        if ((f = flipsBits(P, O, x3))) {
+            int s = -solve2(O ^ f, P | f | bitOf(x3), -beta, -alpha, x1, x2);
+            if (s > best) best = s;
+        }
+        if (best > -N*N - 1) return best;
+        if (passed) return finalDiff(P, O);
+        return -solve3(O, P, -beta, -alpha, x1, x2, x3, true);
+    }
+
+    // 残り4マス：奇数象限のマスを先に読む
+    int solve4(uint64_t P, uint64_t O, int alpha, int beta, const int* xs, uint64_t odd, bool passed = false) {
+        ++nodes;
+        if (checkAbort()) return 0;
+        int x[4], n = 0;
+        for (int i = 0; i < 4; ++i) if ((odd >> xs[i]) & 1) x[n++] = xs[i];
+        for (int i = 0; i < 4; ++i) if (!((odd >> xs[i]) & 1)) x[n++] = xs[i];
+
+        static const int REST[4][3] = {{1,2,3}, {0,2,3}, {0,1,3}, {0,1,2}};
+        int best = -N*N - 1;
+        for (int i = 0; i < 4; ++i) {
+            uint64_t f = flipsBits(P, O, x[i]);
+            if (!f) continue;
+            const int* r = REST[i];
+            int s = -solve3(O ^ f, P | f | bitOf(x[i]), -beta, -alpha, x[r[0]], x[r[1]], x[r[2]]);
+            if (s > best) {
+                best = s;
+                if (s > alpha) { alpha = s; if (alpha >= beta) return best; }
+            }
+        }
+        if (best > -N*N - 1) return best;
+        if (passed) return finalDiff(P, O);
+        return -solve4(O, P, -beta, -alpha, x, odd, true);
+    }
+};
@@ -0,0 +1,277 @@
+// engine_protocol.hpp - 1行1コマンドのテキストプロトコル（UCI/GTP 風。盤の表示はしない）
+// 外部の GUI やスクリプトからエンジンを動かすためのもの。探索は別スレッドで走らせるので、
+// 探索中も stop / isready / ping はすぐに処理する。それ以外のコマンドは探索が終わるのを待ってから処理する
+// （コマンドをまとめて流し込めるように。ただし go infinite の間は stop が来るまで終わらないのでエラーにする）。
+// 出力は out に 1行ずつ渡す（改行なし）。
+//
+// コマンド:
+//   position startpos [moves f5d6c3...]      初期局面から（打てない側のパスは自動で挟む。pass と書くのもそこだけ）
+//   position <64文字> <X|O> [moves ...]      a1,b1,...,h8 の順に X/O/.（-）で盤を、続けて手番を指定
+//   move <sq>                                 1手進める       undo    1手戻す
+//   newgame                                   置換表を空にする
+//   set time <ms> | nodes <n> | depth <d> | clock <残りms> [<加算ms>] | exact <n> | wld <n>
+//       | sel <0〜5>（ProbCut の選択度）| threads <n> | hash <MB> | book on|off | info on|off（反復ごとの info を出すか）
+//   go [time <ms>] [nodes <n>] [depth <d>] [infinite]
+//                                             探索を始める。反復ごとに info、終わったら bestmove を出す
+//   stop                                      探索を打ち切る（それまでの結果で bestmove を出す）
+//   eval                                      静的評価      isready  → readyok      ping [x] → pong [x]
+//   quit
+// 出力:
+//   info depth <d> score <s> nodes <n> time <秒> nps <n> move <sq>
+//   bestmove <sq|pass|none> score <s> depth <d> nodes <n> time <秒> nps <n> [solved exact|wld] [book] pv <sq> ...
+//   error <理由>
+// score は手番側から見た値（終局まで読めたときは win+石差 / loss-石差、勝敗だけなら win / loss / draw）
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "bitboard.hpp"
+#include "book.hpp"
+#include "game_state.hpp"
+#include "pattern.hpp"
+#include "search.hpp"
+
+// "d3" / "pass" → マス番号（パスは -1、読めなければ -2）
+inline int parseSquare(const std::string& s) {
+    if (s == "pass" || s == "PASS") return -1;
+    if (s.size() != 2) return -2;
+    int c = std::tolower((unsigned char)s[0]) - 'a', r = s[1] - '1';
+    return inBounds(r, c) ? sqOf(r, c) : -2;
+}
+
+class EngineProtocol {
+public:
+    // out は探索スレッドからも呼ぶ（呼び出しは内部で直列化する）
+    EngineProtocol(Searcher& s, std::function<void(const std::string&)> output, const OpeningBook* b = nullptr)
+        : searcher(s), out(std::move(output)), book(b) {
+        searcher.onIteration = [this](const SearchResult& r) {
+            if (!showInfo) return;
+            char buf[192];
+            std::snprintf(buf, sizeof(buf), "info depth %d score %s nodes %llu time %.3f nps %llu move %s", r.depth,
+                          scoreWord(r).c_str(), (unsigned long long)r.nodes, r.seconds, (unsigned long long)r.nps(),
+                          squareName(r.bestSq).c_str());
+            emit(buf);
+        };
+    }
+    ~EngineProtocol() { stopSearch(); searcher.onIteration = nullptr; }
+    EngineProtocol(const EngineProtocol&) = delete;
+    EngineProtocol& operator=(const EngineProtocol&) = delete;
+
+    // 1行を処理する。quit なら false
+    bool handle(const std::string& line) {
+        std::istringstream in(line);
+        std::string cmd;
+        if (!(in >> cmd)) return true;
+        if (cmd == "quit") { stopSearch(); return false; }
+        if (cmd == "isready") { emit("readyok"); return true; }
+        if (cmd == "ping") {
+            std::string id;
+            std::getline(in >> std::ws, id);
+            emit(id.empty() ? "pong" : "pong " + id);
+            return true;
+        }
+        if (cmd == "stop") { stopSearch(); return true; }
+        if (busy()) {
+            if (infinite) { emit("error searching (send stop first)"); return true; }
+            wait();
+        }
+
+        if (cmd == "position") position(in);
+        else if (cmd == "move") {
+            std::string m;
+            in >> m;
+            int sq = parseSquare(m);
+            if (sq == -1 && g.passed()) return true; // パスは自動で済ませている
+            if (!g.play(sq)) emit("error illegal move " + m);
+        }
+        else if (cmd == "undo") { if (!g.undo()) emit("error nothing to undo"); }
+        else if (cmd == "newgame") searcher.newGame();
+        else if (cmd == "set") set(in);
+        else if (cmd == "go") go(in);
+        else if (cmd == "eval") {
+            const PatternWeights& w = searcher.weights ? *searcher.weights : patternWeights();
+            PatternState st;
+            st.init(g.own(), g.opp());
+            emit("eval " + std::to_string(g.over() ? finalScore(g.own(), g.opp()) : evaluatePatterns(st, g.own(), g.opp(), w)));
+        }
+        else emit("error unknown command " + cmd);
+        return true;
+    }
+
+    // 探索中なら終わるまで待つ（入力が尽きたときに使う）
+    void wait() { if (worker.joinable()) worker.join(); }
+    bool busy() const { return worker.joinable() && !finished.load(); }
+
+private:
+    Searcher& searcher;
+    std::function<void(const std::string&)> out;
+    const OpeningBook* book;
+    bool useBook = true, showInfo = true;
+    GameState g;
+    SearchLimits base;         // set で決めた持ち時間（go の引数はその探索だけに使う）
+    bool baseSet = false;
+    int64_t clockMs = -1, incMs = 0; // set clock（残り時間から 1手の持ち時間を決める）
+    std::thread worker;
+    std::atomic<bool> finished{true};
+    bool infinite = false;     // 今の探索が時間・ノード数の制限なしか
+    std::mutex outMtx;
+
+    void emit(const std::string& s) {
+        std::lock_guard<std::mutex> lock(outMtx);
+        out(s);
+    }
+
+    static std::string scoreWord(const SearchResult& r) {
+        if (r.solved == SOLVE_WLD) return r.score > 0 ? "win" : r.score < 0 ? "loss" : "draw";
+        return scoreText(r.score);
+    }
+
+    void stopSearch() {
+        if (!worker.joinable()) return;
+        searcher.stop();
+        worker.join();
+    }
+
+    void position(std::istringstream& in) {
+        std::string what, tok;
+        in >> what;
+        Board b;
+        char side = BLACK;
+        if (what == "startpos") b = initialBoard();
+        else if (what.size() == (size_t)N*N) {
+            std::string s;
+            in >> s;
+            if (s != "X" && s != "O" && s != "x" && s != "o") { emit("error side must be X or O"); return; }
+            side = std::toupper((unsigned char)s[0]);
+            for (int i = 0; i < N*N; ++i) {
+                char ch = std::toupper((unsigned char)what[i]);
+                if (ch == BLACK) b.black |= bitOf(i);
+                else if (ch == WHITE) b.white |= bitOf(i);
+                else if (ch != '.' && ch != '-') { emit("error bad board"); return; }
+            }
+        } else { emit("error usage: position startpos|<64 chars> <X|O> [moves ...]"); return; }
+        GameState next;
+        next.reset(b, side);
+        if (in >> tok) {
+            if (tok != "moves") { emit("error expected moves"); return; }
+            std::string ms, m;
+            while (in >> m) ms += m;
+            for (char& ch : ms) ch = std::tolower((unsigned char)ch);
+            // パスは GameState が自動で入れるので、打てなかった側のパス（自動で済ませたもの）にだけ書ける
+            bool passPending = next.passed();
+            for (size_t i = 0; i + 1 < ms.size(); i += 2) {
+                if (ms.compare(i, 4, "pass") == 0) {
+                    if (!passPending) { emit("error illegal move pass"); return; }
+                    passPending = false;
+                    i += 2;
+                    continue;
+                }
+                if (!next.play(parseSquare(ms.substr(i, 2)))) { emit("error illegal move " + ms.substr(i, 2)); return; }
+                passPending = next.passed();
+            }
+        }
+        g = next;
+    }
+
+    void set(std::istringstream& in) {
+        std::string key, v;
+        if (!(in >> key >> v)) { emit("error usage: set <name> <value>"); return; }
+        if (!baseSet) { base = searcher.limits; baseSet = true; }
+        long long n = std::atoll(v.c_str());
+        if (key == "time") { base.timeMs = (int)n; clockMs = -1; }
+        else if (key == "nodes") base.maxNodes = (uint64_t)n;
+        else if (key == "depth") base.maxDepth = (int)n;
+        else if (key == "exact") base.exactEmpties = (int)n;
+        else if (key == "wld") base.wldEmpties = (int)n;
+        else if (key == "sel") base.selectivity = (int)n;
+        else if (key == "threads") { searcher.setThreads((int)n); base.threads = searcher.limits.threads; }
+        else if (key == "hash") searcher.setHashSize((size_t)n);
+        else if (key == "clock") {
+            clockMs = n;
+            std::string inc;
+            incMs = (in >> inc) ? std::atoll(inc.c_str()) : 0;
+        }
+        else if (key == "book") useBook = v == "on";
+        else if (key == "info") showInfo = v == "on";
+        else emit("error unknown option " + key);
+    }
+
+    // 残り時間から 1手の持ち時間：自分の残り手数（空きの半分）で割って加算ぶんを足し、残りの半分を超えない
+    int clockBudget() const {
+        int64_t movesLeft = std::max(2, (g.empties() + 1) / 2);
+        int64_t t = clockMs / movesLeft + incMs * 9 / 10;
+        return (int)std::max<int64_t>(1, std::min(t, clockMs / 2));
+    }
+
+    void go(std::istringstream& in) {
+        if (!baseSet) { base = searcher.limits; baseSet = true; }
+        SearchLimits l = base;
+        if (clockMs >= 0) l.timeMs = clockBudget();
+        std::string k;
+        while (in >> k) {
+            std::string v;
+            if (k == "infinite") { l.timeMs = 0; l.maxNodes = 0; continue; }
+            if (!(in >> v)) { emit("error missing value for " + k); return; }
+            if (k == "time") l.timeMs = std::atoi(v.c_str());
+            else if (k == "nodes") l.maxNodes = std::strtoull(v.c_str(), nullptr, 10);
+            else if (k == "depth") l.maxDepth = std::atoi(v.c_str());
+            else { emit("error unknown go option " + k); return; }
+        }
+        if (g.over()) {
+            emit("bestmove none score " + scoreText(finalScore(g.own(), g.opp())) + " depth 0 nodes 0 time 0.000 nps 0 pv");
+            return;
+        }
+        int bookSq, bookScore;
+        if (useBook && book && book->pick(g.own(), g.opp(), bookSq, bookScore)) {
+            emit("bestmove " + squareName(bookSq) + " score " + scoreText(bookScore)
+                 + " depth 0 nodes 0 time 0.000 nps 0 book pv " + squareName(bookSq));
+            return;
+        }
+        wait();
+        searcher.limits = l;
+        infinite = l.timeMs <= 0 && !l.maxNodes;
+        finished = false;
+        searcher.clearStop();
+        uint64_t P = g.own(), O = g.opp();
+        worker = std::thread([this, P, O]() {
+            SearchResult r = searcher.search(P, O);
+            char buf[192];
+            std::snprintf(buf, sizeof(buf), "bestmove %s score %s depth %d nodes %llu time %.3f nps %llu%s pv",
+                          squareName(r.bestSq).c_str(), scoreWord(r).c_str(), r.depth, (unsigned long long)r.nodes,
+                          r.seconds, (unsigned long long)r.nps(),
+                          r.solved == SOLVE_EXACT ? " solved exact" : r.solved == SOLVE_WLD ? " solved wld" : "");
+            emit(buf + principalVariation(P, O, r.bestSq, r.depth));
+            finished = true;
+        });
+    }
+
+    // 最善手から置換表の最善手をたどった読み筋（探索が終わってから呼ぶ）
+    std::string principalVariation(uint64_t P, uint64_t O, int sq, int maxLen) {
+        std::string pv;
+        HashPair key = hashOf(P, O);
+        for (int i = 0; i < maxLen && sq >= 0; ++i) {
+            pv += " " + squareName(sq);
+            uint64_t f = flipsBits(P, O, sq);
+            key = hashAfterMove(key, sq, f);
+            uint64_t nP = O ^ f, nO = P | f | bitOf(sq);
+            P = nP; O = nO;
+            if (!movesBits(P, O)) {
+                if (!movesBits(O, P)) break;
+                pv += " pass";
+                std::swap(P, O);
+                key = hashAfterPass(key);
+            }
+            TTEntry e;
+            sq = searcher.tt.probe(key.h, e) && e.bestSq >= 0 && (movesBits(P, O) & bitOf(e.bestSq)) ? e.bestSq : -1;
+        }
+        return pv;
+    }
+};
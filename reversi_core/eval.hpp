@@ -0,0 +1,53 @@
+// eval.hpp - 静的評価関数（位置重み＋着手可能数）
+// 探索の末端はパターン評価（pattern.hpp）を使う。W は手の並べ替えとパターン重みの既定値の元として使う。
+#pragma once
+
+#include "bitboard.hpp"
+
+// 盤面の評価用重み（シンプル版：角に高評価, 隅や危険マスは低評価）
+static const int W[N][N] = {
+    { 120,-20, 20,  5,  5, 20,-20,120},
+    { -20,-40, -5, -5, -5, -5,-40,-20},
+    {  20,  -5, 15,  3,  3, 15,  -5, 20},
+    {   5,  -5,  3,  3,  3,  3,  -5,  5},
+    {   5,  -5,  3,  3,  3,  3,  -5,  5},
+    {  20,  -5, 15,  3,  3, 15,  -5, 20},
+    { -20,-40, -5, -5, -5, -5,-40,-20},
+    { 120,-20, 20,  5,  5, 20,-20,120}
+};
+
+static const int MOBILITY_WEIGHT = 5;
+
+// W を「同じ重みのマス集合」に分けておき、popcount で位置評価を求める
+struct WeightMasks {
+    int count = 0;
+    int weight[N*N];
+    uint64_t mask[N*N];
+    WeightMasks() {
+        for (int sq = 0; sq < N*N; ++sq) {
+            int w = W[sq / N][sq % N], k = 0;
+            while (k < count && weight[k] != w) ++k;
+            if (k == count) { weight[count] = w; mask[count] = 0; ++count; }
+            mask[k] |= bitOf(sq);
+        }
+    }
+};
+
+inline const WeightMasks& weightMasks() {
+    static const WeightMasks wm;
+    return wm;
+}
+
+inline int positionalScore(uint64_t P, uint64_t O) {
+    const WeightMasks& wm = weightMasks();
+    int s = 0;
+    for (int k = 0; k < wm.count; ++k)
+        s += wm.weight[k] * (popcount64(P & wm.mask[k]) - popcount64(O & wm.mask[k]));
+    return s;
+}
+
+// 手番側 P から見た評価値
+inline int evaluate(uint64_t P, uint64_t O) {
+    int mob = popcount64(movesBits(P, O)) - popcount64(movesBits(O, P));
+    return positionalScore(P, O) + mob * MOBILITY_WEIGHT;
+}
@@ -0,0 +1,104 @@
+// game_state.hpp - 対局の進行（手番・石数・合法手・ハッシュ・パスと終局）を差分で持つ
+// 着手のたびに反転した石から石数とハッシュを更新し、合法手は局面が変わったときに一度だけ求めて持っておく。
+// 打てない側のパスは着手の中で自動的に挟み、終局もそこで判定するので、表示側はフラグを見るだけでよい。
+// 取り消し用のスタックは固定長の配列なので、対局中にメモリを確保しない。
+#pragma once
+
+#include <cstdint>
+#include "bitboard.hpp"
+#include "tt.hpp"
+
+class GameState {
+public:
+    GameState() { reset(); }
+
+    // 局面 b・手番 toMove から始める（手番側が打てなければパスした後の手番にする）
+    void reset(const Board& start = initialBoard(), char toMove = BLACK) {
+        b = start;
+        side = toMove;
+        nBlack = popcount64(b.black);
+        nWhite = popcount64(b.white);
+        k = hashOf(b.own(side), b.opp(side));
+        depth = 0;
+        startPassed = settle();
+    }
+
+    const Board& board() const { return b; }
+    char turn() const { return side; }                // 終局後は最後に打った側の相手
+    uint64_t own() const { return b.own(side); }
+    uint64_t opp() const { return b.opp(side); }
+    uint64_t legal() const { return moves; }          // 手番側の合法手（終局なら 0）
+    bool isLegal(int sq) const { return sq >= 0 && sq < N*N && (moves & bitOf(sq)); }
+    int discs(char p) const { return p == BLACK ? nBlack : nWhite; }
+    int empties() const { return N*N - nBlack - nWhite; }
+    const HashPair& key() const { return k; }         // 手番側から見たハッシュ（置換表と同じ）
+    bool over() const { return gameOver; }
+    bool passed() const { return depth ? stack[depth-1].passed : startPassed; } // 直前の着手の後に相手がパスしたか
+    int ply() const { return depth; }                 // 打った手の数（パスは数えない）
+    int lastMove() const { return depth ? stack[depth-1].sq : -1; }
+    char lastMover() const { return depth ? stack[depth-1].side : EMPTY; }
+    bool canUndo() const { return depth > 0; }
+
+    // 手番側が sq に打つ。合法でなければ何もせずに false
+    bool play(int sq) {
+        if (!isLegal(sq)) return false;
+        uint64_t f = flipsBits(own(), opp(), sq);
+        Frame& fr = stack[depth++];
+        fr.sq = sq; fr.flips = f; fr.side = side; fr.moves = moves; fr.k = k;
+        int n = popcount64(f);
+        if (side == BLACK) { b.black |= f | bitOf(sq); b.white &= ~f; nBlack += n + 1; nWhite -= n; }
+        else               { b.white |= f | bitOf(sq); b.black &= ~f; nWhite += n + 1; nBlack -= n; }
+        k = hashAfterMove(k, sq, f);
+        side = opponent(side);
+        fr.passed = settle();
+        return true;
+    }
+    bool play(int r, int c) { return inBounds(r, c) && play(sqOf(r, c)); }
+
+    // 直前の 1手（とその後のパス）を取り消す
+    bool undo() {
+        if (!depth) return false;
+        const Frame& fr = stack[--depth];
+        uint64_t placed = fr.flips | bitOf(fr.sq);
+        int n = popcount64(fr.flips);
+        if (fr.side == BLACK) { b.black &= ~placed; b.white |= fr.flips; nBlack -= n + 1; nWhite += n; }
+        else                  { b.white &= ~placed; b.black |= fr.flips; nWhite -= n + 1; nBlack += n; }
+        side = fr.side;
+        moves = fr.moves;
+        k = fr.k;
+        gameOver = false;
+        return true;
+    }
+
+private:
+    struct Frame {
+        int sq;
+        uint64_t flips;
+        char side;      // 打った側
+        bool passed;    // 打った後に相手がパスしたか
+        uint64_t moves; // 打つ前の合法手とハッシュ（取り消しで戻す）
+        HashPair k;
+    };
+
+    Board b;
+    char side = BLACK;
+    int nBlack = 0, nWhite = 0;
+    uint64_t moves = 0;
+    HashPair k;
+    bool gameOver = false, startPassed = false;
+    int depth = 0;
+    Frame stack[N*N]; // 1手ごとに空きが 1 つ減るので N*N 段で足りる
+
+    // 手番側の合法手を求め、なければパス（相手も打てなければ終局）。パスしたら true
+    bool settle() {
+        gameOver = false;
+        moves = movesBits(own(), opp());
+        if (moves) return false;
+        uint64_t other = movesBits(opp(), own());
+        if (!other) { gameOver = true; return false; }
+        side = opponent(side);
+        k = hashAfterPass(k);
+        moves = other;
+        return true;
+    }
+};
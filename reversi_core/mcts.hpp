@@ -0,0 +1,384 @@
+// mcts.hpp - 並列モンテカルロ木探索（UCT）。αβ 探索（search.hpp）の代わりに選べるもう1つの AI
+// 1回の反復で、根から UCT で子を選んで葉まで降り、葉を展開して 1 局ランダムに打ち切り（プレイアウト）、
+// 勝敗を通った節点に足す。最後は訪問回数の最も多い手を選ぶ。
+//
+// ・節点は連続した配列（アリーナ）から番号で切り出し、1 節点ずつの new はしない。子は連続して並ぶ
+// ・複数のスレッドが同じ木を降りる。降りるときに訪問回数を先に足しておく（得点は 0 のまま）ので、
+//   結果が戻るまでその道は負けが 1 回増えたように見え、他のスレッドは別の道を選ぶ（virtual loss）
+// ・次の探索の根が前の木の子・孫にあれば、その部分木だけをもう1つのアリーナに写して使い続け、
+//   残りは番号を 0 に戻してまとめて捨てる
+//
+// ゲームごとの違いは G（アダプタ）にまとめる。G に要るもの:
+//   static const int MAX_MOVES;           1局面の手の数の上限
+//   int toMove() const;                   手番（0 / 1）
+//   int legalMoves(int* out) const;       展開する手（0 なら終局）
+//   void play(int m); void undo();        1手進める / 戻す
+//   int outcome() const;                  終局の得点（先手 0 から見て 勝ち 2 / 引き分け 1 / 負け 0）
+//   template <class R> int playout(R& rng);  今の局面から終局まで打った得点（局面は元に戻す）
+//   bool samePosition(const G& o) const;  同じ局面か（木の使い回しの判定）
+// オセロ用は ReversiMctsGame、m,n,k 目並べ用は tic_tac_toe/mnk_mcts.hpp。
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "bitboard.hpp"
+#include "eval.hpp"
+
+struct MctsLimits {
+    int timeMs = 1000;            // 1手あたりの持ち時間（0 なら無制限）
+    uint64_t maxPlayouts = 0;     // 1手あたりのプレイアウト数の上限（0 なら無制限）
+    int threads = 1;
+    double exploration = 0.8;     // UCT の探索項の係数
+    size_t memoryMb = 64;         // 2 つのアリーナの合計
+    bool reuse = true;            // 前の手の木を使い回す
+};
+
+struct MctsResult {
+    int move = -1;
+    double winRate = 0.5;   // 選んだ手の勝率（引き分けは 0.5）
+    uint64_t playouts = 0;  // この探索で足したプレイアウト数
+    uint64_t reused = 0;    // 使い回した木の根の訪問回数
+    size_t nodes = 0;       // 探索後の木の節点数
+    double seconds = 0;
+    int threads = 1;
+
+    double pps() const { return seconds > 0 ? playouts / seconds : 0; }
+    std::string summary() const {
+        char buf[192];
+        std::snprintf(buf, sizeof(buf), "mcts win=%.1f%% playouts=%llu (%.0f/s) reused=%llu nodes=%zu time=%.3fs",
+                      winRate * 100, (unsigned long long)playouts, pps(), (unsigned long long)reused, nodes, seconds);
+        std::string out = buf;
+        if (threads > 1) out += " threads=" + std::to_string(threads);
+        return out;
+    }
+};
+
+struct MctsNode {
+    std::atomic<uint32_t> visits;
+    std::atomic<uint32_t> score;      // この節点に入る手を打った側から見た得点（勝ち 2 / 引き分け 1）
+    std::atomic<uint32_t> firstChild;
+    std::atomic<uint8_t> state;       // 0 未展開 / 1 展開中 / 2 展開済み
+    uint16_t childCount;
+    int16_t move;
+
+    void init(int m) {
+        visits.store(0, std::memory_order_relaxed);
+        score.store(0, std::memory_order_relaxed);
+        firstChild.store(0, std::memory_order_relaxed);
+        state.store(0, std::memory_order_relaxed);
+        childCount = 0;
+        move = (int16_t)m;
+    }
+};
+
+// 節点の置き場。alloc は複数スレッドから呼べて、使い切ったら UINT32_MAX を返す
+class MctsArena {
+public:
+    void resize(size_t n) { nodes.reset(new MctsNode[n]); cap = n; used = 0; }
+    void clear() { used.store(0, std::memory_order_relaxed); }
+    MctsNode& operator[](uint32_t i) { return nodes[i]; }
+    const MctsNode& operator[](uint32_t i) const { return nodes[i]; }
+    size_t size() const { size_t u = used.load(std::memory_order_relaxed); return u < cap ? u : cap; }
+    size_t capacity() const { return cap; }
+
+    uint32_t alloc(size_t n) {
+        size_t at = used.fetch_add(n, std::memory_order_relaxed);
+        return at + n <= cap ? (uint32_t)at : UINT32_MAX;
+    }
+
+private:
+    std::unique_ptr<MctsNode[]> nodes;
+    size_t cap = 0;
+    std::atomic<size_t> used{0};
+};
+
+template <class G>
+class MctsSearcher {
+public:
+    MctsLimits limits;
+
+    // 手番側の最善手を探す。前の探索の木に g があればそこから続ける
+    MctsResult search(const G& g) {
+        auto start = std::chrono::steady_clock::now();
+        stopFlag = false;
+        prepare();
+        setRoot(g);
+        MctsNode& r = arena()[0];
+        if (r.state.load() != 2) expand(r, *rootGame);
+        MctsResult res;
+        res.reused = r.visits.load();
+        int nThreads = limits.threads < 1 ? 1 : limits.threads;
+        res.threads = nThreads;
+        if (r.childCount == 0) return res;
+
+        std::atomic<uint64_t> playouts{0};
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < nThreads; ++i) helpers.emplace_back([&, i]() { worker(i, start, playouts); });
+        worker(0, start, playouts);
+        for (std::thread& t : helpers) t.join();
+
+        // 訪問回数の最も多い手（robust child）
+        uint32_t best = r.firstChild.load(), bestVisits = 0;
+        for (uint32_t i = 0; i < r.childCount; ++i) {
+            const MctsNode& c = arena()[r.firstChild.load() + i];
+            if (c.visits.load() > bestVisits) { bestVisits = c.visits.load(); best = r.firstChild.load() + i; }
+        }
+        const MctsNode& b = arena()[best];
+        res.move = b.move;
+        res.winRate = b.visits.load() ? b.score.load() / (2.0 * b.visits.load()) : 0.5;
+        res.playouts = playouts.load();
+        res.nodes = arena().size();
+        res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return res;
+    }
+
+    // 別スレッドから探索を打ち切る
+    void stop() { stopFlag = true; }
+    // 木を捨てる（新しい対局を始めるとき）
+    void clear() { rootGame.reset(); }
+
+private:
+    MctsArena arenas[2];
+    int cur = 0;
+    size_t arenaMb = 0;
+    std::unique_ptr<G> rootGame;
+    std::atomic<bool> stopFlag{false};
+
+    MctsArena& arena() { return arenas[cur]; }
+
+    void prepare() {
+        if (arenaMb == limits.memoryMb && arenas[0].capacity()) return;
+        arenaMb = limits.memoryMb;
+        size_t n = arenaMb * 1024 * 1024 / 2 / sizeof(MctsNode);
+        if (n < 1024) n = 1024;
+        arenas[0].resize(n);
+        arenas[1].resize(n);
+        rootGame.reset();
+    }
+
+    // g が前の根か、その子・孫なら部分木を写して使い、そうでなければ根だけの木から始める
+    void setRoot(const G& g) {
+        uint32_t found = UINT32_MAX;
+        if (limits.reuse && rootGame) {
+            if (rootGame->samePosition(g)) found = 0;
+            MctsNode& r = arena()[0];
+            for (uint32_t i = 0; found == UINT32_MAX && r.state.load() == 2 && i < r.childCount; ++i) {
+                uint32_t ci = r.firstChild.load() + i;
+                MctsNode& c = arena()[ci];
+                rootGame->play(c.move);
+                if (rootGame->samePosition(g)) found = ci;
+                for (uint32_t j = 0; found == UINT32_MAX && c.state.load() == 2 && j < c.childCount; ++j) {
+                    uint32_t gi = c.firstChild.load() + j;
+                    rootGame->play(arena()[gi].move);
+                    if (rootGame->samePosition(g)) found = gi;
+                    rootGame->undo();
+                }
+                rootGame->undo();
+            }
+        }
+        rootGame.reset(new G(g));
+        if (found == 0) return;
+        MctsArena& to = arenas[cur ^ 1];
+        to.clear();
+        to.alloc(1);
+        to[0].init(-1);
+        if (found != UINT32_MAX) copySubtree(found, to);
+        arena().clear(); // 古い木はまとめて捨てる
+        cur ^= 1;
+    }
+
+    // arena() の節点 from を根として to に写す（幅優先。子が連続して並ぶ形を保つ）
+    void copySubtree(uint32_t from, MctsArena& to) {
+        std::vector<std::pair<uint32_t, uint32_t>> queue{{from, 0}};
+        for (size_t q = 0; q < queue.size(); ++q) {
+            const MctsNode& s = arena()[queue[q].first];
+            MctsNode& d = to[queue[q].second];
+            d.visits.store(s.visits.load());
+            d.score.store(s.score.load());
+            if (s.state.load() != 2) continue;
+            uint32_t base = to.alloc(s.childCount);
+            if (base == UINT32_MAX) continue; // 入りきらない部分は未展開に戻す
+            for (uint32_t i = 0; i < s.childCount; ++i) {
+                to[base + i].init(arena()[s.firstChild.load() + i].move);
+                queue.push_back({s.firstChild.load() + i, base + i});
+            }
+            d.childCount = s.childCount;
+            d.firstChild.store(base);
+            d.state.store(2);
+        }
+    }
+
+    // 子を作る。展開中（他のスレッド）やアリーナが尽きたときは false
+    bool expand(MctsNode& n, const G& g) {
+        uint8_t expected = 0;
+        if (!n.state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) return false;
+        int moves[G::MAX_MOVES];
+        int k = g.legalMoves(moves);
+        uint32_t base = k ? arena().alloc(k) : 0;
+        if (base == UINT32_MAX) { n.state.store(0, std::memory_order_release); return false; }
+        for (int i = 0; i < k; ++i) arena()[base + i].init(moves[i]);
+        n.childCount = (uint16_t)k;
+        n.firstChild.store(base, std::memory_order_relaxed);
+        n.state.store(2, std::memory_order_release);
+        return true;
+    }
+
+    // UCT で子を選ぶ。まだ誰も通っていない子があれば先にそれを選ぶ
+    uint32_t select(const MctsNode& n) const {
+        uint32_t first = n.firstChild.load(std::memory_order_relaxed), best = first;
+        double logN = std::log((double)n.visits.load(std::memory_order_relaxed) + 1), bestValue = -1;
+        for (uint32_t i = 0; i < n.childCount; ++i) {
+            const MctsNode& c = arenas[cur][first + i];
+            uint32_t v = c.visits.load(std::memory_order_relaxed);
+            if (v == 0) return first + i;
+            double value = c.score.load(std::memory_order_relaxed) / (2.0 * v) + limits.exploration * std::sqrt(logN / v);
+            if (value > bestValue) { bestValue = value; best = first + i; }
+        }
+        return best;
+    }
+
+    void worker(int id, std::chrono::steady_clock::time_point start, std::atomic<uint64_t>& playouts) {
+        G g(*rootGame);
+        std::mt19937_64 rng(0x9E3779B97F4A7C15ULL * (id + 1) ^ (uint64_t)start.time_since_epoch().count());
+        uint32_t path[512];
+        int mover[512];
+        for (uint64_t iter = 0;; ++iter) {
+            if ((iter & 63) == 0) {
+                if (stopFlag.load(std::memory_order_relaxed)) break;
+                if (limits.timeMs > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000
+                    >= limits.timeMs) break;
+            }
+            if (limits.maxPlayouts && playouts.load(std::memory_order_relaxed) >= limits.maxPlayouts) break;
+
+            // 選択：訪問回数を先に足して降りる（virtual loss）
+            int len = 0;
+            uint32_t ni = 0;
+            arena()[0].visits.fetch_add(1, std::memory_order_relaxed);
+            for (;;) {
+                MctsNode& n = arena()[ni];
+                if (n.state.load(std::memory_order_acquire) != 2) {
+                    // 展開：子を作れたら 1 つ降りてからプレイアウト
+                    if (len >= 510 || !expand(n, g)) break;
+                }
+                if (n.childCount == 0) break; // 終局
+                uint32_t ci = select(n);
+                MctsNode& c = arena()[ci];
+                c.visits.fetch_add(1, std::memory_order_relaxed);
+                mover[len] = g.toMove();
+                path[len++] = ci;
+                g.play(c.move);
+                ni = ci;
+                if (c.state.load(std::memory_order_relaxed) == 0) {
+                    if (c.visits.load(std::memory_order_relaxed) <= 1) break; // 初めての節点はプレイアウトだけ
+                }
+            }
+
+            // プレイアウトと逆伝播（得点は先手 0 から見た値）
+            MctsNode& leaf = arena()[ni];
+            int result = leaf.state.load(std::memory_order_acquire) == 2 && leaf.childCount == 0 ? g.outcome() : g.playout(rng);
+            for (int i = len - 1; i >= 0; --i) {
+                arena()[path[i]].score.fetch_add(mover[i] == 0 ? result : 2 - result, std::memory_order_relaxed);
+                g.undo();
+            }
+            playouts.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+// オセロのアダプタ。パスも 1 手（MCTS_PASS）として木に入れる。
+// プレイアウトは軽く偏らせたランダム：合法手から 2 つ引いて位置の重み（eval.hpp の W）の高い方を打つ
+static const int MCTS_PASS = N*N;
+
+class ReversiMctsGame {
+public:
+    static const int MAX_MOVES = N*N; // 合法手の数の上限（パスのときは MCTS_PASS の 1手）
+
+    ReversiMctsGame(uint64_t P, uint64_t O, int side = 0) : P(P), O(O), side(side) {}
+
+    int toMove() const { return side; }
+    int legalMoves(int* out) const {
+        uint64_t m = movesBits(P, O);
+        if (!m) {
+            if (!movesBits(O, P)) return 0;
+            out[0] = MCTS_PASS;
+            return 1;
+        }
+        int n = 0;
+        for (; m; m &= m - 1) out[n++] = lsb64(m);
+        return n;
+    }
+    void play(int m) {
+        history.push_back({P, O});
+        if (m != MCTS_PASS) {
+            uint64_t f = flipsBits(P, O, m);
+            uint64_t np = O ^ f, no = P | f | bitOf(m);
+            P = np; O = no;
+        } else {
+            std::swap(P, O);
+        }
+        side ^= 1;
+    }
+    void undo() {
+        P = history.back().first;
+        O = history.back().second;
+        history.pop_back();
+        side ^= 1;
+    }
+    int outcome() const { return scoreOf(P, O, side); }
+
+    template <class R>
+    int playout(R& rng) const {
+        uint64_t p = P, o = O;
+        int s = side;
+        bool passed = false;
+        for (;;) {
+            uint64_t m = movesBits(p, o);
+            if (!m) {
+                if (passed) break;
+                passed = true;
+                std::swap(p, o);
+                s ^= 1;
+                continue;
+            }
+            passed = false;
+            int sq = pick(m, rng);
+            uint64_t f = flipsBits(p, o, sq);
+            uint64_t np = o ^ f, no = p | f | bitOf(sq);
+            p = np; o = no;
+            s ^= 1;
+        }
+        return scoreOf(p, o, s);
+    }
+
+    bool samePosition(const ReversiMctsGame& g) const { return P == g.P && O == g.O && side == g.side; }
+
+private:
+    uint64_t P, O;
+    int side;
+    std::vector<std::pair<uint64_t, uint64_t>> history;
+
+    static int scoreOf(uint64_t p, uint64_t o, int s) {
+        int d = popcount64(p) - popcount64(o);
+        if (s) d = -d;
+        return d > 0 ? 2 : d < 0 ? 0 : 1;
+    }
+    template <class R>
+    static int pick(uint64_t m, R& rng) {
+        int n = popcount64(m);
+        int a = nthBit(m, (int)(rng() % n)), b = nthBit(m, (int)(rng() % n));
+        return W[a / N][a % N] >= W[b / N][b % N] ? a : b;
+    }
+    static int nthBit(uint64_t m, int k) {
+        for (; k > 0; --k) m &= m - 1;
+        return lsb64(m);
+    }
+};
@@ -0,0 +1,308 @@
+// pattern.hpp - パターン評価（辺・隅・斜め・2×5 隅ブロックの石の並びごとの重み表）
+// 盤上の決まったマスの組（パターン）の状態を 3進数の index（0:空き, 1:手番側, 2:相手）にして重み表を引き、
+// 全パターンぶん足したものを評価値にする。重みは形ごとに 1 つの表を 8 通りの対称形で共有し、
+// 石数で分けた PATTERN_PHASES 個の段階ごとに別の表を持つ。
+//
+// index は着手のたびに、置いた石と返った石を含むパターンだけを差分で更新する（PatternState::play）。
+// 手番が替わると 1 と 2 の意味が入れ替わるので、両方の視点の index を持っておき、着手・パスで入れ替える。
+//
+// 重みの既定値は W（eval.hpp）を各パターンに配分し、隅が埋まった後の X・C 打ちの減点を外して
+// 辺の確定石に加点したもの。学習した重み（石差 1 = PATTERN_DISC_SCALE）は reversi_train が書き出し、
+// 各プログラムが起動時に --weights（既定 reversi.weights）から読む。
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bitboard.hpp"
+#include "eval.hpp"
+
+static const int PATTERN_PHASES = 12;  // 石数 4〜63 を 5 石ごとに区切る
+static const int PATTERN_MAX_LEN = 10;
+static const int PATTERN_MAX_PER_SQ = 12; // 1 マスを含むパターンの最大数
+static const int PATTERN_EVAL_MAX = 30000;  // 評価値の上限（終局スコアより必ず小さくする）
+static const int PATTERN_DISC_SCALE = 32;   // 学習した重みの単位（石差 1 = 32）
+
+inline int patternPhase(uint64_t P, uint64_t O) {
+    int ph = (popcount64(P | O) - 4) / 5;
+    return ph < PATTERN_PHASES - 1 ? ph : PATTERN_PHASES - 1;
+}
+
+// 形の定義（基準の向き。残りの向きは対称変換で作る）
+struct PatternShape {
+    const char* name;
+    const char* squares;
+};
+
+static constexpr PatternShape PATTERN_SHAPES[] = {
+    {"edge+2x",   "a1 b1 c1 d1 e1 f1 g1 h1 b2 g2"},
+    {"corner3x3", "a1 b1 c1 a2 b2 c2 a3 b3 c3"},
+    {"corner2x5", "a1 b1 c1 d1 e1 a2 b2 c2 d2 e2"},
+    {"line2",     "a2 b2 c2 d2 e2 f2 g2 h2"},
+    {"line3",     "a3 b3 c3 d3 e3 f3 g3 h3"},
+    {"line4",     "a4 b4 c4 d4 e4 f4 g4 h4"},
+    {"diag8",     "a1 b2 c3 d4 e5 f6 g7 h8"},
+    {"diag7",     "b1 c2 d3 e4 f5 g6 h7"},
+    {"diag6",     "c1 d2 e3 f4 g5 h6"},
+    {"diag5",     "d1 e2 f3 g4 h5"},
+    {"diag4",     "e1 f2 g3 h4"},
+};
+static const int PATTERN_SHAPE_COUNT = sizeof(PATTERN_SHAPES) / sizeof(PATTERN_SHAPES[0]);
+
+// 形を 8 通りの対称変換で置いたとき、マスの集合が異なるものの数（PatternLayout と同じ数え方を定数式で）
+constexpr int patternPlacements(const char* s) {
+    uint64_t seen[8] = {};
+    int nSeen = 0;
+    for (int sym = 0; sym < 8; ++sym) {
+        uint64_t mask = 0;
+        for (const char* p = s; p[0] && p[1]; p += p[2] ? 3 : 2) {
+            int r = p[1] - '1', c = p[0] - 'a';
+            if (sym & 4) { int t = r; r = c; c = t; }
+            if (sym & 1) r = N - 1 - r;
+            if (sym & 2) c = N - 1 - c;
+            mask |= 1ULL << (r * N + c);
+        }
+        bool dup = false;
+        for (int k = 0; k < nSeen; ++k) dup = dup || seen[k] == mask;
+        if (!dup) seen[nSeen++] = mask;
+    }
+    return nSeen;
+}
+
+constexpr int patternFeatureCount() {
+    int n = 0;
+    for (const PatternShape& shape : PATTERN_SHAPES) n += patternPlacements(shape.squares);
+    return n;
+}
+static constexpr int PATTERN_FEATURES = patternFeatureCount(); // 盤上に置いたパターンの総数（形ごとの対称形の数の和）
+
+// パターンの配置（起動時に一度だけ作る）
+struct PatternLayout {
+    int shapeLen[PATTERN_SHAPE_COUNT];
+    int shapeSquares[PATTERN_SHAPE_COUNT][PATTERN_MAX_LEN];
+    int shapeOffset[PATTERN_SHAPE_COUNT + 1]; // 重み表の中での各形の先頭（最後は表全体の大きさ）
+
+    int featureShape[PATTERN_FEATURES];
+    int featureOffset[PATTERN_FEATURES];   // = shapeOffset[featureShape]
+    int featureLen[PATTERN_FEATURES];
+    int featureSquares[PATTERN_FEATURES][PATTERN_MAX_LEN]; // 先頭のマスが 3^0 の桁
+
+    // マス → そのマスを含むパターンと桁の重み 3^i
+    int sqCount[N*N];
+    uint16_t sqFeature[N*N][PATTERN_MAX_PER_SQ];
+    uint16_t sqPow[N*N][PATTERN_MAX_PER_SQ];
+
+    PatternLayout() {
+        std::memset(sqCount, 0, sizeof(sqCount));
+        int f = 0, offset = 0;
+        for (int t = 0; t < PATTERN_SHAPE_COUNT; ++t) {
+            const char* s = PATTERN_SHAPES[t].squares;
+            int len = 0;
+            for (; s[0] && s[1]; s += s[2] ? 3 : 2) shapeSquares[t][len++] = sqOf(s[1] - '1', s[0] - 'a');
+            shapeLen[t] = len;
+            shapeOffset[t] = offset;
+            int size = 1;
+            for (int i = 0; i < len; ++i) size *= 3;
+            offset += size;
+
+            // 8 通りの対称変換のうち、マスの集合が異なるものだけを配置する
+            uint64_t seen[8];
+            int nSeen = 0;
+            for (int sym = 0; sym < 8; ++sym) {
+                int sq[PATTERN_MAX_LEN];
+                uint64_t mask = 0;
+                for (int i = 0; i < len; ++i) {
+                    sq[i] = lsb64(transformBits(bitOf(shapeSquares[t][i]), sym));
+                    mask |= bitOf(sq[i]);
+                }
+                bool dup = false;
+                for (int k = 0; k < nSeen; ++k) dup |= seen[k] == mask;
+                if (dup) continue;
+                seen[nSeen++] = mask;
+                featureShape[f] = t;
+                featureOffset[f] = shapeOffset[t];
+                featureLen[f] = len;
+                for (int i = 0, pow = 1; i < len; ++i, pow *= 3) {
+                    featureSquares[f][i] = sq[i];
+                    int& c = sqCount[sq[i]];
+                    sqFeature[sq[i]][c] = (uint16_t)f;
+                    sqPow[sq[i]][c] = (uint16_t)pow;
+                    ++c;
+                }
+                ++f;
+            }
+        }
+        shapeOffset[PATTERN_SHAPE_COUNT] = offset;
+        assert(f == PATTERN_FEATURES);
+    }
+};
+
+inline const PatternLayout& patternLayout() {
+    static const PatternLayout layout;
+    return layout;
+}
+
+// パターンの index（idx[0] は手番側から、idx[1] は相手から見たもの）
+struct PatternState {
+    uint16_t idx[2][PATTERN_FEATURES];
+
+    void init(uint64_t P, uint64_t O) {
+        const PatternLayout& L = patternLayout();
+        std::memset(idx, 0, sizeof(idx));
+        for (uint64_t b = P | O; b; b &= b - 1) {
+            int sq = lsb64(b), own = (P >> sq) & 1 ? 1 : 2;
+            for (int k = 0; k < L.sqCount[sq]; ++k) {
+                int f = L.sqFeature[sq][k], p = L.sqPow[sq][k];
+                idx[0][f] += own * p;
+                idx[1][f] += (3 - own) * p;
+            }
+        }
+    }
+
+    // parent の手番側が sq に打って flips を返した後の局面（手番は相手に移る）
+    void play(const PatternState& parent, int sq, uint64_t flips) {
+        const PatternLayout& L = patternLayout();
+        std::memcpy(idx[0], parent.idx[1], sizeof(idx[0]));
+        std::memcpy(idx[1], parent.idx[0], sizeof(idx[1]));
+        // 新しい手番側から見ると、置かれた石は相手の石（2）、返った石は自分（1）→ 相手（2）
+        for (int k = 0; k < L.sqCount[sq]; ++k) {
+            int f = L.sqFeature[sq][k], p = L.sqPow[sq][k];
+            idx[0][f] += 2 * p;
+            idx[1][f] += p;
+        }
+        for (; flips; flips &= flips - 1) {
+            int s = lsb64(flips);
+            for (int k = 0; k < L.sqCount[s]; ++k) {
+                int f = L.sqFeature[s][k], p = L.sqPow[s][k];
+                idx[0][f] += p;
+                idx[1][f] -= p;
+            }
+        }
+    }
+
+    void pass(const PatternState& parent) {
+        std::memcpy(idx[0], parent.idx[1], sizeof(idx[0]));
+        std::memcpy(idx[1], parent.idx[0], sizeof(idx[1]));
+    }
+};
+
+// 重みファイル（リトルエンディアン）:
+//   PatternWeightsHeader, mobility[phases], parity[phases], table[phases][tableSize]（すべて int16）
+struct PatternWeightsHeader {
+    char magic[8];      // "RVWGT1"
+    uint32_t phases;
+    uint32_t tableSize; // 形の定義が変わったら読み込めないようにする
+};
+static const char PATTERN_WEIGHTS_MAGIC[8] = {'R','V','W','G','T','1','\0','\0'};
+
+// 段階ごとの重み（手番側から見た値）。ファイルに書くときもこの並び
+struct PatternWeights {
+    std::vector<int16_t> table;     // [phase][shapeOffset + index]
+    int16_t mobility[PATTERN_PHASES]; // 着手可能数の差 1 あたり
+    int16_t parity[PATTERN_PHASES];   // 空きマスが奇数のときの手番側への加点
+
+    int tableSize() const { return patternLayout().shapeOffset[PATTERN_SHAPE_COUNT]; }
+    const int16_t* phaseTable(int phase) const { return table.data() + (size_t)phase * tableSize(); }
+    int16_t* phaseTable(int phase) { return table.data() + (size_t)phase * tableSize(); }
+
+    PatternWeights() { setDefaults(); }
+
+    // W を各パターンに配分した値に、隅の有無による X・C 打ちの補正と辺の確定石を足す
+    void setDefaults() {
+        const PatternLayout& L = patternLayout();
+        const int STABLE_BONUS = 12;
+        int cover[N*N];
+        for (int sq = 0; sq < N*N; ++sq) cover[sq] = L.sqCount[sq];
+        table.assign((size_t)PATTERN_PHASES * tableSize(), 0);
+        for (int t = 0; t < PATTERN_SHAPE_COUNT; ++t) {
+            int len = L.shapeLen[t];
+            const int* sqs = L.shapeSquares[t];
+            for (int index = 0; index < L.shapeOffset[t+1] - L.shapeOffset[t]; ++index) {
+                int d[PATTERN_MAX_LEN];
+                for (int i = 0, x = index; i < len; ++i, x /= 3) d[i] = x % 3;
+                auto sign = [&](int i) { return d[i] == 1 ? 1 : d[i] == 2 ? -1 : 0; };
+                double v = 0;
+                for (int i = 0; i < len; ++i) v += sign(i) * (double)W[sqs[i] / N][sqs[i] % N] / cover[sqs[i]];
+                if (t == 0) { // edge+2x: 0..7 が辺、8,9 が b2,g2
+                    const int corner[2] = {0, 7}, cSq[2] = {1, 6}, xSq[2] = {8, 9}, step[2] = {1, -1};
+                    for (int k = 0; k < 2; ++k) {
+                        if (!d[corner[k]]) continue;
+                        // 隅が埋まったら、隣の C・X の減点は外す（X は縦横 2 本の辺パターンに入っているので半分ずつ）
+                        v -= sign(cSq[k]) * W[0][1];
+                        v -= sign(xSq[k]) * W[1][1] / 2.0;
+                        // 隅から同じ色が続く石は返されない
+                        for (int i = corner[k]; i >= 0 && i < 8 && d[i] == d[corner[k]]; i += step[k])
+                            v += sign(i) * STABLE_BONUS;
+                    }
+                }
+                int16_t w = (int16_t)(v >= 0 ? v + 0.5 : v - 0.5);
+                for (int ph = 0; ph < PATTERN_PHASES; ++ph) phaseTable(ph)[L.shapeOffset[t] + index] = w;
+            }
+        }
+        for (int ph = 0; ph < PATTERN_PHASES; ++ph) { mobility[ph] = MOBILITY_WEIGHT; parity[ph] = 0; }
+    }
+
+    bool save(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        PatternWeightsHeader h;
+        std::memcpy(h.magic, PATTERN_WEIGHTS_MAGIC, sizeof(h.magic));
+        h.phases = PATTERN_PHASES;
+        h.tableSize = (uint32_t)tableSize();
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1
+               && std::fwrite(mobility, sizeof(mobility), 1, f) == 1
+               && std::fwrite(parity, sizeof(parity), 1, f) == 1
+               && std::fwrite(table.data(), sizeof(int16_t), table.size(), f) == table.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    // ファイルがない・形式が合わないときは false（今の重みはそのまま）
+    bool load(const std::string& path) {
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return false;
+        PatternWeightsHeader h;
+        std::vector<int16_t> t((size_t)PATTERN_PHASES * tableSize());
+        int16_t mob[PATTERN_PHASES], par[PATTERN_PHASES];
+        bool ok = std::fread(&h, sizeof(h), 1, f) == 1
+               && std::memcmp(h.magic, PATTERN_WEIGHTS_MAGIC, sizeof(h.magic)) == 0
+               && h.phases == PATTERN_PHASES && h.tableSize == (uint32_t)tableSize()
+               && std::fread(mob, sizeof(mob), 1, f) == 1
+               && std::fread(par, sizeof(par), 1, f) == 1
+               && std::fread(t.data(), sizeof(int16_t), t.size(), f) == t.size();
+        std::fclose(f);
+        if (!ok) return false;
+        table.swap(t);
+        std::memcpy(mobility, mob, sizeof(mob));
+        std::memcpy(parity, par, sizeof(par));
+        return true;
+    }
+};
+
+// 探索が使う重み（起動時に差し替えるときは探索を始める前に）
+inline PatternWeights& patternWeights() {
+    static PatternWeights w;
+    return w;
+}
+
+// 手番側 P から見た評価値（index は st から引くので、盤面からは石数と着手可能数だけを求める）
+inline int evaluatePatterns(const PatternState& st, uint64_t P, uint64_t O, const PatternWeights& w) {
+    const PatternLayout& L = patternLayout();
+    int phase = patternPhase(P, O);
+    const int16_t* table = w.phaseTable(phase);
+    int s = 0;
+    for (int f = 0; f < PATTERN_FEATURES; ++f) s += table[L.featureOffset[f] + st.idx[0][f]];
+    int mob = popcount64(movesBits(P, O)) - popcount64(movesBits(O, P));
+    s += mob * w.mobility[phase];
+    if (popcount64(~(P | O)) & 1) s += w.parity[phase];
+    return s > PATTERN_EVAL_MAX ? PATTERN_EVAL_MAX : s < -PATTERN_EVAL_MAX ? -PATTERN_EVAL_MAX : s;
+}
+
+// index を作り直して評価する（探索の外から 1 局面だけ評価するとき用）
+inline int evaluatePatterns(uint64_t P, uint64_t O) {
+    PatternState st;
+    st.init(P, O);
+    return evaluatePatterns(st, P, O, patternWeights());
+}
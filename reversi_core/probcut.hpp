@@ -0,0 +1,103 @@
+// probcut.hpp - Multi-ProbCut（浅い探索の値から深い探索の値を予測し、窓の外に出そうなら読まずに打ち切る）
+// 深さ d の探索値 v は、同じ局面の浅い深さ ds の探索値 v' からおおよそ v = a*v' + b（誤差の標準偏差 σ）と予測できる。
+// a*v' + b >= β + t*σ なら v >= β の見込みが高いので β を返し、a*v' + b <= α - t*σ なら α を返す。
+// 実際には v' >= (β + tσ - b) / a を深さ ds の null window 探索で確かめる（ds = 0 は静的評価そのもの）。
+//
+// Multi-ProbCut として、深さごとに浅い深さを 2 つ（安い方から）試し、a, b, σ は石数の段階ごとに持つ。
+// t は選択度（SearchLimits::selectivity）で決める。0 なら使わず、全幅で読む。
+// a, b, σ は reversi_probcut が自己探索から当てはめて reversi.probcut に書き、各プログラムが起動時に読む。
+// ファイルがなければ組み込みの値（setDefaults）を使う。
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "bitboard.hpp"
+
+static const int PROBCUT_PHASES = 6;     // 石数 4〜63 を 10 石ごとに区切る
+static const int PROBCUT_MIN_DEPTH = 3;
+static const int PROBCUT_MAX_DEPTH = 24;
+static const int PROBCUT_CHECKS = 2;     // 1つの深さで試す浅い深さの数
+static const int SELECTIVITY_LEVELS = 6;
+// 選択度ごとの t（0 は ProbCut なし。正規分布なら t=2.0 で打ち切りの 97.7% が正しい）
+static const double SELECTIVITY_T[SELECTIVITY_LEVELS] = {0, 3.3, 2.6, 2.0, 1.5, 1.1};
+
+inline int probcutPhase(uint64_t P, uint64_t O) {
+    int ph = (popcount64(P | O) - 4) / 10;
+    return ph < PROBCUT_PHASES - 1 ? ph : PROBCUT_PHASES - 1;
+}
+
+// 深さ d の k 番目の確認に使う浅い深さ（使わないなら -1）。d/4 で安く確かめ、だめなら d/2 で確かめる
+inline int probcutShallow(int d, int k) {
+    if (k == 0) return d / 4;
+    return d >= 6 && d / 2 > d / 4 ? d / 2 : -1;
+}
+
+struct ProbCutFit {
+    float a = 1, b = 0, sigma = 0;
+    int samples = 0; // 当てはめに使った局面数（0 は組み込みの値）
+};
+
+struct ProbCutParams {
+    ProbCutFit fit[PROBCUT_PHASES][PROBCUT_MAX_DEPTH + 1][PROBCUT_CHECKS];
+
+    ProbCutParams() { setDefaults(); }
+
+    // 組み込みの重みで reversi_probcut --positions 2000 --depth 10 を当てはめた結果を式にまとめたもの。
+    // σ は深さの差にほぼ比例して増え、評価値の振れが大きくなる終盤ほど大きい。静的評価（ds = 0）からの予測は 4 割ほど粗い。
+    // b は手番の偶奇による評価のずれ（奇数の深さは自分の手番で終わるので高めに出る）
+    void setDefaults() {
+        static const float SIGMA_BASE[PROBCUT_PHASES] = {8, 10, 10, 8, 20, 25};
+        static const float SIGMA_SLOPE[PROBCUT_PHASES] = {1.5f, 3.7f, 7.5f, 14, 21, 28};
+        for (int ph = 0; ph < PROBCUT_PHASES; ++ph)
+            for (int d = 0; d <= PROBCUT_MAX_DEPTH; ++d)
+                for (int k = 0; k < PROBCUT_CHECKS; ++k) {
+                    int ds = probcutShallow(d, k);
+                    ProbCutFit& f = fit[ph][d][k];
+                    f = ProbCutFit();
+                    if (ds < 0) continue;
+                    f.a = 0.9f + 0.07f * ph;
+                    f.b = 32.0f * ((d & 1) - (ds & 1));
+                    f.sigma = (SIGMA_BASE[ph] + SIGMA_SLOPE[ph] * (d - ds)) * (ds == 0 ? 1.4f : 1.0f);
+                }
+    }
+
+    // 1行に 1つ: "phase depth check shallow a b sigma samples"（# で始まる行は注釈）
+    bool save(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) return false;
+        std::fprintf(f, "# reversi.probcut: phase depth check shallow a b sigma samples\n");
+        for (int ph = 0; ph < PROBCUT_PHASES; ++ph)
+            for (int d = PROBCUT_MIN_DEPTH; d <= PROBCUT_MAX_DEPTH; ++d)
+                for (int k = 0; k < PROBCUT_CHECKS; ++k) {
+                    const ProbCutFit& x = fit[ph][d][k];
+                    if (probcutShallow(d, k) < 0 || !x.samples) continue;
+                    std::fprintf(f, "%d %d %d %d %.4f %.2f %.2f %d\n", ph, d, k, probcutShallow(d, k), x.a, x.b, x.sigma, x.samples);
+                }
+        return std::fclose(f) == 0;
+    }
+
+    // ファイルがなければ false。書かれていない組は今の値のまま
+    bool load(const std::string& path) {
+        FILE* f = std::fopen(path.c_str(), "r");
+        if (!f) return false;
+        char line[256];
+        while (std::fgets(line, sizeof(line), f)) {
+            if (line[0] == '#') continue;
+            int ph, d, k, ds, n;
+            float a, b, s;
+            if (std::sscanf(line, "%d %d %d %d %f %f %f %d", &ph, &d, &k, &ds, &a, &b, &s, &n) != 8) continue;
+            if (ph < 0 || ph >= PROBCUT_PHASES || d < 0 || d > PROBCUT_MAX_DEPTH || k < 0 || k >= PROBCUT_CHECKS
+                || ds != probcutShallow(d, k) || !(a > 0) || !(s > 0)) continue;
+            fit[ph][d][k] = {a, b, s, n};
+        }
+        std::fclose(f);
+        return true;
+    }
+};
+
+// 探索が使う値（起動時に差し替えるときは探索を始める前に）
+inline ProbCutParams& probcutParams() {
+    static ProbCutParams p;
+    return p;
+}
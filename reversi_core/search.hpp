@@ -0,0 +1,471 @@
+// search.hpp - 反復深化つき negamax αβ 探索（時間・ノード数の予算つき、Lazy SMP で並列化、Multi-ProbCut で枝刈り）
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bitboard.hpp"
+#include "endgame.hpp"
+#include "eval.hpp"
+#include "pattern.hpp"
+#include "probcut.hpp"
+#include "stats.hpp"
+#include "tt.hpp"
+
+static const int SCORE_INF = 1000000;
+static const int SCORE_WIN = 100000; // 終局スコア = ±SCORE_WIN + 石差
+static const int MAX_MOVES = N*N;    // 1局面の合法手数の上限
+static const int SOLVE_PREP_DEPTH = 8; // 読み切り前の中盤探索の深さ
+
+// 石差 → 探索スコア（勝敗が確定した値は評価値より必ず大きくする）
+inline int diffToScore(int diff) {
+    return diff > 0 ? SCORE_WIN + diff : diff < 0 ? -SCORE_WIN + diff : 0;
+}
+
+inline int finalScore(uint64_t P, uint64_t O) { return diffToScore(finalDiff(P, O)); }
+
+inline bool isMateScore(int s) { return s >= SCORE_WIN - N*N || s <= -SCORE_WIN + N*N; }
+
+inline std::string squareName(int sq) {
+    if (sq < 0) return "pass";
+    return std::string(1, char('a' + sq % N)) + char('1' + sq / N);
+}
+
+// 評価値の表示（終局読み切りなら石差で表す）
+inline std::string scoreText(int s) {
+    char buf[32];
+    if (s == 0 || !isMateScore(s)) std::snprintf(buf, sizeof(buf), "%+d", s);
+    else std::snprintf(buf, sizeof(buf), "%s%+d", s > 0 ? "win" : "loss", s > 0 ? s - SCORE_WIN : s + SCORE_WIN);
+    return buf;
+}
+
+struct SearchLimits {
+    int maxDepth = 60;
+    int timeMs = 1000;     // 1手あたりの持ち時間（0 なら無制限）
+    uint64_t maxNodes = 0; // 1手あたりのノード数上限（0 なら無制限）
+    int exactEmpties = 20; // 空きがこれ以下なら最終石差まで読み切る
+    int wldEmpties = 22;   // 空きがこれ以下なら勝敗だけ読み切る
+    int threads = 1;       // 探索スレッド数（Lazy SMP）
+    int selectivity = 3;   // ProbCut の選択度 0〜5（0 は全幅。大きいほど大胆に打ち切る。probcut.hpp）
+};
+
+enum SolveKind { SOLVE_NONE = 0, SOLVE_WLD = 1, SOLVE_EXACT = 2 };
+
+struct SearchResult {
+    int bestSq = -1;   // -1 はパス
+    int score = 0;     // 手番側から見た評価値
+    int depth = 0;     // 完了した反復の深さ（読み切ったときは空きマス数）
+    int solved = SOLVE_NONE;
+    int threads = 1;
+    uint64_t nodes = 0;   // 全スレッドの合計
+    double seconds = 0;
+
+    uint64_t nps() const { return seconds > 0 ? (uint64_t)(nodes / seconds) : nodes; }
+    std::string summary() const {
+        static const char* SOLVE_NAME[3] = {"", " solved=wld", " solved=exact"};
+        std::string sc = solved == SOLVE_WLD ? (score > 0 ? "win" : score < 0 ? "loss" : "draw") : scoreText(score);
+        char buf[192];
+        std::snprintf(buf, sizeof(buf), "depth=%d score=%s%s nodes=%llu time=%.3fs nps=%llu",
+                      depth, sc.c_str(), SOLVE_NAME[solved], (unsigned long long)nodes, seconds,
+                      (unsigned long long)nps());
+        std::string out = buf;
+        if (threads > 1) out += " threads=" + std::to_string(threads);
+        return out;
+    }
+};
+
+// 全スレッドで共有する探索の状態
+struct SearchShared {
+    using Clock = std::chrono::steady_clock;
+    const SearchLimits& limits;
+    TranspositionTable& tt;
+    TranspositionTable& endgameTT;
+    const std::atomic<bool>& stopFlag;  // 外部からの停止要求
+    const PatternWeights& weights;      // 末端の評価に使う重み
+    const ProbCutParams& probcut;
+    double probcutT = 0;                // 打ち切りに使う σ の倍数（0 なら ProbCut なし）
+    std::atomic<bool> helpersStop{false}; // メインスレッドが終わったら補助スレッドを止める
+    std::atomic<uint64_t> nodeCount{0};   // 全スレッドのノード数（1024 単位で加算）
+    Clock::time_point start;
+    int timeBudgetMs = 0;    // 中盤探索に使える時間・ノード数
+    uint64_t nodeBudget = 0;
+
+    SearchShared(const SearchLimits& l, TranspositionTable& t, TranspositionTable& et, const std::atomic<bool>& stop,
+                 const PatternWeights& w, const ProbCutParams& pc)
+        : limits(l), tt(t), endgameTT(et), stopFlag(stop), weights(w), probcut(pc), start(Clock::now()) {
+        int sel = l.selectivity < 0 ? 0 : l.selectivity >= SELECTIVITY_LEVELS ? SELECTIVITY_LEVELS - 1 : l.selectivity;
+        probcutT = SELECTIVITY_T[sel];
+    }
+    double elapsed() const { return std::chrono::duration<double>(Clock::now() - start).count(); }
+};
+
+// 探索スレッド1本ぶんの状態。id 0 がメインスレッドで、結果はメインのものを使う。
+// 補助スレッド（Lazy SMP）は同じ局面を深さをずらして読み、共有の置換表を埋めてメインを速くする
+class SearchThread {
+public:
+    using Clock = SearchShared::Clock;
+    uint64_t nodes = 0;
+    STATS(ThreadStats stats;) // 反復の深さごとの数と処理ごとの時間（-DREVERSI_STATS のときだけ）
+
+    SearchThread(SearchShared& shared, int threadId) : sh(shared), id(threadId), endgame(shared.endgameTT, threadId) {}
+
+    void run(uint64_t P, uint64_t O, const HashPair& key, int maxDepth, bool solving, SearchResult& res,
+             const std::function<void(const SearchResult&)>& onIteration) {
+        ps = states;
+        ps->init(P, O);
+        for (int depth = 1; depth <= maxDepth; ++depth) {
+            if (id > 0 && skipDepth(depth)) continue;
+            STATS(iterDepth = depth;)
+            int sq = res.bestSq, score = rootSearch(P, O, key, depth, sq);
+            if (aborted) break;
+            res.bestSq = sq;
+            res.score = score;
+            res.depth = depth;
+            if (id == 0) {
+                res.nodes = totalNodes();
+                res.seconds = sh.elapsed();
+                if (onIteration) onIteration(res);
+            }
+            if (isMateScore(score)) break;                         // 勝敗が確定
+            if (id == 0 && sh.timeBudgetMs > 0 && sh.elapsed() * 1000 > sh.timeBudgetMs / 2) break; // 次の反復は間に合わない
+        }
+        if (solving && !stopRequested()) solve(P, O, res, onIteration);
+    }
+
+private:
+    SearchShared& sh;
+    int id;
+    bool aborted = false;
+    bool inProbCut = false; // ProbCut の浅い探索の中では重ねて使わない
+    EndgameSolver endgame;
+    // パターン評価の index。ps が今の局面で、子局面は ps[1] に差分で作る（パスも 1 段使う）
+    PatternState states[2 * N*N + 2];
+    PatternState* ps = states;
+    STATS(int iterDepth = 0;)
+    STATS(bool timed() const { return (nodes & (STATS_SAMPLE - 1)) == 0; })
+
+    const std::atomic<bool>& stopSignal() const { return id == 0 ? sh.stopFlag : sh.helpersStop; }
+    bool stopRequested() const { return stopSignal().load(std::memory_order_relaxed); }
+    uint64_t totalNodes() const { return sh.nodeCount.load(std::memory_order_relaxed) + (nodes & 1023); }
+
+    // 補助スレッドは反復の深さを間引いて、メインより先の深さを読む
+    bool skipDepth(int depth) const {
+        static const int SKIP_SIZE[20]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+        static const int SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+        int i = (id - 1) % 20;
+        return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2 != 0;
+    }
+
+    bool checkAbort() {
+        if (aborted) return true;
+        if ((nodes & 1023) == 0) {
+            uint64_t total = sh.nodeCount.fetch_add(1024, std::memory_order_relaxed) + 1024;
+            if (stopRequested()) aborted = true;
+            else if (sh.nodeBudget && total >= sh.nodeBudget) aborted = true;
+            else if (sh.timeBudgetMs > 0 && sh.elapsed() * 1000 >= sh.timeBudgetMs) aborted = true;
+        }
+        return aborted;
+    }
+
+    // 終盤読み切り。残りの予算で読み切れたときだけ res を置き換える
+    void solve(uint64_t P, uint64_t O, SearchResult& res, const std::function<void(const SearchResult&)>& onIteration) {
+        const SearchLimits& limits = sh.limits;
+        int empties = N*N - popcount64(P | O);
+        bool wld = empties > limits.exactEmpties;
+        endgame.stopFlag = &stopSignal();
+        endgame.deadline = limits.timeMs > 0 ? sh.start + std::chrono::milliseconds(limits.timeMs)
+                                             : Clock::time_point::max();
+        uint64_t used = sh.nodeCount.load(std::memory_order_relaxed);
+        endgame.maxNodes = limits.maxNodes ? (limits.maxNodes > used ? limits.maxNodes - used : 1) : 0;
+        endgame.nodes = 0;
+
+        // 補助スレッドはルートの別の手から読み始めて、置換表を先に埋める
+        int firstSq = res.bestSq;
+        if (id > 0) {
+            uint64_t m = movesBits(P, O);
+            for (int k = id % popcount64(m); k > 0; --k) m &= m - 1;
+            firstSq = lsb64(m);
+        }
+        int sq = res.bestSq;
+        int diff = STATS_TIMED(true, stats.phaseTicks[PHASE_ENDGAME], endgame.solveRoot(P, O, wld, firstSq, sq));
+        nodes += endgame.nodes;
+        STATS(stats.endgameNodes += endgame.nodes;)
+        if (endgame.aborted) return;
+        if (wld) diff = diff > 0 ? 1 : diff < 0 ? -1 : 0; // 窓の外の値は境界にすぎない
+        res.bestSq = sq;
+        res.score = diffToScore(diff);
+        res.depth = empties;
+        res.solved = wld ? SOLVE_WLD : SOLVE_EXACT;
+        if (id == 0) {
+            res.nodes = totalNodes() + endgame.nodes;
+            res.seconds = sh.elapsed();
+            if (onIteration) onIteration(res);
+        }
+    }
+
+    // 手の並べ替え：相手の着手可能数が少ない順（同数なら位置重みの高い順）
+    int orderMoves(uint64_t P, uint64_t O, uint64_t moves, int firstSq, int* out) const {
+        int n = 0, key[MAX_MOVES];
+        for (; moves; moves &= moves - 1) {
+            int sq = lsb64(moves);
+            uint64_t f = flipsBits(P, O, sq);
+            int k = popcount64(movesBits(O ^ f, P | f | bitOf(sq))) * 256 - W[sq / N][sq % N];
+            if (sq == firstSq) k = -SCORE_INF;
+            int i = n++;
+            while (i > 0 && key[i-1] > k) { key[i] = key[i-1]; out[i] = out[i-1]; --i; }
+            key[i] = k; out[i] = sq;
+        }
+        return n;
+    }
+
+    int rootSearch(uint64_t P, uint64_t O, const HashPair& key, int depth, int& bestSq) {
+        int order[MAX_MOVES];
+        int n = orderMoves(P, O, movesBits(P, O), bestSq, order);
+        int alpha = -SCORE_INF, beta = SCORE_INF;
+        for (int i = 0; i < n; ++i) {
+            int sq = order[i];
+            uint64_t f = flipsBits(P, O, sq);
+            ps[1].play(ps[0], sq, f);
+            ++ps;
+            int s = -negamax(O ^ f, P | f | bitOf(sq), hashAfterMove(key, sq, f), depth - 1, -beta, -alpha);
+            --ps;
+            if (aborted) break;
+            if (s > alpha) { alpha = s; bestSq = sq; }
+        }
+        if (!aborted) sh.tt.store(key.h, alpha, depth, BOUND_EXACT, bestSq, id);
+        return alpha;
+    }
+
+    // Multi-ProbCut：浅い深さの null window 探索で、深さ depth の値が窓の外に出るかを予測する。
+    // 打ち切れるなら score に返す値（β か α）を入れて true
+    bool probCut(uint64_t P, uint64_t O, const HashPair& key, int depth, int alpha, int beta, int& score) {
+        if (depth > PROBCUT_MAX_DEPTH) return false;
+        const double t = sh.probcutT;
+        const int phase = probcutPhase(P, O);
+        bool cut = false;
+        inProbCut = true;
+        for (int k = 0; k < PROBCUT_CHECKS && !cut && !aborted; ++k) {
+            int ds = probcutShallow(depth, k);
+            if (ds < 0) break;
+            const ProbCutFit& f = sh.probcut.fit[phase][depth][k];
+            int hi = (int)std::ceil((beta + t * f.sigma - f.b) / f.a);    // v' >= hi なら v >= β と見る
+            int lo = (int)std::floor((alpha - t * f.sigma - f.b) / f.a);  // v' <= lo なら v <= α と見る
+            // 窓の片側が無限大（αβ の最初の手の系列）なら、そちら側は試さない
+            if (!isMateScore(beta) && !isMateScore(hi) && shallowValue(P, O, key, ds, hi - 1, hi) >= hi) { score = beta; cut = true; }
+            else if (!aborted && !isMateScore(alpha) && !isMateScore(lo) && shallowValue(P, O, key, ds, lo, lo + 1) <= lo) {
+                score = alpha;
+                cut = true;
+            }
+        }
+        inProbCut = false;
+        STATS(if (cut && !aborted) ++stats.depth[iterDepth].probcuts;)
+        return cut && !aborted;
+    }
+
+    int shallowValue(uint64_t P, uint64_t O, const HashPair& key, int depth, int alpha, int beta) {
+        return depth == 0 ? evaluatePatterns(*ps, P, O, sh.weights) : negamax(P, O, key, depth, alpha, beta);
+    }
+
+    int negamax(uint64_t P, uint64_t O, const HashPair& key, int depth, int alpha, int beta) {
+        ++nodes;
+        STATS(++stats.depth[iterDepth].nodes;)
+        if (checkAbort()) return 0;
+
+        uint64_t moves = STATS_TIMED(timed(), stats.phaseTicks[PHASE_MOVEGEN], movesBits(P, O));
+        if (!moves) {
+            if (!movesBits(O, P)) return finalScore(P, O);
+            ps[1].pass(ps[0]);
+            ++ps;
+            int s = -negamax(O, P, hashAfterPass(key), depth, -beta, -alpha); // パス（深さは消費しない）
+            --ps;
+            return s;
+        }
+        if (depth <= 0) return STATS_TIMED(timed(), stats.phaseTicks[PHASE_EVAL], evaluatePatterns(*ps, P, O, sh.weights));
+
+        // 置換表（残り2手以上のノードのみ）：十分な深さの結果があれば打ち切り、なければ最善手だけ借りる
+        int ttSq = -1;
+        TTEntry e;
+        STATS(if (depth >= 2) ++stats.depth[iterDepth].ttProbes;)
+        if (depth >= 2 && sh.tt.probe(key.h, e, id)) {
+            STATS(++stats.depth[iterDepth].ttHits;)
+            if (e.depth >= depth && (e.bound == BOUND_EXACT || (e.bound == BOUND_LOWER && e.score >= beta)
+                                     || (e.bound == BOUND_UPPER && e.score <= alpha))) {
+                STATS(++stats.depth[iterDepth].ttCuts;)
+                return e.score;
+            }
+            if (e.bestSq >= 0 && (moves & bitOf(e.bestSq))) ttSq = e.bestSq;
+        }
+
+        int cutScore;
+        if (sh.probcutT > 0 && depth >= PROBCUT_MIN_DEPTH && !inProbCut && probCut(P, O, key, depth, alpha, beta, cutScore))
+            return cutScore;
+        if (aborted) return 0;
+
+        int order[MAX_MOVES];
+        int n = depth >= 3 ? STATS_TIMED(timed(), stats.phaseTicks[PHASE_ORDER], orderMoves(P, O, moves, ttSq, order)) : 0;
+        if (!n) {
+            if (ttSq >= 0) order[n++] = ttSq;
+            for (uint64_t m = moves; m; m &= m - 1) if (lsb64(m) != ttSq) order[n++] = lsb64(m);
+        }
+
+        const int alpha0 = alpha;
+        int best = -SCORE_INF, bestSq = -1;
+        for (int i = 0; i < n; ++i) {
+            int sq = order[i];
+            uint64_t f = STATS_TIMED(timed(), stats.phaseTicks[PHASE_MOVEGEN], flipsBits(P, O, sq));
+            ps[1].play(ps[0], sq, f);
+            ++ps;
+            int s = -negamax(O ^ f, P | f | bitOf(sq), hashAfterMove(key, sq, f), depth - 1, -beta, -alpha);
+            --ps;
+            if (aborted) return 0;
+            if (s > best) {
+                best = s; bestSq = sq;
+                if (s > alpha) {
+                    alpha = s;
+                    if (alpha >= beta) {
+                        STATS(++stats.depth[iterDepth].cutoffs; if (i == 0) ++stats.depth[iterDepth].firstCutoffs;)
+                        break;
+                    }
+                }
+            }
+        }
+        Bound bound = best >= beta ? BOUND_LOWER : best > alpha0 ? BOUND_EXACT : BOUND_UPPER;
+        if (depth >= 2) sh.tt.store(key.h, best, depth, bound, bestSq, id);
+        return best;
+    }
+};
+
+class Searcher {
+public:
+    SearchLimits limits;
+    TranspositionTable tt;           // 同じ対局の中では手をまたいで使い回す（全スレッドで共有）
+    TranspositionTable endgameTT{8}; // 終盤読み切り用（石差を入れるので中盤とは分ける）
+    std::function<void(const SearchResult&)> onIteration; // 反復ごとの報告（任意・メインスレッドから呼ぶ）
+    const PatternWeights* weights = nullptr; // 評価の重み（nullptr なら共通の patternWeights()）
+    const ProbCutParams* probcut = nullptr;  // ProbCut の予測式（nullptr なら共通の probcutParams()）
+    bool recordLatency = true; // 思考時間を計測の分布に入れるか（先読みのように着手にならない探索では false）
+
+    // 新しい対局を始めるときに呼ぶ（置換表と計測を空にする）
+    void newGame() { tt.clear(); endgameTT.clear(); gameStats = SearchStats(); }
+    void setHashSize(size_t mb) { tt.resize(mb); }
+    void setThreads(int n) { limits.threads = n < 1 ? 1 : n > TT_MAX_THREADS ? TT_MAX_THREADS : n; }
+
+    // 手番側 P・相手側 O の局面で最善手を探す。
+    // 返すのは最後に完了した反復の結果（中断された反復は捨てる）。
+    // 空きが wldEmpties 以下なら、短い中盤探索で手順を決めてから終盤読み切りに切り替える。
+    // 合法手が1つの局面でも、その手を打った先を読んで評価値を返す（深さはその1手を含める）
+    SearchResult search(uint64_t P, uint64_t O) { return searchFrom(P, O, 0, onIteration); }
+
+    // 合法手 sq を打った先を読み、手番側 P から見た評価値で返す（打った1手を深さに含める。bestSq は sq）
+    SearchResult searchMove(uint64_t P, uint64_t O, int sq) { return searchForced(P, O, sq, 0, onIteration); }
+
+    // 別スレッドから探索を打ち切る。clearStop() までは次の search() もすぐに戻る
+    // （探索スレッドが search() に入る前の stop() も取りこぼさない）
+    void stop() { stopFlag = true; }
+    // 探索スレッドを立てる前に呼ぶ（呼ぶ側のスレッドで消すので、そのあとの stop() と競合しない）
+    void clearStop() { stopFlag = false; }
+
+    // この対局（newGame から）の計測。-DREVERSI_STATS なしでビルドしたときは置換表の統計以外 0
+    SearchStats stats() const {
+        SearchStats s = gameStats;
+        s.tt = tt.stats();
+        return s;
+    }
+
+private:
+    std::atomic<bool> stopFlag{false};
+    SearchStats gameStats;
+
+    // forced は打たされた手の数（その分だけ浅く読む）。report は反復ごとの報告
+    SearchResult searchFrom(uint64_t P, uint64_t O, int forced, const std::function<void(const SearchResult&)>& report) {
+        STATS(uint64_t t0 = statsTicks();)
+        SearchShared sh(limits, tt, endgameTT, stopFlag, weights ? *weights : patternWeights(),
+                        probcut ? *probcut : probcutParams());
+        sh.timeBudgetMs = limits.timeMs;
+        sh.nodeBudget = limits.maxNodes;
+        tt.newSearch();
+        endgameTT.newSearch();
+
+        SearchResult res;
+        uint64_t moves = movesBits(P, O);
+        if (!moves) return res;
+        res.bestSq = lsb64(moves);
+        if (popcount64(moves) == 1) return searchForced(P, O, res.bestSq, forced, report);
+
+        HashPair key = hashOf(P, O);
+        TTEntry e;
+        if (tt.probe(key.h, e) && e.bestSq >= 0 && (moves & bitOf(e.bestSq))) res.bestSq = e.bestSq;
+
+        int empties = N*N - popcount64(P | O);
+        bool solving = empties <= limits.wldEmpties || empties <= limits.exactEmpties;
+        int maxDepth = limits.maxDepth - forced > 1 ? limits.maxDepth - forced : 1;
+        if (maxDepth > empties) maxDepth = empties;
+        if (solving) { // 中盤探索は手順決めと時間切れのときの保険なので、浅く予算の 1/10 だけ
+            if (limits.timeMs > 0) sh.timeBudgetMs = limits.timeMs / 10 > 0 ? limits.timeMs / 10 : 1;
+            if (limits.maxNodes) sh.nodeBudget = limits.maxNodes / 10 > 0 ? limits.maxNodes / 10 : 1;
+            if (maxDepth > SOLVE_PREP_DEPTH) maxDepth = SOLVE_PREP_DEPTH;
+        }
+
+        int nThreads = limits.threads < 1 ? 1 : limits.threads > TT_MAX_THREADS ? TT_MAX_THREADS : limits.threads;
+        std::vector<std::unique_ptr<SearchThread>> workers;
+        for (int i = 0; i < nThreads; ++i) workers.emplace_back(new SearchThread(sh, i));
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < nThreads; ++i) {
+            helpers.emplace_back([&, i]() {
+                SearchResult hr = res;
+                workers[i]->run(P, O, key, maxDepth, solving, hr, nullptr);
+            });
+        }
+        workers[0]->run(P, O, key, maxDepth, solving, res, report);
+        sh.helpersStop = true;
+        for (std::thread& t : helpers) t.join();
+
+        res.nodes = 0;
+        for (auto& w : workers) res.nodes += w->nodes;
+        res.seconds = sh.elapsed();
+        res.threads = nThreads;
+#ifdef REVERSI_STATS
+        for (auto& w : workers) gameStats.threads += w->stats;
+        ++gameStats.searches;
+        gameStats.searchTicks += statsTicks() - t0;
+        gameStats.searchSeconds += res.seconds;
+        if (recordLatency) gameStats.latency.add(res.seconds * 1000);
+#endif
+        return res;
+    }
+
+    // sq を打った先（相手が打てなければパスした後）を読み、手番側から見た値に直す。
+    // 打つと終局なら石差で読み切り。深さ・読み切りの空きマス数は打った1手を含める
+    SearchResult searchForced(uint64_t P, uint64_t O, int sq, int forced,
+                              const std::function<void(const SearchResult&)>& report) {
+        uint64_t f = flipsBits(P, O, sq);
+        uint64_t cP = O ^ f, cO = P | f | bitOf(sq);
+        int sign = -1;
+        if (!movesBits(cP, cO)) {
+            if (!movesBits(cO, cP)) {
+                SearchResult res;
+                res.bestSq = sq;
+                res.score = finalScore(cO, cP);
+                res.depth = N*N - popcount64(P | O);
+                res.solved = SOLVE_EXACT;
+                return res;
+            }
+            std::swap(cP, cO);
+            sign = 1;
+        }
+        auto lift = [sq, sign](SearchResult r) {
+            r.bestSq = sq;
+            r.score *= sign;
+            if (r.depth > 0 || r.solved) ++r.depth; // 打ち切られて何も読めなかったときは 0 のまま
+            return r;
+        };
+        std::function<void(const SearchResult&)> childReport;
+        if (report) childReport = [&](const SearchResult& r) { report(lift(r)); };
+        return lift(searchFrom(cP, cO, forced + 1, childReport));
+    }
+};
@@ -0,0 +1,215 @@
+// stats.hpp - 探索の計測（反復の深さごとのノード数・置換表・カット、処理ごとの時間、1手の思考時間の分布）
+// -DREVERSI_STATS でビルドしたときだけ数える。そうでなければ STATS(...) は空になり、探索には何も残らない。
+// 型はいつでも使えるので、表示側のコードはビルドの設定によらずそのまま書ける（数はすべて 0 になる）。
+//
+// 時間は rdtsc などのカウンタで測り、探索全体の実時間との比で秒に直す。カウンタを読むだけでも
+// 1ノードの処理と同じくらいかかるので、処理ごとの時間は STATS_SAMPLE ノードに 1 回だけ測って倍にする。
+// Lazy SMP では全スレッドの合計なので、処理ごとの時間は実時間より長くなることがある（スレッド秒）。
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "tt.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// STATS(文) は計測するときだけ残る。STATS_TIMED(on, acc, 式) は on のときだけ式の時間を acc に足し、式の値を返す
+#ifdef REVERSI_STATS
+#define STATS(x) x
+#define STATS_TIMED(on, acc, expr) ((on) ? [&] { ScopedTicks statsTimer_(acc); return (expr); }() : (expr))
+static const bool STATS_ENABLED = true;
+#else
+#define STATS(x)
+#define STATS_TIMED(on, acc, expr) (expr)
+static const bool STATS_ENABLED = false;
+#endif
+
+static const int STATS_MAX_DEPTH = 64;
+static const int STATS_SAMPLE = 16; // 処理ごとの時間を測る間隔（ノード数、2 の冪）
+static const int LATENCY_BUCKETS = 16; // [0,1ms), [1,2), [2,4), ... , [2^14ms, ∞)
+
+enum StatsPhase { PHASE_MOVEGEN, PHASE_ORDER, PHASE_EVAL, PHASE_ENDGAME, PHASE_COUNT };
+static const char* const PHASE_NAMES[PHASE_COUNT] = {"movegen", "order", "eval", "endgame"};
+
+inline uint64_t statsTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// 区間の時間を acc に足す
+class ScopedTicks {
+public:
+    explicit ScopedTicks(uint64_t& a) : acc(a), start(statsTicks()) {}
+    ~ScopedTicks() { acc += statsTicks() - start; }
+private:
+    uint64_t& acc;
+    uint64_t start;
+};
+
+// 反復の深さ 1 回ぶん
+struct DepthStats {
+    uint64_t nodes = 0, ttProbes = 0, ttHits = 0, ttCuts = 0, cutoffs = 0, firstCutoffs = 0, probcuts = 0;
+    DepthStats& operator+=(const DepthStats& o) {
+        nodes += o.nodes; ttProbes += o.ttProbes; ttHits += o.ttHits; ttCuts += o.ttCuts;
+        cutoffs += o.cutoffs; firstCutoffs += o.firstCutoffs; probcuts += o.probcuts;
+        return *this;
+    }
+};
+
+// 探索スレッド 1 本ぶん（探索が終わったら Searcher の SearchStats に足す）
+struct ThreadStats {
+    DepthStats depth[STATS_MAX_DEPTH];
+    uint64_t phaseTicks[PHASE_COUNT] = {}; // 間引いて測った値（読むときに STATS_SAMPLE 倍する。読み切りは全部測る）
+    uint64_t endgameNodes = 0;
+    ThreadStats& operator+=(const ThreadStats& o) {
+        for (int d = 0; d < STATS_MAX_DEPTH; ++d) depth[d] += o.depth[d];
+        for (int p = 0; p < PHASE_COUNT; ++p) phaseTicks[p] += o.phaseTicks[p];
+        endgameNodes += o.endgameNodes;
+        return *this;
+    }
+};
+
+struct LatencyHistogram {
+    uint64_t bucket[LATENCY_BUCKETS] = {};
+    uint64_t count = 0;
+    double maxMs = 0, sumMs = 0;
+
+    static int bucketOf(double ms) {
+        int b = 0;
+        for (double limit = 1; b < LATENCY_BUCKETS - 1 && ms >= limit; limit *= 2) ++b;
+        return b;
+    }
+    void add(double ms) {
+        ++bucket[bucketOf(ms)];
+        ++count;
+        sumMs += ms;
+        if (ms > maxMs) maxMs = ms;
+    }
+    // バケットの上端で近似した分位点
+    double percentile(double p) const {
+        uint64_t need = (uint64_t)(p * count + 0.5), seen = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; ++b)
+            if ((seen += bucket[b]) >= need && need > 0) return b == LATENCY_BUCKETS - 1 ? maxMs : std::min(maxMs, (double)(1 << b));
+        return maxMs;
+    }
+};
+
+// 1局ぶん（Searcher::newGame で 0 に戻る）
+struct SearchStats {
+    ThreadStats threads;  // 全スレッド・全探索の合計
+    int searches = 0;
+    uint64_t searchTicks = 0; // 探索全体（メインスレッドの実時間）
+    double searchSeconds = 0;
+    LatencyHistogram latency;
+    TTStats tt;           // 読むときに Searcher が置換表の統計を入れる
+
+    double ticksToSeconds(uint64_t t) const { return searchTicks ? searchSeconds * t / searchTicks : 0; }
+    double phaseSeconds(int p) const {
+        return ticksToSeconds(threads.phaseTicks[p]) * (p == PHASE_ENDGAME ? 1 : STATS_SAMPLE);
+    }
+    uint64_t totalNodes() const {
+        uint64_t n = threads.endgameNodes;
+        for (const DepthStats& d : threads.depth) n += d.nodes;
+        return n;
+    }
+    // 反復 d の実効分岐係数 = d の反復のノード数 / d-1 の反復のノード数
+    double branching(int d) const {
+        return d > 1 && threads.depth[d-1].nodes ? (double)threads.depth[d].nodes / threads.depth[d-1].nodes : 0;
+    }
+
+    std::string summary() const {
+        std::string s;
+        char buf[256];
+        if (!STATS_ENABLED) return "stats: -DREVERSI_STATS でビルドしたときだけ計測します\n";
+        std::snprintf(buf, sizeof(buf), "stats: searches=%d nodes=%llu (endgame %llu) time=%.2fs nps=%.0f\n", searches,
+                      (unsigned long long)totalNodes(), (unsigned long long)threads.endgameNodes, searchSeconds,
+                      searchSeconds > 0 ? totalNodes() / searchSeconds : 0);
+        s += buf;
+        s += "  " + tt.summary() + "\n";
+        s += "  time:";
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            std::snprintf(buf, sizeof(buf), " %s=%.2fs", PHASE_NAMES[p], phaseSeconds(p));
+            s += buf;
+        }
+        s += "\n  depth      nodes    ebf  tt-hit  tt-cut   cutoffs  first-cut  probcuts\n";
+        for (int d = 1; d < STATS_MAX_DEPTH; ++d) {
+            const DepthStats& x = threads.depth[d];
+            if (!x.nodes) continue;
+            std::snprintf(buf, sizeof(buf), "  %5d %10llu %6.2f %6.1f%% %6.1f%% %9llu %9.1f%% %9llu\n", d,
+                          (unsigned long long)x.nodes, branching(d), x.ttProbes ? 100.0 * x.ttHits / x.ttProbes : 0.0,
+                          x.ttProbes ? 100.0 * x.ttCuts / x.ttProbes : 0.0, (unsigned long long)x.cutoffs,
+                          x.cutoffs ? 100.0 * x.firstCutoffs / x.cutoffs : 0.0, (unsigned long long)x.probcuts);
+            s += buf;
+        }
+        std::snprintf(buf, sizeof(buf), "  latency: p50<=%.0fms p90<=%.0fms p99<=%.0fms max=%.1fms avg=%.1fms\n",
+                      latency.percentile(0.5), latency.percentile(0.9), latency.percentile(0.99), latency.maxMs,
+                      latency.count ? latency.sumMs / latency.count : 0.0);
+        s += buf;
+        return s;
+    }
+
+    std::string json() const {
+        std::string s;
+        char buf[256];
+        std::snprintf(buf, sizeof(buf), "{\"enabled\":%s,\"searches\":%d,\"nodes\":%llu,\"endgame_nodes\":%llu,\"seconds\":%.6f,",
+                      STATS_ENABLED ? "true" : "false", searches, (unsigned long long)totalNodes(),
+                      (unsigned long long)threads.endgameNodes, searchSeconds);
+        s += buf;
+        std::snprintf(buf, sizeof(buf), "\"tt\":{\"probes\":%llu,\"hits\":%llu,\"misses\":%llu,\"collisions\":%llu,\"stores\":%llu},",
+                      (unsigned long long)tt.probes, (unsigned long long)tt.hits, (unsigned long long)tt.misses,
+                      (unsigned long long)tt.collisions, (unsigned long long)tt.stores);
+        s += buf;
+        s += "\"phase_seconds\":{";
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            std::snprintf(buf, sizeof(buf), "%s\"%s\":%.6f", p ? "," : "", PHASE_NAMES[p], phaseSeconds(p));
+            s += buf;
+        }
+        s += "},\"depths\":[";
+        bool first = true;
+        for (int d = 1; d < STATS_MAX_DEPTH; ++d) {
+            const DepthStats& x = threads.depth[d];
+            if (!x.nodes) continue;
+            std::snprintf(buf, sizeof(buf), "%s{\"depth\":%d,\"nodes\":%llu,\"ebf\":%.4f,\"tt_probes\":%llu,\"tt_hits\":%llu,"
+                          "\"tt_cuts\":%llu,\"cutoffs\":%llu,\"first_cutoffs\":%llu,\"probcuts\":%llu}", first ? "" : ",", d,
+                          (unsigned long long)x.nodes, branching(d), (unsigned long long)x.ttProbes,
+                          (unsigned long long)x.ttHits, (unsigned long long)x.ttCuts, (unsigned long long)x.cutoffs,
+                          (unsigned long long)x.firstCutoffs, (unsigned long long)x.probcuts);
+            s += buf;
+            first = false;
+        }
+        s += "],\"latency_ms\":{\"buckets\":[";
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            std::snprintf(buf, sizeof(buf), "%s%llu", b ? "," : "", (unsigned long long)latency.bucket[b]);
+            s += buf;
+        }
+        std::snprintf(buf, sizeof(buf), "],\"bucket_upper\":\"2^i ms\",\"p50\":%.0f,\"p90\":%.0f,\"p99\":%.0f,\"max\":%.3f,\"count\":%llu}}",
+                      latency.percentile(0.5), latency.percentile(0.9), latency.percentile(0.99), latency.maxMs,
+                      (unsigned long long)latency.count);
+        s += buf;
+        return s;
+    }
+};
+
+// 1局ごとの JSON の書き出し先。2局目からは拡張子の前に "-2", "-3", ... を付ける
+inline std::string statsPath(const std::string& path, int game) {
+    if (game <= 1) return path;
+    size_t dot = path.find_last_of('.'), slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+    return path.substr(0, dot) + "-" + std::to_string(game) + path.substr(dot);
+}
+
+inline bool writeStatsJson(const std::string& path, const SearchStats& st) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::string s = st.json();
+    bool ok = std::fwrite(s.data(), 1, s.size(), f) == s.size() && std::fputc('\n', f) != EOF;
+    return std::fclose(f) == 0 && ok;
+}
@@ -0,0 +1,182 @@
+// tt.hpp - Zobrist ハッシュと置換表（Transposition Table）
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "bitboard.hpp"
+
+// --- Zobrist ハッシュ ---
+// 手番側から見た (P,O) に対するハッシュ H(P,O) = ΣA[P] ^ ΣB[O]。
+// 着手・パスで手番側が入れ替わるので、入れ替えた側の H(O,P) も一緒に持ち歩くと
+// どちらも差分だけで更新できる（パスは2つを入れ替えるだけ）。
+struct Zobrist {
+    uint64_t A[N*N], B[N*N], D[N*N]; // D = A ^ B（反転した石の差分）
+
+    Zobrist() {
+        uint64_t s = 0x9E3779B97F4A7C15ULL;
+        auto next = [&s]() { // splitmix64
+            uint64_t z = (s += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+        for (int sq = 0; sq < N*N; ++sq) { A[sq] = next(); B[sq] = next(); D[sq] = A[sq] ^ B[sq]; }
+    }
+};
+
+inline const Zobrist& zobrist() {
+    static const Zobrist z;
+    return z;
+}
+
+struct HashPair {
+    uint64_t h = 0;  // H(P,O)
+    uint64_t hs = 0; // H(O,P)
+};
+
+inline HashPair hashOf(uint64_t P, uint64_t O) {
+    const Zobrist& z = zobrist();
+    HashPair k;
+    for (uint64_t m = P; m; m &= m - 1) { int sq = lsb64(m); k.h ^= z.A[sq]; k.hs ^= z.B[sq]; }
+    for (uint64_t m = O; m; m &= m - 1) { int sq = lsb64(m); k.h ^= z.B[sq]; k.hs ^= z.A[sq]; }
+    return k;
+}
+
+// sq に打って f を反転した後の局面（手番は相手に移る）のハッシュ
+inline HashPair hashAfterMove(const HashPair& k, int sq, uint64_t f) {
+    const Zobrist& z = zobrist();
+    uint64_t d = 0;
+    for (; f; f &= f - 1) d ^= z.D[lsb64(f)];
+    return {k.hs ^ d ^ z.B[sq], k.h ^ d ^ z.A[sq]};
+}
+
+inline HashPair hashAfterPass(const HashPair& k) { return {k.hs, k.h}; }
+
+// --- 置換表 ---
+// 複数の探索スレッドで共有する。各スロットは (key ^ data, data) の2語で、
+// 読み出し時に key を復元して一致を確かめるのでロックなしで読み書きできる
+// （書き込みが混ざった壊れたスロットは不一致として捨てられる）。
+enum Bound : uint8_t { BOUND_NONE = 0, BOUND_UPPER = 1, BOUND_LOWER = 2, BOUND_EXACT = 3 };
+
+static const int TT_MAX_THREADS = 256;
+
+struct TTEntry {
+    uint64_t key = 0;
+    int32_t score = 0;
+    int8_t depth = -1;
+    uint8_t bound = BOUND_NONE;
+    int8_t bestSq = -1;
+    uint8_t gen = 0;    // 探索世代（古い深さ優先エントリを置き換えるため）
+
+    uint64_t pack() const {
+        return (uint64_t)(uint32_t)score | (uint64_t)(uint8_t)depth << 32 | (uint64_t)bound << 40
+             | (uint64_t)(uint8_t)bestSq << 48 | (uint64_t)gen << 56;
+    }
+    static TTEntry unpack(uint64_t key, uint64_t d) {
+        TTEntry e;
+        e.key = key;
+        e.score = (int32_t)(uint32_t)d;
+        e.depth = (int8_t)(d >> 32);
+        e.bound = (uint8_t)(d >> 40);
+        e.bestSq = (int8_t)(d >> 48);
+        e.gen = (uint8_t)(d >> 56);
+        return e;
+    }
+};
+
+struct TTStats {
+    uint64_t probes = 0, hits = 0, misses = 0, collisions = 0, stores = 0;
+    double hitRate() const { return probes ? (double)hits / probes : 0; }
+    TTStats& operator+=(const TTStats& o) {
+        probes += o.probes; hits += o.hits; misses += o.misses; collisions += o.collisions; stores += o.stores;
+        return *this;
+    }
+    std::string summary() const {
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "tt hits=%llu misses=%llu collisions=%llu (hit %.1f%%)",
+                      (unsigned long long)hits, (unsigned long long)misses,
+                      (unsigned long long)collisions, hitRate() * 100);
+        return buf;
+    }
+};
+
+// 1バケット = 深さ優先スロット + 常時置換スロット
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t mb = 16) { resize(mb); }
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    void resize(size_t mb) {
+        size_t n = 1;
+        while (n * 2 * sizeof(Bucket) <= mb * 1024 * 1024) n *= 2;
+        table.reset(new Bucket[n]);
+        count = n;
+        mask = n - 1;
+        clear();
+    }
+    void clear() {
+        for (size_t i = 0; i < count; ++i)
+            for (Slot& s : table[i].slot) { s.k.store(0, std::memory_order_relaxed); s.d.store(0, std::memory_order_relaxed); }
+        gen = 0;
+        resetStats();
+    }
+    void newSearch() { ++gen; }
+    size_t sizeBytes() const { return count * sizeof(Bucket); }
+
+    // 統計はスレッドごとに数えて（共有カウンタの奪い合いを避ける）、読むときに合計する
+    TTStats stats() const {
+        TTStats t;
+        for (const PaddedStats& s : st) t += s.s;
+        return t;
+    }
+    void resetStats() { for (PaddedStats& s : st) s.s = TTStats(); }
+
+    bool probe(uint64_t key, TTEntry& out, int tid = 0) {
+        TTStats& s = st[tid].s;
+        ++s.probes;
+        Bucket& b = table[key & mask];
+        bool occupied = false;
+        for (Slot& sl : b.slot) {
+            uint64_t d = sl.d.load(std::memory_order_relaxed), k = sl.k.load(std::memory_order_relaxed) ^ d;
+            if ((uint8_t)(d >> 40) == BOUND_NONE) continue;
+            if (k == key) { ++s.hits; out = TTEntry::unpack(key, d); return true; }
+            occupied = true;
+        }
+        ++s.misses;
+        if (occupied) ++s.collisions;
+        return false;
+    }
+
+    void store(uint64_t key, int score, int depth, Bound bound, int bestSq, int tid = 0) {
+        ++st[tid].s.stores;
+        Bucket& b = table[key & mask];
+        TTEntry e;
+        e.key = key; e.score = score; e.depth = (int8_t)depth;
+        e.bound = bound; e.bestSq = (int8_t)bestSq; e.gen = gen;
+
+        Slot& deep = b.slot[0];
+        uint64_t dd = deep.d.load(std::memory_order_relaxed);
+        TTEntry old = TTEntry::unpack(deep.k.load(std::memory_order_relaxed) ^ dd, dd);
+        Slot* dst = &b.slot[1];
+        if (old.bound == BOUND_NONE || old.key == key || old.gen != gen || depth >= old.depth) {
+            if (old.key == key && bestSq < 0) e.bestSq = old.bestSq; // 最善手は残す
+            dst = &deep;
+        }
+        uint64_t d = e.pack();
+        dst->k.store(key ^ d, std::memory_order_relaxed);
+        dst->d.store(d, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot { std::atomic<uint64_t> k{0}, d{0}; };
+    struct Bucket { Slot slot[2]; };
+    struct alignas(64) PaddedStats { TTStats s; };
+    std::unique_ptr<Bucket[]> table;
+    size_t count = 0, mask = 0;
+    uint8_t gen = 0;
+    PaddedStats st[TT_MAX_THREADS];
+};
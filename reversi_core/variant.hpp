@@ -0,0 +1,365 @@
+// variant.hpp - 盤の大きさを変えたオセロ（6×6・8×8・10×10）の盤・合法手生成・評価・探索
+// 一辺 S をテンプレート引数にして、石の集合は S*S <= 64 なら uint64_t、10×10 は unsigned __int128 で持つ。
+// マス番号は sq = r*S + c（a1 = bit0）。端のマスク・位置の重み・手の並べ替えの順は S ごとにコンパイル時に作り、
+// シフト量と Kogge-Stone の段数も S で決まるので、どの大きさも bitboard.hpp と同じ形の命令列になる。
+//
+// 8×8 の本番の探索（search.hpp: パターン評価・定石・並列探索・終盤読み切り）はそのまま残し、
+// ここでは位置の重みと着手可能数で評価する反復深化 αβ を持つ（評価は S = 8 なら eval.hpp の evaluate と同じ値）。
+// 盤の大きさは runWithBoardSize で実行時に選ぶ。
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "bitboard.hpp"
+#include "eval.hpp"
+
+inline int popcountBits(uint64_t x) { return popcount64(x); }
+inline int popcountBits(unsigned __int128 x) { return popcount64((uint64_t)x) + popcount64((uint64_t)(x >> 64)); }
+inline int lsbBits(uint64_t x) { return lsb64(x); }
+inline int lsbBits(unsigned __int128 x) {
+    uint64_t lo = (uint64_t)x;
+    return lo ? lsb64(lo) : 64 + lsb64((uint64_t)(x >> 64));
+}
+
+// W（eval.hpp）を一般の大きさに広げた位置の重み。近い辺からの距離 (a <= b) で決まり、S = 8 なら W と一致する
+constexpr int variantWeight(int S, int r, int c) {
+    int dr = r < S - 1 - r ? r : S - 1 - r, dc = c < S - 1 - c ? c : S - 1 - c;
+    int a = dr < dc ? dr : dc, b = dr < dc ? dc : dr;
+    if (a == 0) return b == 0 ? 120 : b == 1 ? -20 : b == 2 ? 20 : 5;
+    if (a == 1) return b == 1 ? -40 : -5;
+    if (a == 2) return b == 2 ? 15 : 3;
+    return 3;
+}
+
+// 一辺 S の盤の定数（すべてコンパイル時に決まる）
+template <int S>
+struct Geometry {
+    static_assert(S >= 4 && S % 2 == 0 && S * S <= 128, "board side must be even and fit in 128 bits");
+    typedef typename std::conditional<(S * S <= 64), uint64_t, unsigned __int128>::type Bits;
+    static constexpr int SQUARES = S * S;
+
+    static constexpr Bits bit(int sq) { return (Bits)1 << sq; }
+    static constexpr Bits column(int c) { Bits m = 0; for (int r = 0; r < S; ++r) m |= bit(r * S + c); return m; }
+    static constexpr Bits row(int r) { Bits m = 0; for (int c = 0; c < S; ++c) m |= bit(r * S + c); return m; }
+
+    static constexpr Bits FULL = SQUARES == 8 * (int)sizeof(Bits) ? ~(Bits)0 : bit(SQUARES % (8 * (int)sizeof(Bits))) - 1;
+    static constexpr Bits MASK_H = FULL & ~column(0) & ~column(S - 1); // 横: 両端の列を除く
+    static constexpr Bits MASK_V = FULL & ~row(0) & ~row(S - 1);       // 縦: 両端の行を除く
+    static constexpr Bits MASK_D = MASK_H & MASK_V;                    // 斜め: 外周を除く
+    // Kogge-Stone の倍々の段数（1+2+4+... が相手石の最長の並び S-2 に届くまで）
+    static constexpr int FILL_STEPS = S - 2 <= 3 ? 2 : S - 2 <= 7 ? 3 : S - 2 <= 15 ? 4 : 5;
+
+    static constexpr std::array<int, SQUARES> makeWeights() {
+        std::array<int, SQUARES> w{};
+        for (int sq = 0; sq < SQUARES; ++sq) w[sq] = variantWeight(S, sq / S, sq % S);
+        return w;
+    }
+    static constexpr std::array<int, SQUARES> WEIGHTS = makeWeights();
+
+    // 同じ重みのマス集合（位置評価を popcount で求める。eval.hpp の WeightMasks と同じ）
+    struct WeightClasses {
+        int count = 0;
+        int weight[8] = {};
+        Bits mask[8] = {};
+    };
+    static constexpr WeightClasses makeClasses() {
+        WeightClasses wc{};
+        for (int sq = 0; sq < SQUARES; ++sq) {
+            int k = 0;
+            while (k < wc.count && wc.weight[k] != WEIGHTS[sq]) ++k;
+            if (k == wc.count) { wc.weight[k] = WEIGHTS[sq]; ++wc.count; }
+            wc.mask[k] |= bit(sq);
+        }
+        return wc;
+    }
+    static constexpr WeightClasses CLASSES = makeClasses();
+
+    // 手の並べ替えの既定の順（重みの大きいマスから。同じ重みはマス番号順）
+    static constexpr std::array<int, SQUARES> makeOrder() {
+        std::array<int, SQUARES> o{};
+        int n = 0;
+        for (int w = 200; w >= -200; --w)
+            for (int sq = 0; sq < SQUARES; ++sq)
+                if (WEIGHTS[sq] == w) o[n++] = sq;
+        return o;
+    }
+    static constexpr std::array<int, SQUARES> ORDER = makeOrder();
+};
+
+template <int S> using BitsOf = typename Geometry<S>::Bits;
+
+template <int D, class Bits>
+inline Bits shiftDir(Bits b) {
+    if constexpr (D > 0) return b << D; else return b >> -D;
+}
+
+// Kogge-Stone の occluded fill（STEPS 段。シフト量は段ごとに倍になる）
+template <int D, int STEPS, class Bits>
+inline Bits fillDir(Bits gen, Bits pro) {
+    gen |= pro & shiftDir<D>(gen);
+    if constexpr (STEPS > 1) return fillDir<2 * D, STEPS - 1>(gen, pro & shiftDir<D>(pro));
+    else return gen;
+}
+
+template <int S, int D>
+inline BitsOf<S> movesDirOf(BitsOf<S> P, BitsOf<S> mO) {
+    return shiftDir<D>(fillDir<D, Geometry<S>::FILL_STEPS>(P, mO) & ~P);
+}
+
+// 手番側 P・相手側 O のときの全合法手
+template <int S>
+inline BitsOf<S> movesOf(BitsOf<S> P, BitsOf<S> O) {
+    typedef Geometry<S> G;
+    const BitsOf<S> h = O & G::MASK_H, v = O & G::MASK_V, d = O & G::MASK_D;
+    BitsOf<S> m = movesDirOf<S, 1>(P, h) | movesDirOf<S, -1>(P, h)
+                | movesDirOf<S, S>(P, v) | movesDirOf<S, -S>(P, v)
+                | movesDirOf<S, S + 1>(P, d) | movesDirOf<S, -(S + 1)>(P, d)
+                | movesDirOf<S, S - 1>(P, d) | movesDirOf<S, -(S - 1)>(P, d);
+    return m & ~(P | O) & G::FULL;
+}
+
+template <int S, int D>
+inline BitsOf<S> flipsDirOf(BitsOf<S> P, BitsOf<S> mO, BitsOf<S> m) {
+    BitsOf<S> f = mO & shiftDir<D>(m);
+    for (int i = 0; i < S - 3; ++i) f |= mO & shiftDir<D>(f); // 回数は定数なので展開される
+    return (shiftDir<D>(f) & P) ? f : 0;
+}
+
+// sq に置いたときに反転する石。0 なら非合法
+template <int S>
+inline BitsOf<S> flipsOf(BitsOf<S> P, BitsOf<S> O, int sq) {
+    typedef Geometry<S> G;
+    const BitsOf<S> m = G::bit(sq);
+    const BitsOf<S> h = O & G::MASK_H, v = O & G::MASK_V, d = O & G::MASK_D;
+    return flipsDirOf<S, 1>(P, h, m) | flipsDirOf<S, -1>(P, h, m)
+         | flipsDirOf<S, S>(P, v, m) | flipsDirOf<S, -S>(P, v, m)
+         | flipsDirOf<S, S + 1>(P, d, m) | flipsDirOf<S, -(S + 1)>(P, d, m)
+         | flipsDirOf<S, S - 1>(P, d, m) | flipsDirOf<S, -(S - 1)>(P, d, m);
+}
+
+// 手番側 P から見た評価値（位置の重み＋着手可能数。S = 8 なら evaluate と同じ）
+template <int S>
+inline int evaluateOf(BitsOf<S> P, BitsOf<S> O) {
+    typedef Geometry<S> G;
+    int s = 0;
+    for (int k = 0; k < G::CLASSES.count; ++k)
+        s += G::CLASSES.weight[k] * (popcountBits(P & G::CLASSES.mask[k]) - popcountBits(O & G::CLASSES.mask[k]));
+    return s + (popcountBits(movesOf<S>(P, O)) - popcountBits(movesOf<S>(O, P))) * MOBILITY_WEIGHT;
+}
+
+// 終局時の石差（空きマスは勝った側に加える）
+template <int S>
+inline int finalDiffOf(BitsOf<S> P, BitsOf<S> O) {
+    int p = popcountBits(P), o = popcountBits(O), e = S * S - p - o, diff = p - o;
+    return diff > 0 ? diff + e : diff < 0 ? diff - e : 0;
+}
+
+template <int S>
+struct VariantBoard {
+    BitsOf<S> black = 0, white = 0;
+
+    char at(int r, int c) const {
+        BitsOf<S> m = Geometry<S>::bit(r * S + c);
+        return (black & m) ? BLACK : (white & m) ? WHITE : EMPTY;
+    }
+    BitsOf<S> own(char p) const { return p == BLACK ? black : white; }
+    BitsOf<S> opp(char p) const { return p == BLACK ? white : black; }
+    // 合法手であることが前提
+    void play(char p, int sq) {
+        BitsOf<S> f = flipsOf<S>(own(p), opp(p), sq);
+        if (p == BLACK) { black |= f | Geometry<S>::bit(sq); white &= ~f; }
+        else            { white |= f | Geometry<S>::bit(sq); black &= ~f; }
+    }
+};
+
+// 中央の 4 マス（左上と右下が白。S = 8 なら initialBoard と同じ）
+template <int S>
+inline VariantBoard<S> initialBoardOf() {
+    typedef Geometry<S> G;
+    const int h = S / 2;
+    VariantBoard<S> b;
+    b.white = G::bit((h - 1) * S + h - 1) | G::bit(h * S + h);
+    b.black = G::bit((h - 1) * S + h) | G::bit(h * S + h - 1);
+    return b;
+}
+
+// "a1"〜"j10"（列 a から、行 1 から）
+inline std::string variantSquareName(int S, int sq) {
+    if (sq < 0) return "pass";
+    return std::string(1, char('a' + sq % S)) + std::to_string(sq / S + 1);
+}
+
+// 読めなければ -1
+inline int parseVariantSquare(int S, const std::string& s) {
+    if (s.size() < 2 || s.size() > 3) return -1;
+    int c = std::tolower((unsigned char)s[0]) - 'a', r = 0;
+    for (size_t i = 1; i < s.size(); ++i) {
+        if (!std::isdigit((unsigned char)s[i])) return -1;
+        r = r * 10 + (s[i] - '0');
+    }
+    --r;
+    return r >= 0 && r < S && c >= 0 && c < S ? r * S + c : -1;
+}
+
+static const int VARIANT_WIN = 100000; // 終局スコア = ±VARIANT_WIN + 石差（search.hpp の SCORE_WIN と同じ考え方）
+static const int VARIANT_INF = 1000000;
+
+struct VariantLimits {
+    int maxDepth = 60;
+    int timeMs = 1000;     // 0 なら無制限
+    int exactEmpties = 14; // 空きがこれ以下なら最終石差まで読み切る
+};
+
+struct VariantResult {
+    int bestSq = -1;
+    int score = 0;
+    int depth = 0;
+    bool solved = false;
+    uint64_t nodes = 0;
+    double seconds = 0;
+
+    std::string summary() const {
+        char buf[160];
+        bool mate = score >= VARIANT_WIN - 128 || score <= -VARIANT_WIN + 128;
+        if (mate && score) std::snprintf(buf, sizeof(buf), "depth=%d score=%s%+d%s nodes=%llu time=%.3fs", depth,
+                                         score > 0 ? "win" : "loss", score > 0 ? score - VARIANT_WIN : score + VARIANT_WIN,
+                                         solved ? " solved=exact" : "", (unsigned long long)nodes, seconds);
+        else std::snprintf(buf, sizeof(buf), "depth=%d score=%+d%s nodes=%llu time=%.3fs", depth, score,
+                           solved ? " solved=exact" : "", (unsigned long long)nodes, seconds);
+        return buf;
+    }
+};
+
+// 一辺 S の盤の反復深化 αβ（1 スレッド、置換表は局面そのものを鍵にする）
+template <int S>
+class VariantSearcher {
+public:
+    typedef BitsOf<S> Bits;
+    VariantLimits limits;
+
+    explicit VariantSearcher(size_t ttEntries = 1 << 18) : tt(ttEntries) {}
+
+    // 手番側 P が打つ手を選ぶ（打てなければ bestSq = -1）
+    VariantResult search(Bits P, Bits O) {
+        VariantResult res;
+        start = Clock::now();
+        nodes = 0;
+        aborted = false;
+        Bits legal = movesOf<S>(P, O);
+        if (!legal) return res;
+        res.bestSq = lsbBits(legal);
+        int empties = S * S - popcountBits(P | O);
+        bool solve = empties <= limits.exactEmpties;
+        int maxDepth = solve ? empties : std::min(limits.maxDepth, empties);
+        for (int depth = solve ? empties : 1; depth <= maxDepth; ++depth) {
+            int best = -1, score = rootSearch(P, O, legal, depth, solve, res.bestSq, best);
+            if (aborted) break;
+            res.bestSq = best;
+            res.score = score;
+            res.depth = depth;
+            res.solved = solve;
+            if (limits.timeMs > 0 && elapsedMs() * 3 > limits.timeMs) break; // 次の反復は間に合わない
+        }
+        res.nodes = nodes;
+        res.seconds = elapsedMs() / 1000.0;
+        return res;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct Entry {
+        Bits P = 0, O = 0;
+        int score = 0;
+        int8_t depth = -1, flag = 0, best = -1;
+    };
+    enum { EXACT, LOWER, UPPER };
+
+    std::vector<Entry> tt;
+    Clock::time_point start;
+    uint64_t nodes = 0;
+    bool aborted = false;
+
+    double elapsedMs() const { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+    Entry& slot(Bits P, Bits O) {
+        uint64_t h = (uint64_t)P * 0x9e3779b97f4a7c15ULL ^ (uint64_t)O * 0xc2b2ae3d27d4eb4fULL;
+        if constexpr (sizeof(Bits) > 8) h ^= (uint64_t)(P >> 64) * 0x165667b19e3779f9ULL ^ (uint64_t)(O >> 64) * 0x27d4eb2f165667c5ULL;
+        h ^= h >> 29;
+        return tt[h % tt.size()];
+    }
+
+    // 合法手を TT の手・重みの順に並べる
+    int orderMoves(Bits legal, int ttBest, int* out) const {
+        int n = 0;
+        if (ttBest >= 0 && (legal & Geometry<S>::bit(ttBest))) out[n++] = ttBest;
+        for (int sq : Geometry<S>::ORDER)
+            if ((legal & Geometry<S>::bit(sq)) && sq != ttBest) out[n++] = sq;
+        return n;
+    }
+
+    int rootSearch(Bits P, Bits O, Bits legal, int depth, bool solve, int prevBest, int& best) {
+        int moves[S * S], n = orderMoves(legal, prevBest, moves);
+        int alpha = -VARIANT_INF;
+        for (int i = 0; i < n; ++i) {
+            Bits f = flipsOf<S>(P, O, moves[i]);
+            int v = -negamax(O ^ f, P | f | Geometry<S>::bit(moves[i]), depth - 1, -VARIANT_INF, -alpha, solve, false);
+            if (aborted) return alpha;
+            if (v > alpha) { alpha = v; best = moves[i]; }
+        }
+        return alpha;
+    }
+
+    int negamax(Bits P, Bits O, int depth, int alpha, int beta, bool solve, bool passed) {
+        if ((++nodes & 1023) == 0 && limits.timeMs > 0 && elapsedMs() >= limits.timeMs) aborted = true;
+        if (aborted) return 0;
+        Bits legal = movesOf<S>(P, O);
+        if (!legal) {
+            if (passed) {
+                int d = finalDiffOf<S>(P, O);
+                return d > 0 ? VARIANT_WIN + d : d < 0 ? -VARIANT_WIN + d : 0;
+            }
+            return -negamax(O, P, depth, -beta, -alpha, solve, true);
+        }
+        if (depth <= 0 && !solve) return evaluateOf<S>(P, O);
+
+        Entry& e = slot(P, O);
+        int ttBest = -1;
+        if (e.P == P && e.O == O) {
+            ttBest = e.best;
+            if (e.depth >= depth && (e.flag == EXACT || (e.flag == LOWER && e.score >= beta) || (e.flag == UPPER && e.score <= alpha)))
+                return e.score;
+        }
+        int moves[S * S], n = orderMoves(legal, ttBest, moves);
+        int best = -VARIANT_INF, bestSq = moves[0], a0 = alpha;
+        for (int i = 0; i < n; ++i) {
+            Bits f = flipsOf<S>(P, O, moves[i]);
+            int v = -negamax(O ^ f, P | f | Geometry<S>::bit(moves[i]), depth - 1, -beta, -alpha, solve, false);
+            if (aborted) return 0;
+            if (v > best) { best = v; bestSq = moves[i]; }
+            if (v > alpha) alpha = v;
+            if (alpha >= beta) break;
+        }
+        e.P = P; e.O = O; e.score = best; e.depth = (int8_t)std::max(depth, 0); e.best = (int8_t)bestSq;
+        e.flag = best <= a0 ? UPPER : best >= beta ? LOWER : EXACT;
+        return best;
+    }
+};
+
+// 盤の大きさ size に合わせて f(std::integral_constant<int, S>()) を呼ぶ。対応しない大きさなら false
+static const int VARIANT_SIZES[] = {6, 8, 10};
+
+template <class F>
+inline bool runWithBoardSize(int size, F&& f) {
+    switch (size) {
+    case 6:  f(std::integral_constant<int, 6>());  return true;
+    case 8:  f(std::integral_constant<int, 8>());  return true;
+    case 10: f(std::integral_constant<int, 10>()); return true;
+    default: return false;
+    }
+}
@@ -0,0 +1,124 @@
+// reversi_evalbench.cpp - まとめて評価する API（batch_eval.hpp）の検証とベンチマーク
+// ランダムな対局から局面を集め、命令セットごとに合法手の数・位置評価・パターン評価を計算して、
+// 1 局面ずつの関数（movesBits / evaluate / evaluatePatterns）と全局面で一致するかを確かめてから、
+// 局面/秒を出す。scalar は 1 局面ずつの関数をそのまま呼んだときの速さ。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_evalbench.cpp -o reversi_evalbench
+// 例:     ./reversi_evalbench --positions 2000000 --reps 5
+//
+// オプション:
+//   --positions <n>   局面数（既定 1000000）
+//   --reps <n>        計測の回数（一番速い回を出す。既定 5）
+//   --seed <n>        局面を作る乱数の種（既定 1）
+//   --weights <file>  パターン評価の重み（既定 reversi.weights。なければ既定値）
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "../reversi_core/batch_eval.hpp"
+using namespace std;
+
+// 初期局面からランダムに打って、手番側が打てる局面を n 個集める
+void randomPositions(size_t n, uint64_t seed, vector<uint64_t>& P, vector<uint64_t>& O) {
+    mt19937_64 rng(seed);
+    while (P.size() < n) {
+        uint64_t p = initialBoard().black, o = initialBoard().white;
+        for (;;) {
+            uint64_t m = movesBits(p, o);
+            if (!m) {
+                if (!movesBits(o, p)) break;
+                swap(p, o);
+                continue;
+            }
+            P.push_back(p);
+            O.push_back(o);
+            if (P.size() == n) break;
+            for (int k = (int)(rng() % popcount64(m)); k > 0; --k) m &= m - 1;
+            int sq = lsb64(m);
+            uint64_t f = flipsBits(p, o, sq);
+            uint64_t np = o ^ f, no = p | f | bitOf(sq);
+            p = np; o = no;
+        }
+    }
+}
+
+enum BenchKind { BENCH_MOBILITY, BENCH_EVAL, BENCH_PATTERNS, BENCH_COUNT };
+static const char* const BENCH_NAMES[BENCH_COUNT] = {"mobility", "evaluate", "patterns"};
+
+void runBatch(BenchKind kind, const uint64_t* P, const uint64_t* O, size_t n, int* out, EvalIsa isa) {
+    if (kind == BENCH_MOBILITY)  mobilityBatch(P, O, n, out, isa);
+    else if (kind == BENCH_EVAL) evaluateBatch(P, O, n, out, isa);
+    else                         evaluatePatternsBatch(P, O, n, out, patternWeights(), isa);
+}
+
+int reference(BenchKind kind, uint64_t P, uint64_t O) {
+    if (kind == BENCH_MOBILITY) return popcount64(movesBits(P, O));
+    if (kind == BENCH_EVAL) return evaluate(P, O);
+    return evaluatePatterns(P, O);
+}
+
+int main(int argc, char** argv) {
+    size_t positions = 1000000;
+    int reps = 5;
+    uint64_t seed = 1;
+    string weightsFile = "reversi.weights";
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--positions")    positions = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        else if (a == "--reps")    reps = max(1, atoi(argv[++i]));
+        else if (a == "--seed")    seed = strtoull(argv[++i], nullptr, 10);
+        else if (a == "--weights") weightsFile = argv[++i];
+    }
+    bool loaded = patternWeights().load(weightsFile);
+    printf("weights: %s\n", loaded ? weightsFile.c_str() : "(defaults)");
+
+    vector<uint64_t> P, O;
+    randomPositions(positions, seed, P, O);
+    vector<int> expect[BENCH_COUNT], out(positions);
+    for (int k = 0; k < BENCH_COUNT; ++k) {
+        expect[k].resize(positions);
+        for (size_t i = 0; i < positions; ++i) expect[k][i] = reference((BenchKind)k, P[i], O[i]);
+    }
+
+    // 一致の確認（レーン数で割り切れない端数も通るように、短い長さでも試す）
+    int failures = 0;
+    printf("verify %zu positions against the single-position functions\n", positions);
+    for (int isa = 0; isa < ISA_COUNT; ++isa) {
+        if (!isaSupported((EvalIsa)isa)) { printf("  %-7s not supported on this CPU\n", ISA_NAMES[isa]); continue; }
+        for (int k = 0; k < BENCH_COUNT; ++k) {
+            size_t bad = 0;
+            runBatch((BenchKind)k, P.data(), O.data(), positions, out.data(), (EvalIsa)isa);
+            for (size_t i = 0; i < positions; ++i) bad += out[i] != expect[k][i];
+            for (size_t len = 1; len <= min<size_t>(9, positions); ++len) {
+                runBatch((BenchKind)k, P.data() + 1, O.data() + 1, min(len, positions - 1), out.data(), (EvalIsa)isa);
+                for (size_t i = 0; i < min(len, positions - 1); ++i) bad += out[i] != expect[k][i + 1];
+            }
+            failures += bad != 0;
+            printf("  %-7s %-9s %s\n", ISA_NAMES[isa], BENCH_NAMES[k], bad ? "MISMATCH" : "ok");
+        }
+    }
+
+    printf("\npositions/s (best of %d)\n  %-7s", reps, "isa");
+    for (int k = 0; k < BENCH_COUNT; ++k) printf(" %14s", BENCH_NAMES[k]);
+    printf("\n");
+    for (int isa = 0; isa < ISA_COUNT; ++isa) {
+        if (!isaSupported((EvalIsa)isa)) continue;
+        printf("  %-7s", ISA_NAMES[isa]);
+        for (int k = 0; k < BENCH_COUNT; ++k) {
+            double best = 1e30;
+            for (int r = 0; r < reps; ++r) {
+                auto t0 = chrono::steady_clock::now();
+                runBatch((BenchKind)k, P.data(), O.data(), positions, out.data(), (EvalIsa)isa);
+                best = min(best, chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+            }
+            printf(" %14.0f", best > 0 ? positions / best : 0);
+        }
+        printf("\n");
+    }
+
+    printf("\n%s\n", failures ? "FAILED" : "all ok");
+    return failures ? 1 : 0;
+}
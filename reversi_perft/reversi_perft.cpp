@@ -0,0 +1,285 @@
+// reversi_perft.cpp - 合法手生成の検証とベンチマーク（perft）
+// 指定の深さまでの末端局面数を数え、既知の正しい値と照合して leaves/s を出す。
+// パスは1手として数え、両者とも打てなくなった局面はその深さで末端とする
+// （main の lastPass と同じ扱い）。着手生成を速くするときの回帰チェックに使う。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_perft.cpp -o reversi_perft
+// 例:     ./reversi_perft --depth 11 --threads 8
+//         ./reversi_perft --size 10 --depth 9
+//
+// オプション:
+//   --depth <d>    初期局面から数える深さ（既定 9）
+//   --threads <n>  並列版で使うスレッド数（既定はコア数）
+//   --verify <d>   初期局面を legalMoves/applyMove と、1マスずつ8方向を調べる素朴な実装でも数えて
+//                  一致を確かめる深さ（既定 6。検証用局面は常に既定の深さまで3通りで数える）
+//                  variant.hpp の 8×8 版（Geometry<8>）でも数えて一致を確かめる
+//   --size <n>     6 / 10 なら一辺 n の盤（variant.hpp）を素朴な実装と照合し、深さごとの速度を出す
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/variant.hpp"
+using namespace std;
+
+// 初期局面からの既知の値
+static const uint64_t START_PERFT[] = {
+    1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284, 212258800,
+    1939886636ULL, 18429641748ULL, 184042084512ULL,
+};
+static const int START_PERFT_MAX = sizeof(START_PERFT) / sizeof(START_PERFT[0]) - 1;
+
+// 検証用局面（値は3つの実装で一致を確かめたもの）
+struct TestPosition {
+    const char* moves;
+    int depth;
+    uint64_t leaves;
+};
+static const TestPosition TEST_POSITIONS[] = {
+    {"f5d6c3d3c4f4f6f3e6e7", 5, 188748}, // 中盤（パスなし）
+    {"f5f4e3f2c3f6g5e6f3c5d3e2d6c6e1d2c4g3f1c2f7h6h3f8d1c1b1g2e7h2h5h4g6d8g1g7h1b2h7", 7, 1650013}, // 途中でパス
+    {"f5f4c3c6f3c4d3c2b3f6d6b2e6e3a1a3a2c5a4g4b4b6d2g5a6c1e1g3h6d1b1a5g6h5b5h7h3e2f2f7h4h2e7f1g1d8f8d7",
+     13, 872916},                      // パスと終局が多い終盤
+    {"f5f4c3c6f3c4d3c2b3f6d6b2e6e3a1a3a2c5a4g4b4b6d2g5a6c1e1g3h6d1b1a5g6h5b5h7h3e2f2f7h4h2e7f1g1d8f8d7e8c8",
+     13, 18025},                       // 全変化が終局まで届く
+};
+
+// --- ビットボード版（本番のコードパス） ---
+uint64_t perft(uint64_t P, uint64_t O, int depth, bool passed = false) {
+    if (depth == 0) return 1;
+    uint64_t moves = movesBits(P, O);
+    if (!moves) {
+        if (passed) return 1;                       // 両者とも打てない：終局
+        return perft(O, P, depth - 1, true);        // パスも1手
+    }
+    if (depth == 1) return popcount64(moves);       // 末端の1手前は数えるだけ
+    uint64_t n = 0;
+    for (; moves; moves &= moves - 1) {
+        int sq = lsb64(moves);
+        uint64_t f = flipsBits(P, O, sq);
+        n += perft(O ^ f, P | f | bitOf(sq), depth - 1);
+    }
+    return n;
+}
+
+// --- legalMoves / applyMove 版（表示・入力用 API の検証） ---
+uint64_t perftBoard(const Board& b, char turn, int depth, bool passed = false) {
+    if (depth == 0) return 1;
+    vector<Move> moves = legalMoves(b, turn);
+    if (moves.empty()) {
+        if (passed) return 1;
+        return perftBoard(b, opponent(turn), depth - 1, true);
+    }
+    uint64_t n = 0;
+    for (const Move& m : moves) {
+        Board nb = b;
+        applyMove(nb, turn, m.r, m.c);
+        n += perftBoard(nb, opponent(turn), depth - 1);
+    }
+    return n;
+}
+
+// --- 素朴な実装（1マスずつ8方向をたどる。ビット演算を使わない基準。一辺 S の盤で使う） ---
+template <int S> struct Grid { char cell[S][S]; };
+
+Grid<N> toGrid(const Board& b) {
+    Grid<N> g;
+    for (int r = 0; r < N; ++r)
+        for (int c = 0; c < N; ++c) g.cell[r][c] = b.at(r, c);
+    return g;
+}
+
+template <int S>
+bool flipsNaive(Grid<S>& g, char p, int r, int c, bool apply) {
+    if (g.cell[r][c] != EMPTY) return false;
+    static const int DR[8] = {-1,-1,-1, 0, 0, 1, 1, 1}, DC[8] = {-1, 0, 1,-1, 1,-1, 0, 1};
+    auto inside = [](int rr, int cc) { return rr >= 0 && rr < S && cc >= 0 && cc < S; };
+    bool any = false;
+    for (int d = 0; d < 8; ++d) {
+        int rr = r + DR[d], cc = c + DC[d], k = 0;
+        while (inside(rr, cc) && g.cell[rr][cc] == opponent(p)) { rr += DR[d]; cc += DC[d]; ++k; }
+        if (k == 0 || !inside(rr, cc) || g.cell[rr][cc] != p) continue;
+        any = true;
+        if (apply)
+            for (int i = 1; i <= k; ++i) g.cell[r + DR[d]*i][c + DC[d]*i] = p;
+    }
+    if (any && apply) g.cell[r][c] = p;
+    return any;
+}
+
+template <int S>
+uint64_t perftNaive(const Grid<S>& g, char p, int depth, bool passed = false) {
+    if (depth == 0) return 1;
+    uint64_t n = 0;
+    bool any = false;
+    for (int r = 0; r < S; ++r)
+        for (int c = 0; c < S; ++c) {
+            Grid<S> ng = g;
+            if (!flipsNaive(ng, p, r, c, true)) continue;
+            any = true;
+            n += perftNaive(ng, opponent(p), depth - 1);
+        }
+    if (any) return n;
+    if (passed) return 1;
+    return perftNaive(g, opponent(p), depth - 1, true);
+}
+
+// --- 盤の大きさを変えた版（variant.hpp の S ごとの合法手生成） ---
+template <int S>
+uint64_t perftVariant(BitsOf<S> P, BitsOf<S> O, int depth, bool passed = false) {
+    if (depth == 0) return 1;
+    BitsOf<S> moves = movesOf<S>(P, O);
+    if (!moves) {
+        if (passed) return 1;
+        return perftVariant<S>(O, P, depth - 1, true);
+    }
+    if (depth == 1) return popcountBits(moves);
+    uint64_t n = 0;
+    for (; moves; moves &= moves - 1) {
+        int sq = lsbBits(moves);
+        BitsOf<S> f = flipsOf<S>(P, O, sq);
+        n += perftVariant<S>(O ^ f, P | f | Geometry<S>::bit(sq), depth - 1);
+    }
+    return n;
+}
+
+// --- 並列版：浅い深さの局面を仕事として分け、スレッドで取り合う ---
+struct Task { uint64_t P, O; bool passed; };
+
+void collectTasks(uint64_t P, uint64_t O, int depth, bool passed, vector<Task>& out, uint64_t& leaves) {
+    if (depth == 0) { out.push_back({P, O, passed}); return; }
+    uint64_t moves = movesBits(P, O);
+    if (!moves) {
+        if (passed) { ++leaves; return; } // 分割の途中で終局したものはその場で数える
+        collectTasks(O, P, depth - 1, true, out, leaves);
+        return;
+    }
+    for (; moves; moves &= moves - 1) {
+        int sq = lsb64(moves);
+        uint64_t f = flipsBits(P, O, sq);
+        collectTasks(O ^ f, P | f | bitOf(sq), depth - 1, false, out, leaves);
+    }
+}
+
+uint64_t perftParallel(uint64_t P, uint64_t O, int depth, int threads) {
+    int split = min(depth - 1, 4);
+    if (threads <= 1 || split <= 0) return perft(P, O, depth);
+    vector<Task> tasks;
+    uint64_t leaves = 0;
+    collectTasks(P, O, split, false, tasks, leaves);
+
+    atomic<size_t> next{0};
+    atomic<uint64_t> total{leaves};
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&]() {
+            uint64_t n = 0;
+            for (size_t i; (i = next.fetch_add(1)) < tasks.size();)
+                n += perft(tasks[i].P, tasks[i].O, depth - split, tasks[i].passed);
+            total += n;
+        });
+    }
+    for (thread& t : pool) t.join();
+    return total;
+}
+
+double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+// 一辺 S の盤：初期局面から素朴な実装と一致するかを確かめ、深さごとの速度を出す（1スレッド）
+template <int S>
+int variantPerft(int maxDepth, int verifyDepth) {
+    int failures = 0;
+    VariantBoard<S> start = initialBoardOf<S>();
+    Grid<S> g;
+    for (int r = 0; r < S; ++r)
+        for (int c = 0; c < S; ++c) g.cell[r][c] = start.at(r, c);
+    printf("%dx%d board (%s bits)\n", S, S, sizeof(BitsOf<S>) > 8 ? "128" : "64");
+    printf("verify (variant / naive) to depth %d\n", verifyDepth);
+    for (int d = 1; d <= verifyDepth; ++d) {
+        uint64_t a = perftVariant<S>(start.black, start.white, d), b = perftNaive(g, BLACK, d);
+        failures += a != b;
+        printf("  start depth %2d: %llu %s\n", d, (unsigned long long)a, a == b ? "ok" : "MISMATCH");
+    }
+    printf("\nperft from start\n  depth %14s %10s %14s\n", "leaves", "sec", "leaves/s");
+    for (int d = 1; d <= maxDepth; ++d) {
+        auto t0 = chrono::steady_clock::now();
+        uint64_t n = perftVariant<S>(start.black, start.white, d);
+        double sec = secondsSince(t0);
+        bool known = S == N && d <= START_PERFT_MAX;
+        bool ok = !known || n == START_PERFT[d];
+        failures += !ok;
+        printf("  %5d %14llu %10.3f %14.0f %s\n", d, (unsigned long long)n, sec, sec > 0 ? n / sec : 0,
+               !ok ? "MISMATCH" : known ? "ok" : "");
+    }
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    int maxDepth = 9, threads = (int)max(1u, thread::hardware_concurrency()), verifyDepth = 6, size = N;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--depth")        maxDepth = atoi(argv[++i]);
+        else if (a == "--threads") threads = max(1, atoi(argv[++i]));
+        else if (a == "--verify")  verifyDepth = atoi(argv[++i]);
+        else if (a == "--size")    size = atoi(argv[++i]);
+    }
+    if (size != N) {
+        int failures = 0;
+        if (!runWithBoardSize(size, [&](auto s) { failures = variantPerft<decltype(s)::value>(maxDepth, verifyDepth); })) {
+            fprintf(stderr, "unsupported board size %d (6, 8 or 10)\n", size);
+            return 2;
+        }
+        printf("\n%s\n", failures ? "FAILED" : "all ok");
+        return failures ? 1 : 0;
+    }
+
+    int failures = 0;
+    Board start = initialBoard();
+
+    // 3つの実装が一致するか（初期局面と検証用局面）
+    printf("verify (bitboard / legalMoves+applyMove / naive / variant<8>) to depth %d\n", verifyDepth);
+    for (int d = 1; d <= verifyDepth; ++d) {
+        uint64_t a = perft(start.black, start.white, d);
+        uint64_t b = perftBoard(start, BLACK, d), c = perftNaive(toGrid(start), BLACK, d);
+        bool ok = a == b && a == c && a == perftVariant<N>(start.black, start.white, d);
+        failures += !ok;
+        printf("  start depth %2d: %llu %s\n", d, (unsigned long long)a, ok ? "ok" : "MISMATCH");
+    }
+    for (const TestPosition& tp : TEST_POSITIONS) {
+        Board b; char turn;
+        playTranscript(tp.moves, b, turn);
+        uint64_t a = perft(b.own(turn), b.opp(turn), tp.depth);
+        uint64_t x = perftBoard(b, turn, tp.depth), y = perftNaive(toGrid(b), turn, tp.depth);
+        bool ok = a == tp.leaves && a == x && a == y && a == perftVariant<N>(b.own(turn), b.opp(turn), tp.depth);
+        failures += !ok;
+        printf("  %s depth %d: %llu (expected %llu) %s\n", tp.moves, tp.depth, (unsigned long long)a,
+               (unsigned long long)tp.leaves, ok ? "ok" : "MISMATCH");
+    }
+
+    // 初期局面：既知の値との照合と速度（1スレッド / 並列）
+    printf("\nperft from start (threads=%d)\n", threads);
+    printf("  depth %14s %10s %14s %10s %14s\n", "leaves", "1T sec", "1T leaves/s", "NT sec", "NT leaves/s");
+    for (int d = 1; d <= maxDepth; ++d) {
+        auto t0 = chrono::steady_clock::now();
+        uint64_t n1 = perft(start.black, start.white, d);
+        double s1 = secondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        uint64_t nt = perftParallel(start.black, start.white, d, threads);
+        double st = secondsSince(t0);
+
+        bool known = d <= START_PERFT_MAX;
+        bool ok = n1 == nt && (!known || n1 == START_PERFT[d]);
+        failures += !ok;
+        printf("  %5d %14llu %10.3f %14.0f %10.3f %14.0f %s\n", d, (unsigned long long)n1, s1,
+               s1 > 0 ? n1 / s1 : 0, st, st > 0 ? nt / st : 0, !ok ? "MISMATCH" : known ? "ok" : "(unknown)");
+    }
+
+    printf("\n%s\n", failures ? "FAILED" : "all ok");
+    return failures ? 1 : 0;
+}
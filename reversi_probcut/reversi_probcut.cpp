@@ -0,0 +1,199 @@
+// reversi_probcut.cpp - ProbCut の予測式（reversi.probcut）を自己探索から当てはめるツール
+// 棋譜（なければ 1 手読みに乱数を混ぜた自己対局）から局面を集め、各局面を全幅（選択度 0）で深さ 1〜--depth まで
+// 反復深化して深さごとの評価値を記録する。深さ d とその確認に使う浅い深さ ds（probcut.hpp の probcutShallow）の組ごとに
+// v(d) = a * v(ds) + b を石数の段階別に最小二乗法で当てはめ、残差の標準偏差を σ として書き出す。
+// 探索は起動時に reversi.probcut を読み、当てはめのない組（深さ > --depth など）は組み込みの値を使う。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_probcut.cpp -o reversi_probcut
+// 例:     ./reversi_probcut --positions 3000 --depth 10 --threads 8 --out reversi.probcut
+//         ./reversi_probcut --games games.txt --positions 20000 --depth 12
+//
+// オプション:
+//   --games <file>      局面を取る棋譜（1行1局 "棋譜 [黒石差]"。複数指定可。省略時は自己対局で作る）
+//   --positions <n>     使う局面数（既定 2000）
+//   --depth <d>         当てはめる最大の深さ（既定 9。PROBCUT_MAX_DEPTH まで）
+//   --min-empties <n>   空きがこれ未満の局面は使わない（既定 14。読み切りに入る局面は ProbCut を使わない）
+//   --threads <n>       並列に読む局面数（既定はコア数）
+//   --weights <file>    評価の重み（既定 reversi.weights。探索で使う重みと同じものにする）
+//   --out <file>        書き出すファイル（既定 reversi.probcut）
+//   --seed <n>          局面の選び方・自己対局の乱数の種（既定 1）
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../reversi_core/search.hpp"
+using namespace std;
+
+struct Position { uint64_t P, O; };
+
+bool usable(uint64_t P, uint64_t O, int minEmpties) {
+    return N*N - popcount64(P | O) >= minEmpties && popcount64(movesBits(P, O)) >= 2;
+}
+
+// 棋譜の全局面（手番側から見た形）
+void positionsFromGames(const string& path, int minEmpties, vector<Position>& out) {
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        string moves = line.substr(0, line.find(' '));
+        Board b = initialBoard();
+        char turn = BLACK;
+        for (size_t i = 0; i + 1 < moves.size(); i += 2) {
+            uint64_t P = b.own(turn), O = b.opp(turn);
+            if (!movesBits(P, O)) { turn = opponent(turn); P = b.own(turn); O = b.opp(turn); }
+            if (usable(P, O, minEmpties)) out.push_back({P, O});
+            int c = tolower(moves[i]) - 'a', r = moves[i + 1] - '1';
+            if (!inBounds(r, c) || !(movesBits(P, O) & bitOf(sqOf(r, c)))) break;
+            applyMove(b, turn, r, c);
+            turn = opponent(turn);
+        }
+    }
+}
+
+// 1 手読み（パターン評価）に 1/4 の確率でランダムな手を混ぜた自己対局で局面を作る
+void positionsFromSelfPlay(size_t n, int minEmpties, mt19937_64& rng, vector<Position>& out) {
+    while (out.size() < n) {
+        uint64_t P = initialBoard().black, O = initialBoard().white;
+        for (;;) {
+            uint64_t m = movesBits(P, O);
+            if (!m) {
+                if (!movesBits(O, P)) break;
+                swap(P, O);
+                continue;
+            }
+            if (usable(P, O, minEmpties)) out.push_back({P, O});
+            int sq = -1;
+            if (rng() % 4 == 0) {
+                for (int k = (int)(rng() % popcount64(m)); k > 0; --k) m &= m - 1;
+                sq = lsb64(m);
+            } else {
+                int best = -SCORE_INF;
+                for (; m; m &= m - 1) {
+                    int s = lsb64(m);
+                    uint64_t f = flipsBits(P, O, s);
+                    int v = -evaluatePatterns(O ^ f, P | f | bitOf(s));
+                    if (v > best) { best = v; sq = s; }
+                }
+            }
+            uint64_t f = flipsBits(P, O, sq);
+            uint64_t np = O ^ f, no = P | f | bitOf(sq);
+            P = np; O = no;
+        }
+    }
+}
+
+// 1 局面の深さごとの評価値（score[0] は静的評価。読めなかった深さ・勝敗が決まった値は valid が false）
+struct Sample {
+    int phase;
+    int score[PROBCUT_MAX_DEPTH + 1];
+    bool valid[PROBCUT_MAX_DEPTH + 1];
+};
+
+// v = a * x + b の当てはめ
+struct LineFit {
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+    void add(double x, double y) { n += 1; sx += x; sy += y; sxx += x * x; sxy += x * y; syy += y * y; }
+    bool solve(double& a, double& b, double& sigma) const {
+        double vx = sxx - sx * sx / n;
+        if (n < 2 || vx <= 0) return false;
+        a = (sxy - sx * sy / n) / vx;
+        b = (sy - a * sx) / n;
+        double sse = syy - 2 * a * sxy - 2 * b * sy + a * a * sxx + 2 * a * b * sx + n * b * b;
+        sigma = sqrt(max(0.0, sse / max(1.0, n - 2)));
+        return true;
+    }
+};
+
+int main(int argc, char** argv) {
+    vector<string> gameFiles;
+    size_t positions = 2000;
+    int maxDepth = 9, minEmpties = 14, threads = (int)max(1u, thread::hardware_concurrency());
+    string weightsFile = "reversi.weights", outFile = "reversi.probcut";
+    uint64_t seed = 1;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--games")            gameFiles.push_back(argv[++i]);
+        else if (a == "--positions")   positions = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        else if (a == "--depth")       maxDepth = min(PROBCUT_MAX_DEPTH, max(PROBCUT_MIN_DEPTH, atoi(argv[++i])));
+        else if (a == "--min-empties") minEmpties = max(1, atoi(argv[++i]));
+        else if (a == "--threads")     threads = max(1, atoi(argv[++i]));
+        else if (a == "--weights")     weightsFile = argv[++i];
+        else if (a == "--out")         outFile = argv[++i];
+        else if (a == "--seed")        seed = strtoull(argv[++i], nullptr, 10);
+    }
+    if (patternWeights().load(weightsFile)) printf("weights: %s\n", weightsFile.c_str());
+
+    mt19937_64 rng(seed);
+    vector<Position> pool;
+    for (const string& f : gameFiles) positionsFromGames(f, minEmpties, pool);
+    if (gameFiles.empty()) positionsFromSelfPlay(positions * 8, minEmpties, rng, pool);
+    if (pool.empty()) { cerr << "局面がありません\n"; return 1; }
+    shuffle(pool.begin(), pool.end(), rng);
+    if (pool.size() > positions) pool.resize(positions);
+    printf("probcut: %zu positions, depth 1..%d, %d threads\n", pool.size(), maxDepth, threads);
+
+    vector<Sample> samples(pool.size());
+    atomic<size_t> next{0}, done{0};
+    auto start = chrono::steady_clock::now();
+    auto worker = [&]() {
+        Searcher s;
+        s.limits.timeMs = 0;
+        s.limits.maxDepth = maxDepth;
+        s.limits.exactEmpties = s.limits.wldEmpties = 0;
+        s.limits.selectivity = 0;
+        s.recordLatency = false;
+        s.setHashSize(16);
+        for (size_t i; (i = next.fetch_add(1)) < pool.size();) {
+            Sample& smp = samples[i];
+            const Position& p = pool[i];
+            smp.phase = probcutPhase(p.P, p.O);
+            fill(begin(smp.valid), end(smp.valid), false);
+            smp.score[0] = evaluatePatterns(p.P, p.O);
+            smp.valid[0] = true;
+            s.onIteration = [&](const SearchResult& r) {
+                if (r.depth <= PROBCUT_MAX_DEPTH && !isMateScore(r.score)) { smp.score[r.depth] = r.score; smp.valid[r.depth] = true; }
+            };
+            s.newGame(); // 前の局面の置換表が値を混ぜないように
+            s.search(p.P, p.O);
+            size_t d = ++done;
+            if (d % 200 == 0) fprintf(stderr, "  %zu/%zu\n", d, pool.size());
+        }
+    };
+    vector<thread> ts;
+    for (int t = 0; t < threads; ++t) ts.emplace_back(worker);
+    for (thread& t : ts) t.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // 当てはめ（30 局面未満の組は組み込みの値のまま）
+    ProbCutParams params;
+    printf("\nphase depth shallow      a        b    sigma  samples\n");
+    int fitted = 0;
+    for (int ph = 0; ph < PROBCUT_PHASES; ++ph)
+        for (int d = PROBCUT_MIN_DEPTH; d <= maxDepth; ++d)
+            for (int k = 0; k < PROBCUT_CHECKS; ++k) {
+                int ds = probcutShallow(d, k);
+                if (ds < 0) continue;
+                LineFit lf;
+                for (const Sample& smp : samples)
+                    if (smp.phase == ph && smp.valid[d] && smp.valid[ds]) lf.add(smp.score[ds], smp.score[d]);
+                double a, b, sigma;
+                if (lf.n < 30 || !lf.solve(a, b, sigma) || a <= 0) continue;
+                params.fit[ph][d][k] = {(float)a, (float)b, (float)sigma, (int)lf.n};
+                printf("%5d %5d %7d %6.3f %8.1f %8.1f %8d\n", ph, d, ds, a, b, sigma, (int)lf.n);
+                ++fitted;
+            }
+    if (!params.save(outFile)) { cerr << outFile << " に書けません\n"; return 1; }
+    printf("\n%d fits written to %s (%.1fs)\n", fitted, outFile.c_str(), elapsed);
+    return 0;
+}
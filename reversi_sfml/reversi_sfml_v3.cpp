@@ -1,108 +1,42 @@
 // reversi_sfml_v3.cpp - SFML v3 対応版のオセロ雛形
 // macOS: brew install sfml
-// ビルド: clang++ -std=c++17 -O2 reversi_sfml_v3.cpp -o reversi_sfml \
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_sfml_v3.cpp -o reversi_sfml \
 //   $(pkg-config --cflags --libs sfml-all)
 
 #include <SFML/Graphics.hpp>
+#include <memory>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <iostream>
-
-static const int N = 8;
-static const char EMPTY = '.';
-static const char BLACK = 'X'; // 先手（あなた）
-static const char WHITE = 'O'; // 後手（AIにしたければ後述のフラグを有効化）
-
-struct Move { int r, c; };
-
-bool inBounds(int r, int c) { return r >= 0 && r < N && c >= 0 && c < N; }
-char opponent(char p) { return p == BLACK ? WHITE : BLACK; }
-
-// 反転対象の一覧を返す
-std::vector<Move> findFlips(const std::vector<std::vector<char>>& b, char p, int r, int c) {
-    std::vector<Move> flips;
-    if (!inBounds(r,c) || b[r][c] != EMPTY) return flips;
-
-    static const int dr[8] = {-1,-1,-1, 0, 0, 1, 1, 1};
-    static const int dc[8] = {-1, 0, 1,-1, 1,-1, 0, 1};
-    char opp = opponent(p);
-
-    for (int d = 0; d < 8; ++d) {
-        int nr = r + dr[d], nc = c + dc[d];
-        std::vector<Move> line;
-        if (!inBounds(nr,nc) || b[nr][nc] != opp) continue;
-        while (inBounds(nr,nc) && b[nr][nc] == opp) {
-            line.push_back({nr,nc});
-            nr += dr[d]; nc += dc[d];
-        }
-        if (inBounds(nr,nc) && b[nr][nc] == p && !line.empty()) {
-            flips.insert(flips.end(), line.begin(), line.end());
-        }
-    }
-    return flips;
-}
-
-bool isLegal(const std::vector<std::vector<char>>& b, char p, int r, int c) {
-    return !findFlips(b, p, r, c).empty();
-}
-
-std::vector<Move> legalMoves(const std::vector<std::vector<char>>& b, char p) {
-    std::vector<Move> moves;
-    for (int r = 0; r < N; ++r)
-        for (int c = 0; c < N; ++c)
-            if (isLegal(b, p, r, c)) moves.push_back({r,c});
-    return moves;
-}
-
-void applyMove(std::vector<std::vector<char>>& b, char p, int r, int c) {
-    auto flips = findFlips(b, p, r, c);
-    b[r][c] = p;
-    for (auto &m : flips) b[m.r][m.c] = p;
-}
-
-std::pair<int,int> countDiscs(const std::vector<std::vector<char>>& b) {
-    int x=0, o=0;
-    for (int r=0; r<N; ++r) for (int c=0; c<N; ++c) {
-        x += (b[r][c] == BLACK);
-        o += (b[r][c] == WHITE);
-    }
-    return {x,o};
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/analysis.hpp"
+#include "../reversi_core/async_ai.hpp"
+#include "../reversi_core/book.hpp"
+#include "../reversi_core/game_state.hpp"
+#include "../reversi_core/search.hpp"
+
+// --- AI（反復深化 αβ 探索）---
+// 探索はバックグラウンドで走らせ、描画ループは止めない。人間の手番中は予想手の先を先読みする
+AsyncSearch ai;
+OpeningBook book; // 定石（--book、既定 reversi.book。なければ使わない）
+
+// --- 検討モード（A キー）---
+// 全ての合法手を裏のスレッドで読み続け（analysis.hpp）、マスごとに評価値と深さを出す。AI は打たず、両者ともクリックで進める
+MultiPvAnalysis analysis;
+
+std::string turnTitle(char turn) {
+    return std::string("Reversi (SFML) - Turn: ") + (turn==BLACK ? "Black" : "White");
 }
 
-// --- 簡易AI（角優先＋反転枚数＋位置重み）--- 必要ならONにして使えます
-static const int W[N][N] = {
-    { 120,-20, 20,  5,  5, 20,-20,120},
-    { -20,-40, -5, -5, -5, -5,-40,-20},
-    {  20,  -5, 15,  3,  3, 15,  -5, 20},
-    {   5,  -5,  3,  3,  3,  3,  -5,  5},
-    {   5,  -5,  3,  3,  3,  3,  -5,  5},
-    {  20,  -5, 15,  3,  3, 15,  -5, 20},
-    { -20,-40, -5, -5, -5, -5,-40,-20},
-    { 120,-20, 20,  5,  5, 20,-20,120}
-};
-
-Move chooseMoveAI(const std::vector<std::vector<char>>& b, char ai) {
-    auto moves = legalMoves(b, ai);
-    if (moves.empty()) return {-1,-1};
-    for (auto m : moves) {
-        if ((m.r==0 && m.c==0) || (m.r==0 && m.c==7) || (m.r==7 && m.c==0) || (m.r==7 && m.c==7))
-            return m;
-    }
-    int bestScore = -1000000;
-    Move best = moves.front();
-    char opp = opponent(ai);
-    for (auto m : moves) {
-        auto flips = findFlips(b, ai, m.r, m.c);
-        int flipCount = (int)flips.size();
-        int posScore  = W[m.r][m.c];
-        std::vector<std::vector<char>> tmp = b;
-        applyMove(tmp, ai, m.r, m.c);
-        int oppMobility = (int)legalMoves(tmp, opp).size();
-        int score = flipCount*10 + posScore - oppMobility*2;
-        if (score > bestScore) { bestScore = score; best = m; }
-    }
-    return best;
+// 思考中の表示（タイトルに深さと評価値）
+std::string thinkingTitle(const SearchResult& p) {
+    std::string t = "Reversi (SFML) - White thinking...";
+    if (p.depth > 0) t += " depth " + std::to_string(p.depth) + " score " + scoreText(p.score);
+    return t;
 }
 
 // --- 描画関連 ---
@@ -124,15 +58,192 @@ struct UI {
     }
 };
 
-int main() {
-    // 盤の初期化
-    std::vector<std::vector<char>> b(N, std::vector<char>(N, EMPTY));
-    b[3][3] = WHITE; b[4][4] = WHITE;
-    b[3][4] = BLACK; b[4][3] = BLACK;
+// --- 盤のジオメトリ ---
+// 盤面と格子は起動時に一度だけ VertexBuffer に載せ、石・合法手・終局オーバーレイは
+// 局面が変わったときだけ VertexArray に作り直す。1フレームの draw は 2〜3 回で済む。
+void appendQuad(sf::VertexArray& va, sf::Vector2f tl, sf::Vector2f size, sf::Color col) {
+    sf::Vector2f tr{tl.x + size.x, tl.y}, bl{tl.x, tl.y + size.y}, br{tl.x + size.x, tl.y + size.y};
+    for (sf::Vector2f p : {tl, tr, br, tl, br, bl}) va.append(sf::Vertex{p, col});
+}
 
-    char turn = BLACK;
-    bool lastPass = false;
-    bool gameOver = false;
+void appendCircle(sf::VertexArray& va, sf::Vector2f center, float radius, sf::Color col, int segments = 32) {
+    const float step = 6.2831853f / segments;
+    for (int i = 0; i < segments; ++i) {
+        sf::Vector2f a{center.x + radius * std::cos(step * i), center.y + radius * std::sin(step * i)};
+        sf::Vector2f b{center.x + radius * std::cos(step * (i + 1)), center.y + radius * std::sin(step * (i + 1))};
+        va.append(sf::Vertex{center, col});
+        va.append(sf::Vertex{a, col});
+        va.append(sf::Vertex{b, col});
+    }
+}
+
+struct BoardMesh {
+    sf::VertexArray staticArr{sf::PrimitiveType::Triangles};  // 盤面と格子
+    sf::VertexBuffer staticBuf{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Static};
+    bool useBuffer = false;                                   // VertexBuffer が使えない環境では配列のまま描く
+    sf::VertexArray dynamic{sf::PrimitiveType::Triangles};    // 石・合法手・オーバーレイ
+
+    void buildStatic(const UI& ui) {
+        const float size = (float)(ui.CELL*N);
+        staticArr.clear();
+        appendQuad(staticArr, {(float)ui.MARGIN, (float)ui.MARGIN}, {size, size}, sf::Color(0, 120, 0));
+        for (int i = 0; i <= N; ++i) {
+            float off = (float)(ui.MARGIN + i*ui.CELL);
+            appendQuad(staticArr, {(float)ui.MARGIN, off}, {size, 2.f}, sf::Color(0, 80, 0));
+            appendQuad(staticArr, {off, (float)ui.MARGIN}, {2.f, size}, sf::Color(0, 80, 0));
+        }
+        useBuffer = sf::VertexBuffer::isAvailable() && staticBuf.create(staticArr.getVertexCount())
+                 && staticBuf.update(&staticArr[0], staticArr.getVertexCount(), 0);
+    }
+
+    void rebuild(const UI& ui, const Board& b, uint64_t hints, bool gameOver) { // hints = 0 なら合法手の点を出さない
+        dynamic.clear();
+        for (uint64_t m = b.black | b.white; m; m &= m - 1) {
+            int sq = lsb64(m);
+            sf::Vector2f tl = ui.cellTopLeft(sq / N, sq % N);
+            appendCircle(dynamic, {tl.x + ui.CELL/2.f, tl.y + ui.CELL/2.f}, ui.CELL*0.45f,
+                         (b.black & bitOf(sq)) ? sf::Color::Black : sf::Color::White);
+        }
+        for (uint64_t m = hints; m; m &= m - 1) { // 合法手ハイライト（半透明の小さな点）
+            int sq = lsb64(m);
+            sf::Vector2f tl = ui.cellTopLeft(sq / N, sq % N);
+            appendCircle(dynamic, {tl.x + ui.CELL/2.f, tl.y + ui.CELL/2.f}, ui.CELL*0.15f, sf::Color(255, 255, 0, 140), 16);
+        }
+        if (gameOver) appendQuad(dynamic, {0.f, 0.f}, {(float)ui.W, (float)ui.H}, sf::Color(0, 0, 0, 90));
+    }
+
+    // 発行した draw の回数を返す
+    int draw(sf::RenderWindow& win) const {
+        if (useBuffer) win.draw(staticBuf); else win.draw(staticArr);
+        win.draw(dynamic);
+        return 2;
+    }
+};
+
+// 検討の表示用の評価値：読み切りは石差（勝敗だけなら W/L/D）、それ以外は石数に直して小数 1 桁
+std::string analysisScoreText(const MoveAnalysis& a) {
+    char buf[16];
+    if (a.solved == SOLVE_WLD) return a.score > 0 ? "W" : a.score < 0 ? "L" : "D";
+    if (a.solved == SOLVE_EXACT) std::snprintf(buf, sizeof(buf), "%+d", a.score > 0 ? a.score - SCORE_WIN : a.score < 0 ? a.score + SCORE_WIN : 0);
+    else std::snprintf(buf, sizeof(buf), "%+.1f", (double)a.score / PATTERN_DISC_SCALE);
+    return buf;
+}
+
+// 検討の重ね描き。候補手ごとに、最善との差で色を付けた円（最善は緑、悪いほど赤）と評価値・深さの文字を出す。
+// 結果が更新されたときだけ作り直し、文字は評価値か深さが変わったマスだけ書き換える。フォントがなければ円だけ
+struct AnalysisOverlay {
+    sf::VertexArray marks{sf::PrimitiveType::Triangles};
+    const sf::Font* font = nullptr;
+    std::unique_ptr<sf::Text> label[N*N];
+    std::string labelText[N*N];
+    uint64_t shown = 0; // 文字を出しているマス
+
+    void clear() { marks.clear(); shown = 0; }
+
+    void update(const UI& ui, const std::vector<MoveAnalysis>& moves) {
+        marks.clear();
+        uint64_t now = 0;
+        int best = moves.empty() || moves[0].depth == 0 ? 0 : moves[0].score;
+        for (const MoveAnalysis& a : moves) {
+            if (a.depth == 0) continue;
+            sf::Vector2f tl = ui.cellTopLeft(a.sq / N, a.sq % N);
+            // 最善との差（石 8 個ぶんで真っ赤）
+            float loss = std::min(1.f, (float)std::min(best - a.score, 8 * PATTERN_DISC_SCALE) / (8 * PATTERN_DISC_SCALE));
+            sf::Color col = a.score == best ? sf::Color(40, 200, 90, 200)
+                                            : sf::Color((uint8_t)(120 + 135 * loss), (uint8_t)(200 * (1 - loss)), 60, 170);
+            appendCircle(marks, {tl.x + ui.CELL/2.f, tl.y + ui.CELL/2.f}, ui.CELL*0.36f, col, 24);
+            if (!font) continue;
+            std::string text = analysisScoreText(a) + "\n" + (a.solved ? "end" : "d" + std::to_string(a.depth));
+            now |= bitOf(a.sq);
+            if (label[a.sq] && labelText[a.sq] == text) continue;
+            if (!label[a.sq]) {
+                label[a.sq].reset(new sf::Text(*font, "", (unsigned)(ui.CELL / 5)));
+                label[a.sq]->setFillColor(sf::Color::White);
+                label[a.sq]->setOutlineColor(sf::Color::Black);
+                label[a.sq]->setOutlineThickness(1.5f);
+            }
+            labelText[a.sq] = text;
+            label[a.sq]->setString(text);
+            sf::FloatRect r = label[a.sq]->getLocalBounds();
+            label[a.sq]->setOrigin(sf::Vector2f(r.position.x + r.size.x / 2, r.position.y + r.size.y / 2));
+            label[a.sq]->setPosition(sf::Vector2f(tl.x + ui.CELL/2.f, tl.y + ui.CELL/2.f));
+        }
+        shown = now;
+    }
+
+    // 発行した draw の回数を返す
+    int draw(sf::RenderWindow& win) const {
+        win.draw(marks);
+        int n = 1;
+        for (uint64_t m = shown; m; m &= m - 1, ++n) win.draw(*label[lsb64(m)]);
+        return n;
+    }
+};
+
+// 検討中のタイトル（最善手と評価値・深さ）
+std::string analysisTitle(const std::vector<MoveAnalysis>& moves, char turn) {
+    std::string t = std::string("Analysis - ") + (turn == BLACK ? "Black" : "White") + " to move";
+    if (!moves.empty() && moves[0].depth > 0)
+        t += ", best " + squareName(moves[0].sq) + " " + analysisScoreText(moves[0]) + " depth " + std::to_string(moves[0].depth);
+    return t;
+}
+
+int main(int argc, char** argv) {
+    // --time <ms> / --nodes <n> / --depth <d> でAIの持ち時間、--hash <MB> で置換表サイズ、--threads <n> で探索スレッド数、
+    // --exact <n> / --wld <n> で終盤読み切りを始める空きマス数、--ponder 0 で先読みを止める、--book <file> で定石ファイル、
+    // --weights <file> で評価の重み、--sel <0〜5> で ProbCut の選択度（予測式は reversi.probcut があれば使う）、--stats で終局ごとに探索の計測を表示、--stats-json <file> で 1局ごとに JSON を書き出す
+    // （2局目からは file-2.json, file-3.json, ...。計測は -DREVERSI_STATS でビルドしたときだけ数える）
+    // （探索は描画と別スレッドなので、持ち時間を長くしても画面は固まらない）
+    // --font <ttf> で検討モードの文字のフォント（既定は OS の標準フォントを探す）、--analysis-threads <n> で検討に使うスレッド数（1本ごとに置換表 24MB）
+    // キー: A 検討モードの入り切り / ← か U で 1手戻す（対局中は自分の手番まで）/ → か Y で戻した手を進める / R で初期局面
+    ai.limits.timeMs = 1000;
+    std::string bookFile = "reversi.book", weightsFile = "reversi.weights", statsJsonFile, fontFile;
+    bool showStats = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--stats") { showStats = true; continue; }
+        if (i + 1 >= argc) break;
+        if (a == "--time")       ai.limits.timeMs = std::atoi(argv[++i]);
+        else if (a == "--nodes") ai.limits.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--depth") ai.limits.maxDepth = std::atoi(argv[++i]);
+        else if (a == "--hash")  ai.searcher.setHashSize(std::strtoull(argv[++i], nullptr, 10));
+        else if (a == "--exact") ai.limits.exactEmpties = std::atoi(argv[++i]);
+        else if (a == "--wld")   ai.limits.wldEmpties = std::atoi(argv[++i]);
+        else if (a == "--sel")   ai.limits.selectivity = std::atoi(argv[++i]);
+        else if (a == "--threads") ai.limits.threads = std::atoi(argv[++i]);
+        else if (a == "--ponder")  ai.ponderEnabled = std::atoi(argv[++i]) != 0;
+        else if (a == "--book")    bookFile = argv[++i];
+        else if (a == "--weights") weightsFile = argv[++i];
+        else if (a == "--stats-json") statsJsonFile = argv[++i];
+        else if (a == "--font")    fontFile = argv[++i];
+        else if (a == "--analysis-threads") analysis.threads = std::max(1, std::atoi(argv[++i]));
+    }
+    if (patternWeights().load(weightsFile)) std::cout << "Weights: " << weightsFile << "\n";
+    if (probcutParams().load("reversi.probcut")) std::cout << "ProbCut: reversi.probcut\n";
+    if (book.open(bookFile)) {
+        ai.book = &book;
+        std::cout << "Book: " << bookFile << " (" << book.size() << " positions)\n";
+    }
+
+    // 検討モードの文字のフォント
+    sf::Font font;
+    bool hasFont = false;
+    for (const char* path : {fontFile.c_str(), "/System/Library/Fonts/Supplemental/Arial.ttf", "/Library/Fonts/Arial.ttf",
+                             "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", "/usr/share/fonts/TTF/DejaVuSans.ttf",
+                             "C:/Windows/Fonts/arial.ttf"}) {
+        if (*path && font.openFromFile(path)) { hasFont = true; break; }
+    }
+    if (!hasFont) std::cout << "No font found (--font <ttf>): analysis shows colored marks only\n";
+    analysis.limits = ai.limits;
+
+    // 対局の状態（石数・合法手・パスと終局は GameState が着手ごとに更新する）
+    // 戻した手は redo に積み、→ で進め直す。別の手を打ったら捨てる
+    GameState g;
+    std::vector<int> redo;
+    auto playMove = [&](int sq) {
+        if (!redo.empty() && redo.back() == sq) redo.pop_back(); else redo.clear();
+        g.play(sq);
+    };
 
     // 雛形では人対人（両者クリック）で動きます。
     // 白を簡易AIにしたい場合は次のフラグを true にしてください。
@@ -142,169 +253,193 @@ int main() {
     sf::RenderWindow win(sf::VideoMode(sf::Vector2u((unsigned)ui.W, (unsigned)ui.H)), "Reversi (SFML) - Turn: Black");
     win.setFramerateLimit(60);
 
-    // 緑の盤背景
-    sf::RectangleShape boardBg(sf::Vector2f((float)(ui.CELL*N), (float)(ui.CELL*N)));
-    boardBg.setPosition(sf::Vector2f((float)ui.MARGIN, (float)ui.MARGIN));
-    boardBg.setFillColor(sf::Color(0, 120, 0));
-
-    // グリッド線
-    std::vector<sf::RectangleShape> gridLines;
-    for (int i = 0; i <= N; ++i) {
-        sf::RectangleShape h(sf::Vector2f((float)(ui.CELL*N), 2.f));
-        h.setPosition(sf::Vector2f((float)ui.MARGIN, (float)(ui.MARGIN + i*ui.CELL)));
-        h.setFillColor(sf::Color(0, 80, 0));
-        gridLines.push_back(h);
-
-        sf::RectangleShape v(sf::Vector2f(2.f, (float)(ui.CELL*N)));
-        v.setPosition(sf::Vector2f((float)(ui.MARGIN + i*ui.CELL), (float)ui.MARGIN));
-        v.setFillColor(sf::Color(0, 80, 0));
-        gridLines.push_back(v);
-    }
-
-    // 石（円）
-    sf::CircleShape disc((float)(ui.CELL*0.45));
-    disc.setOrigin(sf::Vector2f(disc.getRadius(), disc.getRadius()));
-
-    // 合法手ハイライト（半透明の小さな点）
-    sf::CircleShape hint((float)(ui.CELL*0.15));
-    hint.setOrigin(sf::Vector2f(hint.getRadius(), hint.getRadius()));
-    hint.setFillColor(sf::Color(255, 255, 0, 140));
+    BoardMesh mesh;
+    mesh.buildStatic(ui);
+    AnalysisOverlay overlay;
+    if (hasFont) overlay.font = &font;
+    bool analysisMode = false;
+    uint64_t shownVersion = 0;
+
+    // 思考中インジケータ（上の余白を左右に動く点）
+    sf::CircleShape thinkingDot(5.f);
+    thinkingDot.setOrigin(sf::Vector2f(5.f, 5.f));
+    thinkingDot.setFillColor(sf::Color(255, 200, 0));
+    sf::Clock animClock;
+    int shownDepth = -1;
+
+    // タイトル = 状態表示 + 描画時間（最後に描いたフレームの clear〜draw にかかった時間と draw 回数）
+    std::string status = turnTitle(g.turn()), frameInfo;
+    bool titleDirty = true;
+    auto setStatus = [&](const std::string& s) { status = s; titleDirty = true; };
+    sf::Clock titleClock;
+
+    // 表示中の局面。変わったときだけジオメトリを作り直して描き直す
+    Board shownBoard; char shownTurn = EMPTY; bool shownGameOver = false;
+    int gamesFinished = 0; // --stats-json の通し番号
+    bool needRedraw = true;
 
     while (win.isOpen()) {
-        // イベント処理（SFML3: pollEvent -> optional<Event>）
-        while (true) {
-            auto ev = win.pollEvent();
-            if (!ev) break;
+        // イベント処理（SFML3: waitEvent/pollEvent -> optional<Event>）
+        // AI が考えている間だけ 16ms ごとに起きて結果と表示を確かめ、それ以外はイベントが来るまで眠る
+        // 検討中も 16ms ごとに起きて、結果が更新されていれば描き直す
+        // （最後の作業スレッドが前のフレームの後に終わったときも、まだ描いていない結果を描くまでは眠らない）
+        bool aiTurn = !g.over() && aiWhite && !analysisMode && g.turn() == WHITE;
+        bool polling = aiTurn || (analysisMode && (analysis.active() || analysis.version() != shownVersion));
+        for (auto ev = polling ? win.waitEvent(sf::milliseconds(16)) : win.waitEvent(); ev; ev = win.pollEvent()) {
             auto &e = *ev;
 
             if (e.is<sf::Event::Closed>()) {
                 win.close();
                 continue;
             }
+            if (e.is<sf::Event::Resized>() || e.is<sf::Event::FocusGained>()) needRedraw = true;
 
             if (e.is<sf::Event::KeyPressed>()) {
                 if (auto kp = e.getIf<sf::Event::KeyPressed>()) {
                     if (kp->code == sf::Keyboard::Key::R) {
-                        b.assign(N, std::vector<char>(N, EMPTY));
-                        b[3][3] = WHITE; b[4][4] = WHITE;
-                        b[3][4] = BLACK; b[4][3] = BLACK;
-                        turn = BLACK; lastPass = false; gameOver = false;
-                        win.setTitle("Reversi (SFML) - Turn: Black");
+                        ai.newGame();
+                        g.reset();
+                        redo.clear();
+                        setStatus(turnTitle(g.turn()));
                         std::cout << "Reset.\n";
+                    } else if (kp->code == sf::Keyboard::Key::A) {
+                        analysisMode = !analysisMode;
+                        ai.cancel();
+                        if (!analysisMode) { analysis.stop(); overlay.clear(); setStatus(turnTitle(g.turn())); }
+                        shownTurn = EMPTY; // 局面が変わったときと同じく作り直す（検討の開始も）
+                        std::cout << "Analysis mode " << (analysisMode ? "on" : "off") << "\n";
+                    } else if (kp->code == sf::Keyboard::Key::Left || kp->code == sf::Keyboard::Key::U) {
+                        // 対局中は自分（黒）の手番まで戻す。検討中は 1手ずつ
+                        ai.cancel();
+                        bool any = false;
+                        while (g.canUndo() && (!any || (!analysisMode && aiWhite && g.turn() != BLACK))) {
+                            redo.push_back(g.lastMove());
+                            g.undo();
+                            any = true;
+                        }
+                        if (any) setStatus(turnTitle(g.turn()));
+                    } else if (kp->code == sf::Keyboard::Key::Right || kp->code == sf::Keyboard::Key::Y) {
+                        if (!redo.empty()) {
+                            ai.cancel();
+                            playMove(redo.back());
+                            setStatus(turnTitle(g.turn()));
+                        }
                     }
                 }
             }
 
-            if (!gameOver && e.is<sf::Event::MouseButtonPressed>()) {
+            if (!g.over() && e.is<sf::Event::MouseButtonPressed>()) {
                 if (auto mb = e.getIf<sf::Event::MouseButtonPressed>()) {
                     if (mb->button != sf::Mouse::Button::Left) continue;
                     int r, c;
                     if (!ui.posToRC(mb->position, r, c)) continue;
 
-                    if (turn == WHITE && aiWhite) {
+                    if (g.turn() == WHITE && aiWhite && !analysisMode) {
                         continue;
                     }
 
-                    if (!isLegal(b, turn, r, c)) {
+                    if (!g.isLegal(sqOf(r, c))) {
                         std::cout << "Illegal move at " << (char)('a'+c) << (r+1) << "\n";
                         continue;
                     }
-
-                    applyMove(b, turn, r, c);
-                    turn = opponent(turn);
-                    win.setTitle(std::string("Reversi (SFML) - Turn: ") + (turn==BLACK ? "Black" : "White"));
-
-                    auto moves = legalMoves(b, turn);
-                    if (moves.empty()) {
-                        if (lastPass) {
-                            gameOver = true;
-                            auto [x,o] = countDiscs(b);
-                            std::string title = "Game Over - X:" + std::to_string(x) + " O:" + std::to_string(o);
-                            win.setTitle(title);
-                            std::cout << title << "\n";
-                        } else {
-                            std::cout << (turn==BLACK ? "Black" : "White") << " has no legal moves -> PASS\n";
-                            lastPass = true;
-                            turn = opponent(turn);
-                            win.setTitle(std::string("Reversi (SFML) - Turn: ") + (turn==BLACK ? "Black" : "White"));
-                        }
-                    } else {
-                        lastPass = false;
-                    }
+                    playMove(sqOf(r, c));
+                    if (g.passed()) std::cout << (g.turn()==BLACK ? "White" : "Black") << " has no legal moves -> PASS\n";
+                    setStatus(turnTitle(g.turn()));
+                    if (g.over() || g.turn() != WHITE) ai.cancel(); // 先読みしていた局面には来ない
                 }
             }
         }
 
-        // AI（白）を動かす場合（フラグON時）
-        if (!gameOver && aiWhite && turn == WHITE) {
-            Move m = chooseMoveAI(b, WHITE);
-            if (m.r == -1 && m.c == -1) {
-                if (lastPass) {
-                    gameOver = true;
-                    auto [x,o] = countDiscs(b);
-                    std::string title = "Game Over - X:" + std::to_string(x) + " O:" + std::to_string(o);
-                    win.setTitle(title);
-                    std::cout << title << "\n";
-                } else {
-                    std::cout << "White (AI) PASS\n";
-                    lastPass = true;
-                    turn = BLACK;
-                    win.setTitle("Reversi (SFML) - Turn: Black");
-                }
+        // AI（白）を動かす場合（フラグON時）。探索を始めたら、終わるまでは描画だけを続ける
+        if (!g.over() && aiWhite && !analysisMode && g.turn() == WHITE) {
+            if (!ai.busy() || ai.pondering()) {
+                ai.start(g.own(), g.opp());
+                shownDepth = -1;
+            } else if (ai.ready()) {
+                SearchResult res = ai.get();
+                if (res.bestSq >= 0 && ai.lastBookHit())
+                    std::cout << "AI book: " << squareName(res.bestSq) << " (" << scoreText(res.score) << ")\n";
+                else if (res.bestSq >= 0)
+                    std::cout << "AI search: " << res.summary() << (ai.lastPonderHit() ? " (ponder hit)" : "")
+                              << " " << ai.searcher.tt.stats().summary() << "\n";
+                // 白の手番では必ず合法手がある（打てなければ GameState がパスを挟んでいる）
+                playMove(res.bestSq);
+                std::cout << "White (AI) move: " << squareName(res.bestSq) << "\n";
+                if (g.passed()) std::cout << "Black has no legal moves -> PASS\n";
+                setStatus(turnTitle(g.turn()));
+                // 人間が考えている間に予想手の先を読んでおく
+                if (!g.over() && g.turn() == BLACK && !analysisMode) ai.ponder(g.own(), g.opp());
             } else {
-                applyMove(b, WHITE, m.r, m.c);
-                std::cout << "White (AI) move: " << (char)('a'+m.c) << (m.r+1) << "\n";
-                turn = BLACK;
-                lastPass = false;
-                win.setTitle("Reversi (SFML) - Turn: Black");
+                SearchResult p = ai.progress();
+                if (p.depth != shownDepth) { shownDepth = p.depth; setStatus(thinkingTitle(p)); }
             }
         }
 
-        // 盤が埋まったら終了
-        auto [x,o] = countDiscs(b);
-        if (!gameOver && x + o == N*N) {
-            gameOver = true;
-            std::string title = "Game Over - X:" + std::to_string(x) + " O:" + std::to_string(o);
-            win.setTitle(title);
-            std::cout << title << "\n";
+        // 局面が変わったときだけ：終局の表示と、石・合法手のジオメトリの作り直し
+        if (g.board() != shownBoard || g.turn() != shownTurn || g.over() != shownGameOver) {
+            if (g.over() && !shownGameOver) {
+                std::string title = "Game Over - X:" + std::to_string(g.discs(BLACK)) + " O:" + std::to_string(g.discs(WHITE));
+                setStatus(title);
+                std::cout << title << "\n";
+                if (showStats || !statsJsonFile.empty()) { // 1局ぶんの計測を出す
+                    ai.cancel();
+                    SearchStats st = ai.searcher.stats();
+                    if (showStats) std::cout << st.summary();
+                    if (!statsJsonFile.empty()) {
+                        std::string path = statsPath(statsJsonFile, ++gamesFinished);
+                        if (!writeStatsJson(path, st)) std::cerr << "cannot write " << path << "\n";
+                    }
+                }
+            }
+            mesh.rebuild(ui, g.board(), analysisMode ? 0 : g.legal(), g.over());
+            shownBoard = g.board(); shownTurn = g.turn(); shownGameOver = g.over();
+            needRedraw = true;
+            if (analysisMode) { // 新しい局面の検討を始める（前の局面の結果は消す）
+                overlay.clear();
+                if (g.over()) analysis.stop(); else analysis.start(g.own(), g.opp());
+                shownVersion = g.over() ? analysis.version() : analysis.version() - 1; // 終局なら描くものはない
+            }
         }
 
-        // --- 描画 ---
-        win.clear(sf::Color(30, 30, 30));
-        win.draw(boardBg);
-        for (auto &line : gridLines) win.draw(line);
-
-        // 石の描画
-        for (int r=0; r<N; ++r) for (int c=0; c<N; ++c) {
-            if (b[r][c] == EMPTY) continue;
-            sf::Vector2f tl = ui.cellTopLeft(r,c);
-            sf::Vector2f center = {tl.x + ui.CELL/2.f, tl.y + ui.CELL/2.f};
-            disc.setPosition(center);
-            if (b[r][c] == BLACK) disc.setFillColor(sf::Color::Black);
-            else disc.setFillColor(sf::Color::White);
-            win.draw(disc);
+        // 検討の結果が更新されていれば重ね描きを作り直す（探索はしない。結果の写しを取るだけ）
+        if (analysisMode && !g.over() && analysis.version() != shownVersion) {
+            shownVersion = analysis.version();
+            std::vector<MoveAnalysis> moves = analysis.snapshot();
+            overlay.update(ui, moves);
+            setStatus(analysisTitle(moves, g.turn()));
+            needRedraw = true;
         }
 
-        // 合法手ハイライト（現在の手番）
-        if (!gameOver) {
-            auto moves = legalMoves(b, turn);
-            for (auto m : moves) {
-                sf::Vector2f tl = ui.cellTopLeft(m.r, m.c);
-                sf::Vector2f center = {tl.x + ui.CELL/2.f, tl.y + ui.CELL/2.f};
-                hint.setPosition(center);
-                win.draw(hint);
+        // --- 描画（変化があったときと、思考中インジケータを動かすときだけ） ---
+        bool thinking = !g.over() && !analysisMode && g.turn() == WHITE && ai.busy() && !ai.pondering();
+        if (needRedraw || thinking) {
+            sf::Clock frameClock;
+            win.clear(sf::Color(30, 30, 30));
+            int draws = mesh.draw(win);
+            if (analysisMode) draws += overlay.draw(win);
+            if (thinking) { // 思考中インジケータ
+                float t = animClock.getElapsedTime().asSeconds() * 4.f;
+                thinkingDot.setPosition(sf::Vector2f(ui.W / 2.f + std::cos(t) * 40.f, ui.MARGIN / 2.f));
+                win.draw(thinkingDot);
+                ++draws;
+            }
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), " | frame %.2fms, %d draws", frameClock.getElapsedTime().asMicroseconds() / 1000.0, draws);
+            win.display();
+            needRedraw = false;
+            // 思考中は毎フレーム描くので、タイトルの更新は 4 回/秒まで
+            if (frameInfo != buf && (!thinking || titleClock.getElapsedTime().asMilliseconds() >= 250)) {
+                frameInfo = buf;
+                titleDirty = true;
             }
         }
-
-        // ゲームオーバー時の半透明オーバーレイ
-        if (gameOver) {
-            sf::RectangleShape overlay(sf::Vector2f((float)ui.W, (float)ui.H));
-            overlay.setFillColor(sf::Color(0,0,0,90));
-            win.draw(overlay);
+        if (titleDirty) {
+            win.setTitle(status + frameInfo);
+            titleClock.restart();
+            titleDirty = false;
         }
-
-        win.display();
     }
 
+    analysis.stop();
     return 0;
 }
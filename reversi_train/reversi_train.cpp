@@ -0,0 +1,332 @@
+// reversi_train.cpp - パターン評価の重みを棋譜から学習するツール
+// 棋譜ファイルを1行ずつ読みながら再生して局面を集め、各局面に正解の値（最終石差または探索の評価値）を付けて、
+// 評価関数（pattern.hpp）の重み表を正則化つき最小二乗法で当てはめ、重みファイルに書き出す。
+// 書き出した重みは reversi / reversi_sfml / reversi_arena / reversi_book が起動時に --weights で読む。
+//
+// 当てはめは全局面ぶんの誤差を全スレッドで分担して集計し、重みごとに
+//   w += lr * (Σ誤差 - l2 * w) / (出現回数 + l2)
+// で更新する（重みごとの対角ニュートン法。出現の少ない配置ほど 0 に引き寄せられる）。
+// 局面は 24 バイトで持ち、パターンの index は毎回作り直すので、数千万局面でもメモリは 1GB 程度。
+//
+// ビルド: clang++ -std=c++17 -O2 -pthread reversi_train.cpp -o reversi_train
+// 例:     ./reversi_train --games games.txt --epochs 30 --out reversi.weights
+//         ./reversi_train --games games.txt --weights reversi.weights --label search --depth 6 --out reversi2.weights
+//         （games.txt は 1行1局の "棋譜 [黒石差]"。reversi_arena --out の出力もこの形式）
+//
+// オプション:
+//   --games <file>        棋譜ファイル（複数指定可）
+//   --label final|search  正解の値。final は最終石差（既定）、search は --depth の探索の評価値
+//                         （search の評価値は --weights で読んだ重みの単位なので、先に final で学習した重みを使う）
+//   --depth <d>           search のときの探索の深さ（空きがこれ以下の局面は読み切る。既定 6）
+//   --weights <file>      search のときに探索で使う重み
+//   --min-empties <n> / --max-empties <n>   学習に使う局面の空きマス数の範囲（既定 1〜59）
+//   --holdout <n>         n 局に 1 局を検証用にして学習に使わない（既定 20。0 で全局を学習に使う）
+//   --epochs <n>          反復回数（既定 30）
+//   --lr <x>              学習率（既定 0.02。大きすぎると発散する）
+//   --l2 <x>              正則化の強さ（既定 4）
+//   --threads <n>         スレッド数（既定はコア数）
+//   --out <file>          書き出す重みファイル（既定 reversi.weights）
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../reversi_core/batch_eval.hpp"
+#include "../reversi_core/bitboard.hpp"
+#include "../reversi_core/pattern.hpp"
+#include "../reversi_core/search.hpp"
+using namespace std;
+
+struct Sample {
+    uint64_t P, O;  // 手番側・相手側
+    float target;   // 手番側から見た正解の値（石差）
+};
+
+struct Options {
+    vector<string> games;
+    bool searchLabel = false;
+    int depth = 6;
+    string weightsFile;
+    int minEmpties = 1, maxEmpties = 59;
+    int holdout = 20, epochs = 30;
+    double lr = 0.02, l2 = 4;
+    int threads = (int)max(1u, thread::hardware_concurrency());
+    string out = "reversi.weights";
+};
+
+// 棋譜を最後まで再生して、打つ前の局面（パスの局面は除く）を out に足す。
+// 終局まで書かれていなければ、行末の黒石差を使う（なければ捨てる）
+bool replayGame(const string& line, const Options& opt, vector<Sample>& out) {
+    size_t sp = line.find(' ');
+    string moves = line.substr(0, sp);
+    if (moves.empty() || moves[0] == '#') return false;
+    uint64_t P = initialBoard().black, O = initialBoard().white;
+    bool blackToMove = true;
+    size_t first = out.size();
+    vector<bool> black;
+    for (size_t i = 0; i + 1 < moves.size(); i += 2) {
+        if (!movesBits(P, O)) {
+            if (!movesBits(O, P)) break;
+            swap(P, O);
+            blackToMove = !blackToMove;
+        }
+        int c = tolower((unsigned char)moves[i]) - 'a', r = moves[i+1] - '1';
+        if (!inBounds(r, c) || !(movesBits(P, O) & bitOf(sqOf(r, c)))) { out.resize(first); return false; }
+        int empties = N*N - popcount64(P | O);
+        if (empties >= opt.minEmpties && empties <= opt.maxEmpties) {
+            out.push_back({P, O, 0});
+            black.push_back(blackToMove);
+        }
+        int sq = sqOf(r, c);
+        uint64_t f = flipsBits(P, O, sq);
+        uint64_t nP = O ^ f, nO = P | f | bitOf(sq);
+        P = nP; O = nO;
+        blackToMove = !blackToMove;
+    }
+    int blackDiff;
+    if (!movesBits(P, O) && !movesBits(O, P)) {
+        int d = finalDiff(P, O);
+        blackDiff = blackToMove ? d : -d;
+    } else if (sp != string::npos) {
+        blackDiff = atoi(line.c_str() + sp + 1);
+    } else {
+        out.resize(first);
+        return false;
+    }
+    for (size_t i = first; i < out.size(); ++i) out[i].target = black[i - first] ? blackDiff : -blackDiff;
+    return true;
+}
+
+// 探索の評価値を正解にする（局面ごとに独立なので、スレッドごとに Searcher を持って分担する）
+void labelBySearch(vector<Sample>& samples, const Options& opt) {
+    atomic<size_t> next{0};
+    vector<thread> pool;
+    auto t0 = chrono::steady_clock::now();
+    for (int t = 0; t < opt.threads; ++t) {
+        pool.emplace_back([&]() {
+            Searcher s;
+            s.limits.timeMs = 0;
+            s.limits.maxDepth = opt.depth;
+            s.limits.exactEmpties = s.limits.wldEmpties = opt.depth;
+            s.setHashSize(4);
+            const size_t CHUNK = 256;
+            for (size_t begin; (begin = next.fetch_add(CHUNK)) < samples.size();) {
+                for (size_t i = begin; i < min(samples.size(), begin + CHUNK); ++i) {
+                    SearchResult r = s.search(samples[i].P, samples[i].O);
+                    samples[i].target = isMateScore(r.score) ? (float)(r.score > 0 ? r.score - SCORE_WIN : r.score + SCORE_WIN)
+                                                             : (float)r.score / PATTERN_DISC_SCALE;
+                }
+            }
+        });
+    }
+    for (thread& t : pool) t.join();
+    printf("labelled %zu positions by depth-%d search in %.1fs\n", samples.size(), opt.depth,
+           chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+}
+
+// 学習中の重み（実数）。ファイルに書くときに int16 に丸める
+struct Model {
+    int T;                   // 1 段階ぶんの表の大きさ
+    vector<double> table;    // [phase * T + shapeOffset + index]
+    double mobility[PATTERN_PHASES] = {}, parity[PATTERN_PHASES] = {};
+
+    Model() : T(patternLayout().shapeOffset[PATTERN_SHAPE_COUNT]), table((size_t)PATTERN_PHASES * T, 0.0) {}
+
+    // 予測値（評価値の単位）。feat には 46 個の重みの位置を入れて返す
+    double predict(const PatternFeatures& x, uint32_t* feat) const {
+        const PatternLayout& L = patternLayout();
+        int phase = x.phase();
+        double s = mobility[phase] * x.mob + parity[phase] * (x.empties & 1);
+        size_t base = (size_t)phase * T;
+        for (int f = 0; f < PATTERN_FEATURES; ++f) {
+            feat[f] = (uint32_t)(base + L.featureOffset[f] + x.idx[f]);
+            s += table[feat[f]];
+        }
+        return s;
+    }
+
+    PatternWeights toWeights() const {
+        PatternWeights w;
+        auto round16 = [](double v) { return (int16_t)max(-32767.0, min(32767.0, std::round(v))); };
+        for (size_t i = 0; i < table.size(); ++i) w.table[i] = round16(table[i]);
+        for (int ph = 0; ph < PATTERN_PHASES; ++ph) { w.mobility[ph] = round16(mobility[ph]); w.parity[ph] = round16(parity[ph]); }
+        return w;
+    }
+};
+
+// スレッドごとの誤差の集計
+struct Gradient {
+    vector<double> table;
+    vector<uint32_t> count;
+    double mob[PATTERN_PHASES], mobSq[PATTERN_PHASES], par[PATTERN_PHASES], parCount[PATTERN_PHASES];
+    double sqErr = 0;
+
+    explicit Gradient(size_t size) : table(size, 0.0), count(size, 0) { clearScalars(); }
+    void clearScalars() {
+        for (int ph = 0; ph < PATTERN_PHASES; ++ph) mob[ph] = mobSq[ph] = par[ph] = parCount[ph] = 0;
+        sqErr = 0;
+    }
+};
+
+// samples[begin, end) の特徴をまとめて作り（batch_eval.hpp）、1 局面ずつ fn(i, 特徴) を呼ぶ
+template <class Fn>
+void forEachFeatures(const vector<Sample>& samples, size_t begin, size_t end, Fn fn) {
+    uint64_t P[BATCH_BLOCK], O[BATCH_BLOCK];
+    PatternFeatures x[BATCH_BLOCK];
+    for (size_t b = begin; b < end; b += BATCH_BLOCK) {
+        size_t len = min(BATCH_BLOCK, end - b);
+        for (size_t k = 0; k < len; ++k) { P[k] = samples[b + k].P; O[k] = samples[b + k].O; }
+        patternFeaturesBatch(P, O, len, x);
+        for (size_t k = 0; k < len; ++k) fn(b + k, x[k]);
+    }
+}
+
+// samples[begin, end) の誤差を g に集める（countOnly なら各重みの出現回数だけ数える）
+void accumulate(const Model& m, const vector<Sample>& samples, size_t begin, size_t end, Gradient& g, bool countOnly) {
+    uint32_t feat[PATTERN_FEATURES];
+    forEachFeatures(samples, begin, end, [&](size_t i, const PatternFeatures& x) {
+        double pred = m.predict(x, feat);
+        int phase = x.phase(), mob = x.mob, par = x.empties & 1;
+        if (countOnly) {
+            for (int f = 0; f < PATTERN_FEATURES; ++f) ++g.count[feat[f]];
+            g.mobSq[phase] += (double)mob * mob;
+            g.parCount[phase] += par;
+            return;
+        }
+        double err = samples[i].target * PATTERN_DISC_SCALE - pred;
+        for (int f = 0; f < PATTERN_FEATURES; ++f) g.table[feat[f]] += err;
+        g.mob[phase] += err * mob;
+        g.par[phase] += err * par;
+        g.sqErr += err * err;
+    });
+}
+
+// 全スレッドで分担して集計し、スレッド 0 の Gradient に足し合わせる
+void parallelAccumulate(const Model& m, const vector<Sample>& samples, vector<Gradient>& grads, bool countOnly) {
+    int nt = (int)grads.size();
+    vector<thread> pool;
+    for (int t = 0; t < nt; ++t) {
+        pool.emplace_back([&, t]() {
+            Gradient& g = grads[t];
+            if (!countOnly) fill(g.table.begin(), g.table.end(), 0.0);
+            g.clearScalars();
+            accumulate(m, samples, samples.size() * t / nt, samples.size() * (t + 1) / nt, g, countOnly);
+        });
+    }
+    for (thread& th : pool) th.join();
+    pool.clear();
+    // 表の足し合わせも範囲で分担する
+    size_t size = grads[0].table.size();
+    for (int t = 0; t < nt; ++t) {
+        pool.emplace_back([&, t]() {
+            for (size_t i = size * t / nt; i < size * (t + 1) / nt; ++i)
+                for (int k = 1; k < nt; ++k) {
+                    if (countOnly) grads[0].count[i] += grads[k].count[i];
+                    else grads[0].table[i] += grads[k].table[i];
+                }
+        });
+    }
+    for (thread& th : pool) th.join();
+    for (int k = 1; k < nt; ++k) {
+        for (int ph = 0; ph < PATTERN_PHASES; ++ph) {
+            grads[0].mob[ph] += grads[k].mob[ph];   grads[0].mobSq[ph] += grads[k].mobSq[ph];
+            grads[0].par[ph] += grads[k].par[ph];   grads[0].parCount[ph] += grads[k].parCount[ph];
+        }
+        grads[0].sqErr += grads[k].sqErr;
+    }
+}
+
+double rmse(const Model& m, const vector<Sample>& samples) {
+    if (samples.empty()) return 0;
+    double s = 0;
+    uint32_t feat[PATTERN_FEATURES];
+    forEachFeatures(samples, 0, samples.size(), [&](size_t i, const PatternFeatures& x) {
+        double e = samples[i].target - m.predict(x, feat) / PATTERN_DISC_SCALE;
+        s += e * e;
+    });
+    return sqrt(s / samples.size());
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string a = argv[i];
+        if (a == "--games")             opt.games.push_back(argv[++i]);
+        else if (a == "--label")        opt.searchLabel = string(argv[++i]) == "search";
+        else if (a == "--depth")        opt.depth = atoi(argv[++i]);
+        else if (a == "--weights")      opt.weightsFile = argv[++i];
+        else if (a == "--min-empties")  opt.minEmpties = atoi(argv[++i]);
+        else if (a == "--max-empties")  opt.maxEmpties = atoi(argv[++i]);
+        else if (a == "--holdout")      opt.holdout = atoi(argv[++i]);
+        else if (a == "--epochs")       opt.epochs = atoi(argv[++i]);
+        else if (a == "--lr")           opt.lr = atof(argv[++i]);
+        else if (a == "--l2")           opt.l2 = atof(argv[++i]);
+        else if (a == "--threads")      opt.threads = max(1, atoi(argv[++i]));
+        else if (a == "--out")          opt.out = argv[++i];
+    }
+    if (opt.games.empty()) { cerr << "--games <file> を指定してください\n"; return 1; }
+    if (!opt.weightsFile.empty() && !patternWeights().load(opt.weightsFile)) {
+        cerr << opt.weightsFile << " を読めません\n";
+        return 1;
+    }
+    if (opt.searchLabel && opt.weightsFile.empty())
+        cerr << "注意: --weights がないので既定の重みで探索します（評価値の単位が石差と合いません）\n";
+
+    // 1) 棋譜を読みながら局面を集める（検証用の対局は別に分ける）
+    auto t0 = chrono::steady_clock::now();
+    vector<Sample> train, test;
+    long games = 0, bad = 0;
+    for (const string& file : opt.games) {
+        ifstream in(file);
+        if (!in) { cerr << file << " を開けません\n"; return 1; }
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            bool toTest = opt.holdout > 0 && games % opt.holdout == opt.holdout - 1;
+            if (replayGame(line, opt, toTest ? test : train)) ++games; else ++bad;
+        }
+    }
+    printf("games: %ld (bad %ld), positions: train %zu / holdout %zu (%.1fs)\n", games, bad, train.size(), test.size(),
+           chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+    if (train.empty()) return 1;
+    if (opt.searchLabel) { labelBySearch(train, opt); labelBySearch(test, opt); }
+
+    // 2) 当てはめ
+    Model model;
+    vector<Gradient> grads;
+    for (int t = 0; t < opt.threads; ++t) grads.emplace_back(model.table.size());
+    parallelAccumulate(model, train, grads, true); // 出現回数は重みによらないので最初に一度だけ
+    vector<uint32_t> count = grads[0].count;
+    double mobSq[PATTERN_PHASES], parCount[PATTERN_PHASES];
+    for (int ph = 0; ph < PATTERN_PHASES; ++ph) { mobSq[ph] = grads[0].mobSq[ph]; parCount[ph] = grads[0].parCount[ph]; }
+    for (Gradient& g : grads) vector<uint32_t>().swap(g.count);
+    size_t used = count_if(count.begin(), count.end(), [](uint32_t c) { return c > 0; });
+    printf("weights seen: %zu / %zu\n", used, count.size());
+
+    auto t1 = chrono::steady_clock::now();
+    for (int epoch = 1; epoch <= opt.epochs; ++epoch) {
+        parallelAccumulate(model, train, grads, false);
+        Gradient& g = grads[0];
+        for (size_t i = 0; i < model.table.size(); ++i)
+            if (count[i]) model.table[i] += opt.lr * (g.table[i] - opt.l2 * model.table[i]) / (count[i] + opt.l2);
+        for (int ph = 0; ph < PATTERN_PHASES; ++ph) {
+            if (mobSq[ph] > 0)   model.mobility[ph] += opt.lr * g.mob[ph] / mobSq[ph];
+            if (parCount[ph] > 0) model.parity[ph] += opt.lr * g.par[ph] / parCount[ph];
+        }
+        double trainRmse = sqrt(g.sqErr / train.size()) / PATTERN_DISC_SCALE;
+        if (epoch == 1 || epoch == opt.epochs || epoch % 5 == 0)
+            printf("epoch %3d: train rmse %.2f  holdout rmse %.2f discs (%.1fs)\n", epoch, trainRmse, rmse(model, test),
+                   chrono::duration<double>(chrono::steady_clock::now() - t1).count());
+    }
+
+    PatternWeights w = model.toWeights();
+    if (!w.save(opt.out)) { cerr << opt.out << " に書き込めません\n"; return 1; }
+    printf("wrote %s (%.1fs total)\n", opt.out.c_str(), chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+    return 0;
+}
@@ -0,0 +1,304 @@
+// mnk.hpp - 一般化した m,n,k 目並べ（縦 m × 横 n の盤で k 個並べたら勝ち。15×15, k=5 の五目並べなど）
+// 石はビットボード（行ごとに1列の番兵を挟んで、シフトしても隣の行に回り込まない）で持ち、
+// 勝ち判定と評価は「長さ k の窓」ごとの石数を差分更新する。
+// 1手打つと、そのマスを通る窓（最大 4k 個）だけを更新するので盤全体は走査しない。
+//
+// AI は反復深化 αβ。候補手は既存の石から距離2以内に限り、
+// 脅威（あと1手で並ぶ・あと2手で二重の脅威になる）があるときは受けと攻めの手だけに絞る。
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace mnk {
+
+static const int MAX_SIDE = 19;
+static const int WORDS = 6;        // (19+1) × 19 = 380 ビット
+static const int SCORE_WIN = 1000000000;
+
+// 盤面サイズのビット集合
+struct Bits {
+    uint64_t w[WORDS] = {};
+
+    bool test(int i) const { return (w[i >> 6] >> (i & 63)) & 1; }
+    void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+    void reset(int i) { w[i >> 6] &= ~(1ULL << (i & 63)); }
+    bool any() const { for (uint64_t x : w) if (x) return true; return false; }
+
+    Bits operator|(const Bits& o) const { Bits r; for (int i = 0; i < WORDS; ++i) r.w[i] = w[i] | o.w[i]; return r; }
+    Bits operator&(const Bits& o) const { Bits r; for (int i = 0; i < WORDS; ++i) r.w[i] = w[i] & o.w[i]; return r; }
+    Bits andNot(const Bits& o) const { Bits r; for (int i = 0; i < WORDS; ++i) r.w[i] = w[i] & ~o.w[i]; return r; }
+
+    // s > 0 なら上位（インデックスの大きい方）へ、s < 0 なら下位へずらす
+    Bits shifted(int s) const {
+        Bits r;
+        int q = (s < 0 ? -s : s) >> 6, b = (s < 0 ? -s : s) & 63;
+        for (int i = 0; i < WORDS; ++i) {
+            if (s >= 0) {
+                int j = i - q;
+                if (j < 0) continue;
+                r.w[i] = w[j] << b;
+                if (b && j > 0) r.w[i] |= w[j-1] >> (64 - b);
+            } else {
+                int j = i + q;
+                if (j >= WORDS) continue;
+                r.w[i] = w[j] >> b;
+                if (b && j + 1 < WORDS) r.w[i] |= w[j+1] << (64 - b);
+            }
+        }
+        return r;
+    }
+
+    template <class F> void forEach(F f) const {
+        for (int i = 0; i < WORDS; ++i)
+            for (uint64_t x = w[i]; x; x &= x - 1) f(i * 64 + __builtin_ctzll(x));
+    }
+};
+
+class Game {
+public:
+    const int rows, cols, k;
+
+    // rows, cols <= MAX_SIDE, 2 <= k <= max(rows, cols) が前提
+    Game(int m, int n, int kk) : rows(m), cols(n), k(kk), stride(n + 1) {
+        for (int r = 0; r < rows; ++r)
+            for (int c = 0; c < cols; ++c) valid.set(index(r, c));
+        cellWindows.assign(stride * rows, {});
+        static const int DR[4] = {0, 1, 1, 1}, DC[4] = {1, 0, 1, -1};
+        for (int r = 0; r < rows; ++r)
+            for (int c = 0; c < cols; ++c)
+                for (int d = 0; d < 4; ++d) {
+                    int er = r + DR[d] * (k - 1), ec = c + DC[d] * (k - 1);
+                    if (er < 0 || er >= rows || ec < 0 || ec >= cols) continue;
+                    int id = (int)windowCount++;
+                    for (int i = 0; i < k; ++i) cellWindows[index(r + DR[d]*i, c + DC[d]*i)].push_back(id);
+                }
+        count[0].assign(windowCount, 0);
+        count[1].assign(windowCount, 0);
+        weight.assign(k + 1, 0);
+        for (int i = 1; i <= k; ++i) weight[i] = 1LL << std::min(3 * i, 60); // 1つ増えるごとに8倍
+    }
+
+    int index(int r, int c) const { return r * stride + c; }
+    int rowOf(int i) const { return i / stride; }
+    int colOf(int i) const { return i % stride; }
+
+    int toMove() const { return (int)(history.size() & 1); } // 0 = 先手(X), 1 = 後手(O)
+    int moves() const { return (int)history.size(); }
+    int winner() const { return won; }                        // -1: まだ / 0,1: 勝った側
+    bool full() const { return (int)history.size() == rows * cols; }
+    bool over() const { return won >= 0 || full(); }
+    bool empty(int i) const { return valid.test(i) && !stones[0].test(i) && !stones[1].test(i); }
+    int at(int i) const { return stones[0].test(i) ? 0 : stones[1].test(i) ? 1 : -1; }
+
+    // 手番側が i に打つ。そのマスを通る窓だけ更新し、k 個そろったら勝ち
+    void play(int i) {
+        int p = toMove();
+        stones[p].set(i);
+        for (int w : cellWindows[i]) {
+            total -= windowValue(w);
+            if (++count[p][w] == k && won < 0) wonAt = (int)history.size(), won = p;
+            total += windowValue(w);
+        }
+        history.push_back(i);
+    }
+
+    void undo() {
+        int i = history.back();
+        history.pop_back();
+        int p = toMove();
+        if (won >= 0 && wonAt == (int)history.size()) won = -1;
+        for (int w : cellWindows[i]) {
+            total -= windowValue(w);
+            --count[p][w];
+            total += windowValue(w);
+        }
+        stones[p].reset(i);
+    }
+
+    // 手番側から見た評価値（各窓の石数に応じた重みの合計。勝敗の値とは重ならないよう抑える）
+    int64_t evaluate() const {
+        int64_t v = std::max<int64_t>(-SCORE_WIN / 2, std::min<int64_t>(SCORE_WIN / 2, total));
+        return toMove() == 0 ? v : -v;
+    }
+
+    // p が i に打つと k 個そろうか
+    bool winsAt(int p, int i) const {
+        for (int w : cellWindows[i]) if (count[p][w] == k - 1 && count[p ^ 1][w] == 0) return true;
+        return false;
+    }
+    // p が i に打つと、あと1手で並ぶ窓がいくつできるか
+    int threatsAt(int p, int i) const {
+        int n = 0;
+        for (int w : cellWindows[i]) n += count[p][w] == k - 2 && count[p ^ 1][w] == 0;
+        return n;
+    }
+    // 手の並べ替え用：自分の窓を伸ばす価値＋相手の窓をふさぐ価値
+    int64_t moveValue(int p, int i) const {
+        int64_t v = 0;
+        for (int w : cellWindows[i]) {
+            if (count[p ^ 1][w] == 0) v += weight[count[p][w] + 1];
+            if (count[p][w] == 0) v += weight[count[p ^ 1][w] + 1] / 2;
+        }
+        return v;
+    }
+
+    // 既存の石から距離2以内の空きマス（盤が空なら中央）
+    std::vector<int> candidates() const {
+        std::vector<int> out;
+        Bits occ = stones[0] | stones[1];
+        if (!occ.any()) { out.push_back(index(rows / 2, cols / 2)); return out; }
+        Bits near = occ;
+        for (int step = 0; step < 2; ++step) {
+            Bits d = near;
+            for (int s : {1, stride - 1, stride, stride + 1}) d = d | near.shifted(s) | near.shifted(-s);
+            near = d & valid; // 番兵列と盤外を落とす
+        }
+        near.andNot(occ).forEach([&](int i) { out.push_back(i); });
+        return out;
+    }
+
+private:
+    const int stride;
+    Bits valid, stones[2];
+    std::vector<std::vector<int>> cellWindows;
+    size_t windowCount = 0;
+    std::vector<int8_t> count[2];
+    std::vector<int64_t> weight;
+    int64_t total = 0;      // 先手から見た評価値
+    std::vector<int> history;
+    int won = -1, wonAt = -1;
+
+    int64_t windowValue(int w) const {
+        if (count[1][w] == 0) return weight[count[0][w]];
+        if (count[0][w] == 0) return -weight[count[1][w]];
+        return 0;
+    }
+};
+
+struct SearchLimits {
+    int maxDepth = 10;
+    int timeMs = 1000; // 0 なら無制限
+    int beam = 12;     // 脅威がない局面で読む候補手の数
+};
+
+struct SearchResult {
+    int move = -1;
+    int64_t score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+class Searcher {
+public:
+    SearchLimits limits;
+
+    SearchResult search(Game& g) {
+        using Clock = std::chrono::steady_clock;
+        start = Clock::now();
+        nodes = 0;
+        aborted = false;
+        SearchResult res;
+        std::vector<int> root = candidateMoves(g, 0).moves;
+        if (root.empty()) return res;
+        res.move = root[0];
+        for (int depth = 1; depth <= limits.maxDepth && !g.over(); ++depth) {
+            int best = -1;
+            int64_t alpha = -SCORE_WIN - 1;
+            for (int m : root) {
+                g.play(m);
+                int64_t s = g.winner() >= 0 ? SCORE_WIN : -negamax(g, depth - 1, 1, -SCORE_WIN - 1, -alpha);
+                g.undo();
+                if (aborted) break;
+                if (s > alpha) { alpha = s; best = m; }
+            }
+            if (aborted) break;
+            res.move = best;
+            res.score = alpha;
+            res.depth = depth;
+            // 前の反復の最善手から読む
+            std::stable_partition(root.begin(), root.end(), [best](int m) { return m == best; });
+            if (alpha >= SCORE_WIN - 64 || alpha <= -SCORE_WIN + 64) break; // 勝敗が確定
+            if (limits.timeMs > 0 && elapsed() * 1000 > limits.timeMs / 2) break;
+        }
+        res.nodes = nodes;
+        res.seconds = elapsed();
+        return res;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+    uint64_t nodes = 0;
+    bool aborted = false;
+
+    double elapsed() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+    struct Candidates {
+        std::vector<int> moves;
+        bool win = false; // 1手で勝てる（moves はその手だけ）
+        int oppWins = 0;  // 相手が1手で勝てるマスの数
+    };
+
+    // 脅威に応じて候補手を絞る（threat-space）
+    //   自分が1手で勝てる → その手だけ
+    //   相手が1手で勝てる → そこをふさぐ手だけ（2か所以上なら負けが確定）
+    //   相手が1手で二重の脅威を作れる → そこをふさぐ手と、自分が脅威を作る手だけ
+    //   それ以外 → 並べ替えの上位 beam 手（ルートでは全候補）
+    Candidates candidateMoves(const Game& g, int ply) const {
+        Candidates c;
+        int me = g.toMove(), opp = me ^ 1;
+        std::vector<int> all = g.candidates(), defend, attack;
+        for (int i : all) {
+            if (g.winsAt(me, i)) { c.moves = {i}; c.win = true; return c; }
+            if (g.winsAt(opp, i)) { if (c.oppWins++ == 0) c.moves.push_back(i); }
+        }
+        if (c.oppWins) return c;
+
+        std::vector<std::pair<int64_t,int>> scored;
+        for (int i : all) {
+            if (g.threatsAt(opp, i) >= 2) defend.push_back(i);
+            if (g.threatsAt(me, i) >= 1) attack.push_back(i);
+            scored.push_back({g.moveValue(me, i), i});
+        }
+        std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        auto contains = [](const std::vector<int>& v, int i) { return std::find(v.begin(), v.end(), i) != v.end(); };
+        if (!defend.empty()) {
+            for (const auto& s : scored)
+                if (contains(defend, s.second) || contains(attack, s.second)) c.moves.push_back(s.second);
+            return c;
+        }
+        size_t limit = ply == 0 ? scored.size() : (size_t)limits.beam;
+        for (size_t j = 0; j < scored.size() && j < limit; ++j) c.moves.push_back(scored[j].second);
+        return c;
+    }
+
+    int64_t negamax(Game& g, int depth, int ply, int64_t alpha, int64_t beta) {
+        ++nodes;
+        if ((nodes & 1023) == 0 && limits.timeMs > 0 && elapsed() * 1000 >= limits.timeMs) aborted = true;
+        if (aborted) return 0;
+        if (g.full()) return 0;
+
+        Candidates c = candidateMoves(g, ply);
+        if (c.win) return SCORE_WIN - ply;
+        if (c.oppWins >= 2) return -(SCORE_WIN - ply - 1); // 一方しかふさげない
+        if (depth <= 0) return g.evaluate();
+
+        int64_t best = -SCORE_WIN - 1;
+        for (int m : c.moves) {
+            g.play(m);
+            int64_t s = g.winner() >= 0 ? SCORE_WIN - ply : -negamax(g, depth - 1, ply + 1, -beta, -alpha);
+            g.undo();
+            if (aborted) return 0;
+            if (s > best) {
+                best = s;
+                if (s > alpha) { alpha = s; if (alpha >= beta) break; }
+            }
+        }
+        return best;
+    }
+};
+
+} // namespace mnk
@@ -0,0 +1,64 @@
+// mnk_mcts.hpp - m,n,k 目並べを並列モンテカルロ木探索（reversi_core/mcts.hpp）で打つためのアダプタ
+// 展開する手は Game::candidates()（既存の石から距離2以内）に絞り、1手で勝てる手があればそれだけにする。
+// プレイアウトは空きマスから一様に引くランダム打ち（1手で勝てるときだけは必ず勝つ手を打つ）。
+#pragma once
+
+#include <vector>
+#include "../reversi_core/mcts.hpp"
+#include "mnk.hpp"
+
+class MnkMctsGame {
+public:
+    static const int MAX_MOVES = mnk::MAX_SIDE * mnk::MAX_SIDE;
+
+    explicit MnkMctsGame(const mnk::Game& game) : g(game) {}
+
+    int toMove() const { return g.toMove(); }
+    int legalMoves(int* out) const {
+        if (g.over()) return 0;
+        std::vector<int> c = g.candidates();
+        int me = g.toMove();
+        for (int i : c)
+            if (g.winsAt(me, i)) { out[0] = i; return 1; }
+        int n = 0;
+        for (int i : c) out[n++] = i;
+        return n;
+    }
+    void play(int m) { g.play(m); }
+    void undo() { g.undo(); }
+    int outcome() const { return g.winner() < 0 ? 1 : g.winner() == 0 ? 2 : 0; }
+
+    template <class R>
+    int playout(R& rng) {
+        empties.clear();
+        for (int r = 0; r < g.rows; ++r)
+            for (int c = 0; c < g.cols; ++c)
+                if (g.empty(g.index(r, c))) empties.push_back(g.index(r, c));
+        int played = 0;
+        while (!g.over()) {
+            int me = g.toMove(), pick = -1;
+            for (size_t j = 0; j < empties.size() && pick < 0; ++j)
+                if (g.winsAt(me, empties[j])) pick = (int)j;
+            if (pick < 0) pick = (int)(rng() % empties.size());
+            g.play(empties[pick]);
+            empties[pick] = empties.back();
+            empties.pop_back();
+            ++played;
+        }
+        int result = outcome();
+        while (played--) g.undo();
+        return result;
+    }
+
+    bool samePosition(const MnkMctsGame& o) const {
+        if (g.rows != o.g.rows || g.cols != o.g.cols || g.k != o.g.k || g.moves() != o.g.moves()) return false;
+        for (int r = 0; r < g.rows; ++r)
+            for (int c = 0; c < g.cols; ++c)
+                if (g.at(g.index(r, c)) != o.g.at(o.g.index(r, c))) return false;
+        return true;
+    }
+
+private:
+    mnk::Game g;
+    std::vector<int> empties;
+};
@@ -0,0 +1,80 @@
+// solved_table.hpp - 三目並べの完全解析表（コンパイル時に constexpr で作る）
+// 盤面を 3進数 code = Σ cell[i] * 3^i（0:空き, 1:X, 2:O）で表し、
+// 全 3^9 = 19683 通りについて手番側の最善手と評価値を求め、最善手の表（19683 バイト）だけを実行ファイルに残す。
+// 実行時は表を1回引くだけで完全な手を返す（探索はしない）。
+//
+// 手番は石数から決まる（X が先手。X と O が同数なら X の番）。
+// 評価値は手番側から見て 勝ち = 10 + 残り空き数 / 引き分け = 0 / 負け = -(10 + 残り空き数)。
+// 早く勝てる手・長く粘れる手を選ぶ。
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace ttt {
+
+static const int CELLS = 9;
+static const int STATES = 19683; // 3^9
+static const uint8_t NO_MOVE = 0xff;
+
+constexpr int POW3[CELLS] = {1, 3, 9, 27, 81, 243, 729, 2187, 6561};
+constexpr int LINES[8][3] = {
+    {0,1,2},{3,4,5},{6,7,8}, // rows
+    {0,3,6},{1,4,7},{2,5,8}, // cols
+    {0,4,8},{2,4,6}          // diags
+};
+
+struct Table {
+    std::array<int8_t, STATES> value{};  // 手番側から見た評価値（不正な局面は 0）
+    std::array<uint8_t, STATES> best{};  // 最善手 0-8（終局・不正な局面は NO_MOVE）
+};
+
+// 子局面（石が1つ多い）の code は必ず大きいので、code の大きい順に埋めれば再帰はいらない
+constexpr Table solve() {
+    Table t{};
+    for (int code = STATES - 1; code >= 0; --code) {
+        int cell[CELLS] = {}, nx = 0, no = 0;
+        for (int i = 0, c = code; i < CELLS; ++i, c /= 3) {
+            cell[i] = c % 3;
+            nx += cell[i] == 1;
+            no += cell[i] == 2;
+        }
+        t.best[code] = NO_MOVE;
+        if (nx != no && nx != no + 1) continue; // 到達しない局面
+
+        int empties = CELLS - nx - no;
+        bool lost = false; // 直前に打った側が3つ並べている
+        int last = nx == no ? 2 : 1;
+        for (const auto& l : LINES)
+            if (cell[l[0]] == last && cell[l[1]] == last && cell[l[2]] == last) lost = true;
+        if (lost) { t.value[code] = (int8_t)-(10 + empties); continue; }
+        if (empties == 0) continue; // 引き分け
+
+        int me = nx == no ? 1 : 2, bestValue = -100;
+        for (int i = 0; i < CELLS; ++i) {
+            if (cell[i]) continue;
+            int v = -t.value[code + me * POW3[i]];
+            if (v > bestValue) { bestValue = v; t.best[code] = (uint8_t)i; }
+        }
+        t.value[code] = (int8_t)bestValue;
+    }
+    return t;
+}
+
+constexpr Table TABLE = solve();
+// 実行時に引くのは最善手だけ（評価値の表はコンパイル時の計算にだけ使う）
+inline constexpr std::array<uint8_t, STATES> BEST = TABLE.best;
+
+// 盤面（0 / 'X' / 'O' の 9 マス）→ code
+inline int encode(const char board[CELLS]) {
+    int code = 0;
+    for (int i = 0; i < CELLS; ++i) code += (board[i] == 'X' ? 1 : board[i] == 'O' ? 2 : 0) * POW3[i];
+    return code;
+}
+
+// コンパイル時の検算：初期局面は引き分け、中央に打った後も引き分け、隅に打たれて隣の辺に返すと先手の勝ち
+static_assert(TABLE.value[0] == 0, "empty board must be a draw");
+static_assert(TABLE.value[1 * POW3[4]] == 0, "centre opening must be a draw");
+static_assert(TABLE.value[1 * POW3[0] + 2 * POW3[1]] > 0, "adjacent edge reply to a corner opening must lose");
+
+} // namespace ttt
@@ -1,7 +1,13 @@
 #include <iostream>
-#include <vector>
 #include <cstring>
 #include <limits>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include "mnk.hpp"
+#include "mnk_mcts.hpp"
+#include "solved_table.hpp"
 using namespace std;
 
 char board[9];
@@ -33,28 +39,92 @@ bool isFull() {
     return true;
 }
 
-// すごく簡単なAI：勝てる手→ブロック→中央→隅→適当
-int chooseMoveAI(char ai='O', char human='X') {
-    auto canWin = [](char player) -> int {
-        for (int i = 0; i < 9; i++) if (board[i]==0){
-            board[i] = player;
-            bool win = checkWin(player);
-            board[i] = 0;
-            if (win) return i;
+// 完全解析表を引くだけのAI（負けない。勝てる局面では最短で勝つ）
+int chooseMoveAI() {
+    uint8_t move = ttt::BEST[ttt::encode(board)];
+    return move == ttt::NO_MOVE ? -1 : move;
+}
+
+// --- 一般化した m,n,k 目並べ（--mnk 15 15 5 など）---
+void printMnk(const mnk::Game& g) {
+    cout << "\n   ";
+    for (int c = 0; c < g.cols; c++) cout << char('a' + c) << ' ';
+    cout << "\n";
+    for (int r = 0; r < g.rows; r++) {
+        cout << (r + 1 < 10 ? " " : "") << (r + 1) << ' ';
+        for (int c = 0; c < g.cols; c++) {
+            int p = g.at(g.index(r, c));
+            cout << (p == 0 ? 'X' : p == 1 ? 'O' : '.') << ' ';
         }
-        return -1;
-    };
-    int move;
-    if ((move = canWin(ai)) != -1) return move;            // 勝ち
-    if ((move = canWin(human)) != -1) return move;         // ブロック
-    if (board[4]==0) return 4;                             // 中央
-    vector<int> corners = {0,2,6,8};
-    for (int c : corners) if (board[c]==0) return c;       // 隅
-    for (int i = 0; i < 9; i++) if (board[i]==0) return i; // その他
-    return -1;
+        cout << "\n";
+    }
+    cout << "\n";
+}
+
+// "h8" → マス（列 a-s, 行 1-19）。不正なら -1
+int parseMnkMove(const mnk::Game& g, const string& s) {
+    if (s.size() < 2 || !isalpha((unsigned char)s[0])) return -1;
+    int c = tolower(s[0]) - 'a', r = atoi(s.c_str() + 1) - 1;
+    if (r < 0 || r >= g.rows || c < 0 || c >= g.cols) return -1;
+    int i = g.index(r, c);
+    return g.empty(i) ? i : -1;
 }
 
-int main(){
+int playMnk(int rows, int cols, int k, int timeMs, bool useMcts, int threads) {
+    mnk::Game g(rows, cols, k);
+    mnk::Searcher ai;
+    ai.limits.timeMs = timeMs;
+    MctsSearcher<MnkMctsGame> mcts; // 木は手をまたいで使い回す
+    mcts.limits.timeMs = timeMs;
+    mcts.limits.threads = threads;
+    cout << rows << "x" << cols << " で " << k << " 個並べたら勝ち (あなた: X / AI: O)\n";
+    cout << "列の文字と行の番号で入力してください（例: h8）\n";
+    while (!g.over()) {
+        printMnk(g);
+        if (g.toMove() == 0) {
+            string s;
+            cout << "あなたの手番です。入力: ";
+            if (!(cin >> s)) return 0;
+            int i = parseMnkMove(g, s);
+            if (i < 0) { cout << "無効な入力です。\n"; continue; }
+            g.play(i);
+        } else if (useMcts) {
+            MctsResult res = mcts.search(MnkMctsGame(g));
+            g.play(res.move);
+            cout << "AIの手: " << char('a' + g.colOf(res.move)) << (g.rowOf(res.move) + 1) << "  (" << res.summary() << ")\n";
+        } else {
+            mnk::SearchResult res = ai.search(g);
+            g.play(res.move);
+            cout << "AIの手: " << char('a' + g.colOf(res.move)) << (g.rowOf(res.move) + 1)
+                 << "  (depth=" << res.depth << " nodes=" << res.nodes << " time=" << res.seconds << "s)\n";
+        }
+    }
+    printMnk(g);
+    if (g.winner() == 0) cout << "あなたの勝ち！\n";
+    else if (g.winner() == 1) cout << "AIの勝ち...\n";
+    else cout << "引き分け。\n";
+    return 0;
+}
+
+// コマンドライン: --mnk <行数> <列数> <k>（既定は 3 3 3 の三目並べ）/ --time <ms>（m,n,k 版の AI の持ち時間）
+//                 --ai mcts（αβ の代わりにモンテカルロ木探索で打つ。三目並べでも使う）/ --threads <n>（MCTS のスレッド数）
+int main(int argc, char** argv){
+    int rows = 3, cols = 3, k = 3, timeMs = 1000, threads = 1;
+    bool useMcts = false;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--mnk" && i + 3 < argc) { rows = atoi(argv[i+1]); cols = atoi(argv[i+2]); k = atoi(argv[i+3]); i += 3; }
+        else if (a == "--time" && i + 1 < argc) timeMs = atoi(argv[++i]);
+        else if (a == "--ai" && i + 1 < argc) useMcts = string(argv[++i]) == "mcts";
+        else if (a == "--threads" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+    }
+    if (rows < 1 || cols < 1 || rows > mnk::MAX_SIDE || cols > mnk::MAX_SIDE || k < 2 || k > max(rows, cols)) {
+        cout << "盤は 1〜" << mnk::MAX_SIDE << " マス四方、k は 2 以上で盤の辺以下にしてください。\n";
+        return 1;
+    }
+    if (rows != 3 || cols != 3 || k != 3 || useMcts) return playMnk(rows, cols, k, timeMs, useMcts, threads);
+
+    // 三目並べは完全解析表で打つ
     memset(board, 0, sizeof(board));
     cout << "Tic-Tac-Toe (あなた: X / AI: O)\n";
     cout << "番号(1-9)でマスを選んでください。左上=1, 右下=9\n";